@@ -19,12 +19,16 @@
 #include <glm/glm.hpp>
 #include "VtkReader.hpp"
 #include "TreeRenderer.hpp"
+#include "ProgressiveLoader.hpp"
+#include "FramePrefetcher.hpp"
+#include "SequenceArchive.hpp"
 // Nota: Sem <imgui.h> aqui! Mantendo a lógica pura.
 
 struct ClippingBox {
     glm::vec3 min = glm::vec3(-2.0f);
     glm::vec3 max = glm::vec3(2.0f);
     bool enabled = false;
+    bool caps = true; // tampas planas no interior dos vasos cortados
 };
 
 class AnimationController {
@@ -71,30 +75,61 @@ private:
     float timeAccumulator = 0.0f;
     Mode currentMode = Mode2D;
     glm::vec3 lastSelectedMidpoint = glm::vec3(0.0f);
+    // Carregamento progressivo de frames grandes (pré-visualização por lotes)
+    ProgressiveLoader m_loader;
+    size_t m_previewSegments = 0;
+    bool m_previewFull = false;
+    float m_previewMinRadius = 0.0f;
+    float m_previewMaxRadius = 0.0f;
+    // Frames seguintes decodificados em segundo plano
+    FramePrefetcher m_prefetcher{&AnimationController::loadFrameFile};
+    int m_direction = 1; // sentido do último avanço (+1/-1)
+    // Frame pedido pela timeline e ainda não exibido (-1 se nenhum). Pedidos
+    // novos substituem o anterior: só o mais recente é carregado.
+    int m_requestedFrame = -1;
+    // Dataset empacotado (.ats): frames reconstruídos pelas diferenças
+    SequenceArchive m_archive;
+    // Incrementada a cada troca do conteúdo da árvore (frame carregado ou limpo)
+    size_t m_treeVersion = 0;
 
     void loadPlaylist(const std::string& folderName);
-    void loadCurrentFrame(ArterialTree& tree, TreeRenderer& renderer);
-    void refreshDatasets(ArterialTree* tree = nullptr, TreeRenderer* renderer = nullptr);
+    static bool loadFrameFile(const std::string& path, ArterialTree& tree,
+                              const std::atomic<bool>* cancel = nullptr);
+    void loadCurrentFrame(SharedTree& tree, TreeRenderer& renderer);
+    // Reconstrói a malha e restaura a seleção após um frame ser carregado
+    void onFrameLoaded(const ArterialTree& tree, TreeRenderer& renderer);
+    bool startProgressiveLoad(const std::string& path, SharedTree& tree, TreeRenderer& renderer);
+    void pollProgressiveLoad(SharedTree& tree, TreeRenderer& renderer);
+    // Exibe o frame pedido quando ficar pronto (ou, até lá, o pronto mais próximo)
+    void pollFrameRequest(SharedTree& tree, TreeRenderer& renderer);
+    void refreshDatasets(SharedTree* tree = nullptr, TreeRenderer* renderer = nullptr);
 
 public:
     AnimationController();
-    void update(float deltaTime, ArterialTree& tree, TreeRenderer& renderer);
+    void update(float deltaTime, SharedTree& tree, TreeRenderer& renderer);
+    // Há um frame sendo lido em segundo plano (a árvore atual está vazia)
+    bool isLoading() const { return m_loader.isActive(); }
+    // Versão da árvore: estruturas derivadas (ex.: BVH do picking) se atualizam quando muda
+    size_t getTreeVersion() const { return m_treeVersion; }
 
     // Troca de modo
-    void setMode2D(ArterialTree* tree = nullptr, TreeRenderer* renderer = nullptr);
-    void setMode3D(ArterialTree* tree = nullptr, TreeRenderer* renderer = nullptr);
-    void setModeWireframe(ArterialTree* tree = nullptr, TreeRenderer* renderer = nullptr);
+    void setMode2D(SharedTree* tree = nullptr, TreeRenderer* renderer = nullptr);
+    void setMode3D(SharedTree* tree = nullptr, TreeRenderer* renderer = nullptr);
+    void setModeWireframe(SharedTree* tree = nullptr, TreeRenderer* renderer = nullptr);
     Mode getCurrentMode() const { return currentMode; }
 
     // Getters e setters para a UI (MenuController)
     const std::vector<std::string>& getAvailableDatasets() const;
     int getCurrentDatasetIndex() const;
-    void setDatasetIndex(int index, ArterialTree& tree, TreeRenderer& renderer);
+    void setDatasetIndex(int index, SharedTree& tree, TreeRenderer& renderer);
     int getCurrentFrameIndex() const;
     int getTotalFrames() const;
-    void setFrameIndex(int index, ArterialTree& tree, TreeRenderer& renderer);
+    void setFrameIndex(int index, SharedTree& tree);
     bool isPlaying() const;
     void togglePlay();
+    // Decodifica todos os frames da playlist em paralelo ao selecionar o dataset
+    bool isPreloadAll() const { return m_prefetcher.preloadAll(); }
+    void setPreloadAll(bool enabled);
     float& getSpeedMultiplierRef();
 
     // Variáveis de estado visual
@@ -104,6 +139,13 @@ public:
     float lightPos[3] = {10.0f, 10.0f, 10.0f};
     float transparency = 1.0f;
     int lightingMode = 0; // 0=Phong, 1=Gouraud, 2=Flat
+    int renderPath = 0;   // 0=Malha, 1=Instanciada, 2=Impostor (ver RenderPath)
+    bool lodEnabled = true; // Nível de detalhe da malha pelo tamanho na tela
+    int triangleBudget = 0; // Milhares de triângulos por frame (0 = sem limite)
+    int colormap = 0;       // Mapa de cores do raio (ver Colormap)
+    int vertexLayout = 0;   // 0=Completo, 1=Compactado (ver VertexLayout)
+    bool sweptTubes = false; // Tubos contínuos nas junções (caminho de malha)
+    bool optimizeIndexOrder = false; // Índices reordenados para o cache de vértices
     bool showGrid = true;
     bool showGizmo = true;
     bool useOrthographic = false;
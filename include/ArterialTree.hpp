@@ -13,14 +13,20 @@
 
 #pragma once
 
+#include <memory>
 #include <vector>
 #include <string>
+#include <type_traits>
 #include <glm/glm.hpp>
 
 struct ArterialNode
 {
     glm::vec3 position;
 };
+// Os leitores (VtkReader, VtpReader), o cache .atb e a sequência .ats gravam
+// e leem as coordenadas direto no vetor de nós, como floats x, y, z seguidos
+static_assert(sizeof(ArterialNode) == 3 * sizeof(float) && std::is_standard_layout_v<ArterialNode>,
+              "ArterialNode deve conter apenas a posição (3 floats)");
 
 struct ArterialSegment
 {
@@ -35,5 +41,36 @@ struct ArterialTree
     std::vector<ArterialNode> nodes;
     std::vector<ArterialSegment> segments;
 
+    // Metadados da última normalização: posição original = pos / normScale + normCenter
+    glm::vec3 normCenter = glm::vec3(0.0f);
+    float normScale = 1.0f;
+    float normRadiusFix = 1.0f; // correção extra aplicada apenas aos raios
+
+    // Posições e raios como lidos (antes da normalização), bit a bit. O
+    // renderizador envia estes valores, que não mudam entre frames quando só
+    // a normalização muda, e aplica normCenter/normScale/normRadiusFix nos shaders.
+    std::vector<glm::vec3> rawPositions;
+    std::vector<float> rawRadii;
+
     void normalize();
+    // Aplica uma normalização já calculada (ex.: a do cache .atb) às posições
+    // e raios atuais, guardando-os antes em rawPositions/rawRadii
+    void applyNormalization(const glm::vec3 &center, float scale, float radiusFix);
+    // Posição/raio antes da normalização (os atuais se a árvore não foi normalizada)
+    const glm::vec3 &rawPosition(size_t node) const
+    {
+        return rawPositions.size() == nodes.size() ? rawPositions[node] : nodes[node].position;
+    }
+    float rawRadius(size_t segment) const
+    {
+        return rawRadii.size() == segments.size() ? rawRadii[segment] : segments[segment].radius;
+    }
+    // Recalcula o ponto médio de cada segmento a partir das posições atuais
+    void updateMidpoints();
+    // Verifica se todos os índices de segmentos apontam para nós existentes
+    bool hasValidIndices() const;
 };
+
+// Árvore exibida: compartilhada e imutável, para que um frame pronto troque
+// de dono (ou seja reaproveitado) sem cópia
+using SharedTree = std::shared_ptr<const ArterialTree>;
@@ -0,0 +1,117 @@
+/*
+ * Universidade Federal de Ouro Preto - UFOP
+ * Departamento de Computação - DECOM
+ * Disciplina: BCC327 - Computação Gráfica (2025.2)
+ * Professor: Rafael Bonfim
+ * Trabalho Prático: Visualizador de Árvores Arteriais (CCO)
+ * Arquivo: ByteOrder.hpp
+ * Autor: Mateus Honorato
+ * Data: Outubro/2026
+ * Descrição:
+ * Utilitários de ordem de bytes (endianness) compartilhados pelos leitores
+ * de formatos binários (VTK legado BINARY e VTK XML).
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <cstddef>
+#ifdef _MSC_VER
+#include <stdlib.h> // _byteswap_*
+#endif
+
+namespace ByteOrder
+{
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    const bool HOST_BIG_ENDIAN = true;
+#else
+    const bool HOST_BIG_ENDIAN = false;
+#endif
+
+    inline uint32_t swap32(uint32_t v)
+    {
+#if defined(_MSC_VER)
+        return _byteswap_ulong(v);
+#else
+        return __builtin_bswap32(v);
+#endif
+    }
+
+    inline uint64_t swap64(uint64_t v)
+    {
+#if defined(_MSC_VER)
+        return _byteswap_uint64(v);
+#else
+        return __builtin_bswap64(v);
+#endif
+    }
+
+    // Lê um valor de `sizeof(T)` bytes (1, 2, 4 ou 8) sem exigir alinhamento,
+    // trocando os bytes quando a ordem do arquivo difere da do processador
+    template <typename T>
+    inline T load(const char *p, bool bigEndian)
+    {
+        T value;
+        if (bigEndian == HOST_BIG_ENDIAN || sizeof(T) == 1)
+        {
+            std::memcpy(&value, p, sizeof(T));
+            return value;
+        }
+        char bytes[sizeof(T)];
+        for (size_t i = 0; i < sizeof(T); ++i)
+            bytes[i] = p[sizeof(T) - 1 - i];
+        std::memcpy(&value, bytes, sizeof(T));
+        return value;
+    }
+
+    template <>
+    inline uint32_t load<uint32_t>(const char *p, bool bigEndian)
+    {
+        uint32_t v;
+        std::memcpy(&v, p, 4);
+        return bigEndian == HOST_BIG_ENDIAN ? v : swap32(v);
+    }
+
+    template <>
+    inline uint64_t load<uint64_t>(const char *p, bool bigEndian)
+    {
+        uint64_t v;
+        std::memcpy(&v, p, 8);
+        return bigEndian == HOST_BIG_ENDIAN ? v : swap64(v);
+    }
+
+    template <>
+    inline float load<float>(const char *p, bool bigEndian)
+    {
+        uint32_t v = load<uint32_t>(p, bigEndian);
+        float f;
+        std::memcpy(&f, &v, 4);
+        return f;
+    }
+
+    template <>
+    inline double load<double>(const char *p, bool bigEndian)
+    {
+        uint64_t v = load<uint64_t>(p, bigEndian);
+        double d;
+        std::memcpy(&d, &v, 8);
+        return d;
+    }
+
+    // Copia `count` valores de 32 bits para `dst`, trocando os bytes em bloco
+    // quando necessário (o laço é vetorizado pelo compilador)
+    inline void copy32(char *dst, const char *src, size_t count, bool bigEndian)
+    {
+        std::memcpy(dst, src, count * 4);
+        if (bigEndian == HOST_BIG_ENDIAN)
+            return;
+        for (size_t i = 0; i < count; ++i)
+        {
+            uint32_t v;
+            std::memcpy(&v, dst + i * 4, 4);
+            v = swap32(v);
+            std::memcpy(dst + i * 4, &v, 4);
+        }
+    }
+}
@@ -12,12 +12,22 @@
  */
 
 #pragma once
+#include <cstddef>
+#include <cstdint>
 #include <glm/glm.hpp>
 
+struct SegmentSoA;
+
 class ClippingUtils
 {
 public:
     // Implementação do algoritmo de Liang-Barsky para recorte de segmentos
+    // (picking; o desenho é recortado nos shaders com gl_ClipDistance)
     // Retorna true se o segmento (possivelmente recortado) está dentro da caixa
     static bool clipSegment(glm::vec3 &p0, glm::vec3 &p1, const glm::vec3 &boxMin, const glm::vec3 &boxMax);
+    // Versão em lote sobre os segmentos [begin, begin + count) de `segments`:
+    // outInside[i] recebe 1 se o segmento tem algum trecho dentro da caixa
+    // (o mesmo retorno de clipSegment), em pistas de 8 (AVX2) ou 4 (SSE2)
+    static void clipSegments(const glm::vec3 &boxMin, const glm::vec3 &boxMax, const SegmentSoA &segments,
+                             size_t begin, size_t count, uint8_t *outInside);
 };
\ No newline at end of file
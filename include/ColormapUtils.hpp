@@ -0,0 +1,41 @@
+/*
+ * Universidade Federal de Ouro Preto - UFOP
+ * Departamento de Computação - DECOM
+ * Disciplina: BCC327 - Computação Gráfica (2025.2)
+ * Professor: Rafael Bonfim
+ * Trabalho Prático: Visualizador de Árvores Arteriais (CCO)
+ * Arquivo: ColormapUtils.hpp
+ * Autor: Mateus Honorato
+ * Data: Outubro/2026
+ * Descrição:
+ * Declara os mapas de cores embutidos e a geração das tabelas (LUT) usadas
+ * pelos shaders para colorir os escalares dos segmentos.
+ */
+
+#pragma once
+#include <glm/glm.hpp>
+
+// Mapas de cores disponíveis (a ordem é a do menu)
+enum class Colormap
+{
+    Heat = 0,     // azul -> verde -> vermelho (mapa original)
+    Viridis = 1,
+    CoolWarm = 2, // azul -> cinza -> vermelho (divergente)
+    Grayscale = 3
+};
+
+class ColormapUtils
+{
+public:
+    static constexpr int COUNT = 4;
+    // Texels da textura 1D de cada mapa
+    static constexpr int LUT_SIZE = 256;
+
+    // Nome exibido no menu
+    static const char *name(Colormap map);
+    // Cor do mapa em t ∈ [0, 1] (interpolação linear entre as paradas)
+    static glm::vec3 sample(Colormap map, float t);
+    // Preenche `rgb` com LUT_SIZE cores RGB de 8 bits, amostradas nos centros
+    // dos texels (t = i / (LUT_SIZE - 1))
+    static void buildLut(Colormap map, unsigned char *rgb);
+};
@@ -0,0 +1,111 @@
+/*
+ * Universidade Federal de Ouro Preto - UFOP
+ * Departamento de Computação - DECOM
+ * Disciplina: BCC327 - Computação Gráfica (2025.2)
+ * Professor: Rafael Bonfim
+ * Trabalho Prático: Visualizador de Árvores Arteriais (CCO)
+ * Arquivo: Decompressor.hpp
+ * Autor: Mateus Honorato
+ * Data: Outubro/2026
+ * Descrição:
+ * Declara a detecção de entradas gzip (.gz) e zlib e o inflate incremental
+ * usado para lê-las sem manter uma cópia descomprimida inteira em memória.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class Decompressor
+{
+public:
+    enum class Format
+    {
+        None,
+        Gzip,
+        Zlib
+    };
+
+    // Identifica o formato pelos primeiros bytes (assinatura gzip ou cabeçalho zlib)
+    static Format detect(const char *data, size_t size);
+};
+
+// Descompressão incremental de um fluxo gzip (um único membro) ou zlib lido
+// de um buffer já mapeado, que precisa continuar válido enquanto o fluxo for
+// usado. Só a janela de 32 KiB do deflate e um bloco de saída ficam em memória.
+// A cópia de um InflateStream continua a leitura do mesmo ponto, de forma
+// independente do original.
+class InflateStream
+{
+public:
+    // Lê o cabeçalho gzip/zlib de `data`. `filepath` é usado só nas mensagens.
+    bool open(const char *data, size_t size, const std::string &filepath);
+
+    // Descomprime até `max` bytes para `out` e retorna quantos foram gerados
+    // (0 no fim do fluxo ou em erro). Ao chegar ao fim confere CRC32/tamanho
+    // (gzip) ou Adler-32 (zlib); uma divergência é reportada por failed().
+    size_t read(char *out, size_t max);
+
+    bool failed() const { return m_state == State::Error; }
+    // Fim do fluxo alcançado e checksum conferido
+    bool finished() const { return m_state == State::Done; }
+    // Limite superior dos bytes ainda não lidos (pela razão máxima do deflate)
+    size_t sizeBound() const;
+
+private:
+    enum class State
+    {
+        BlockHeader,
+        Stored,
+        Huffman,
+        Trailer,
+        Done,
+        Error
+    };
+
+    // Código de Huffman canônico com tabela direta para códigos de até FAST_BITS bits
+    struct HuffmanTable
+    {
+        static const unsigned FAST_BITS = 10;
+        uint16_t fast[1 << FAST_BITS]; // (símbolo << 4) | comprimento; 0 = código mais longo
+        uint16_t count[16];            // códigos por comprimento
+        uint16_t symbol[288];          // símbolos ordenados por código
+    };
+
+    bool fail(const char *message);
+    void refill();
+    bool bits(unsigned n, uint32_t &out);
+    int decodeSymbol(const HuffmanTable &table);
+    bool buildTable(HuffmanTable &table, const uint8_t *lengths, unsigned count);
+    bool readBlockHeader();
+    bool readDynamicTables();
+    void produce();
+    void checkTrailer();
+
+    std::string m_path;
+    Decompressor::Format m_format = Decompressor::Format::None;
+    const unsigned char *m_in = nullptr;
+    size_t m_inSize = 0;
+    size_t m_inPos = 0;
+    uint64_t m_bitBuffer = 0;
+    unsigned m_bitCount = 0;
+
+    State m_state = State::Error;
+    bool m_lastBlock = false;
+    size_t m_storedLeft = 0;
+    HuffmanTable m_litLen;
+    HuffmanTable m_dist;
+
+    // Janela de saída: os últimos 32 KiB já entregues (referência das cópias
+    // do deflate) seguidos do bloco recém-descomprimido
+    std::vector<unsigned char> m_window;
+    size_t m_outEnd = 0;
+    size_t m_outRead = 0;
+
+    uint32_t m_crc = 0;
+    uint32_t m_adler = 1;
+    uint64_t m_total = 0;
+};
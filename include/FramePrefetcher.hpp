@@ -0,0 +1,102 @@
+/*
+ * Universidade Federal de Ouro Preto - UFOP
+ * Departamento de Computação - DECOM
+ * Disciplina: BCC327 - Computação Gráfica (2025.2)
+ * Professor: Rafael Bonfim
+ * Trabalho Prático: Visualizador de Árvores Arteriais (CCO)
+ * Arquivo: FramePrefetcher.hpp
+ * Autor: Mateus Honorato
+ * Data: Outubro/2026
+ * Descrição:
+ * Declara o pré-carregador de frames: threads de fundo decodificam os
+ * próximos frames da playlist para um anel limitado de árvores prontas.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "ArterialTree.hpp"
+
+class FramePrefetcher
+{
+public:
+    // Função de leitura de um frame (a mesma usada no carregamento síncrono).
+    // Deve retornar false assim que `cancel` for ligado.
+    using LoadFunction = bool (*)(const std::string &, ArterialTree &, const std::atomic<bool> *cancel);
+
+    explicit FramePrefetcher(LoadFunction load, size_t capacity = 8);
+    ~FramePrefetcher();
+    FramePrefetcher(const FramePrefetcher &) = delete;
+    FramePrefetcher &operator=(const FramePrefetcher &) = delete;
+
+    // Troca a playlist, descartando todos os frames prontos
+    void setPlaylist(const std::vector<std::string> &paths);
+
+    // Modo "pré-carregar playlist inteira": todos os frames são decodificados
+    // em paralelo (uma thread por núcleo) e mantidos em memória
+    void setPreloadAll(bool enabled);
+    bool preloadAll() const { return m_preloadAll; }
+
+    // Informa o frame exibido e a direção de avanço (+1/-1). Reproduzindo,
+    // a janela cobre os próximos `capacity` frames nessa direção; parado
+    // (navegação pela timeline), cobre os dois lados do frame atual.
+    void setCursor(int frame, int direction, bool playing);
+    // Pede um frame ainda não exibido (navegação pela timeline): ele passa à
+    // frente de todos e a janela se desloca para os seus vizinhos. Leituras em
+    // andamento de frames que saíram da janela são canceladas.
+    void request(int frame, int direction);
+
+    // Entrega o frame se já estiver pronto, sem cópia: no modo anel o slot
+    // cede a árvore e volta a ficar livre; no modo playlist inteira a árvore
+    // passa a ser compartilhada com o slot, que a mantém para as próximas voltas.
+    bool take(int frame, SharedTree &outTree);
+    // O frame está na janela e ainda não terminou de ser decodificado
+    bool isPending(int frame) const;
+    // Frame pronto mais próximo de `frame` (-1 se nenhum)
+    int nearestReady(int frame) const;
+
+private:
+    enum class SlotState
+    {
+        Empty,
+        Loading,
+        Ready,
+        Failed
+    };
+    struct Slot
+    {
+        int frame = -1;
+        SlotState state = SlotState::Empty;
+        SharedTree tree;
+    };
+
+    void startWorkers();
+    void stopWorkers();
+    void workerLoop();
+    // Monta a lista de frames desejados e cancela leituras que saíram dela
+    void setWindow(int frame, int direction, bool playing, bool includeFrame);
+    // Próximo frame desejado sem slot e um slot livre para ele (sob m_mutex)
+    bool pickWork(int &frame, size_t &slot);
+    int findSlot(int frame) const;
+    bool isWanted(int frame) const;
+
+    LoadFunction m_load;
+    size_t m_capacity;
+    bool m_preloadAll = false;
+    std::vector<std::string> m_paths;
+    std::vector<int> m_wanted; // frames desejados, em ordem de prioridade
+    std::vector<Slot> m_slots;
+    // Sinal de cancelamento da leitura em andamento de cada slot
+    std::unique_ptr<std::atomic<bool>[]> m_cancel;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::vector<std::thread> m_workers;
+    bool m_stop = false;
+};
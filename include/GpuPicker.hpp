@@ -0,0 +1,64 @@
+/*
+ * Universidade Federal de Ouro Preto - UFOP
+ * Departamento de Computação - DECOM
+ * Disciplina: BCC327 - Computação Gráfica (2025.2)
+ * Professor: Rafael Bonfim
+ * Trabalho Prático: Visualizador de Árvores Arteriais (CCO)
+ * Arquivo: GpuPicker.hpp
+ * Autor: Mateus Honorato
+ * Data: Outubro/2026
+ * Descrição:
+ * Declara o picking por buffer de IDs: a cena é desenhada sob demanda num
+ * framebuffer inteiro (R32I) com o segmentID de cada fragmento, e a janela
+ * em torno do clique é lida de volta por um PBO no quadro seguinte.
+ */
+
+#pragma once
+
+#include <glad/glad.h>
+
+class GpuPicker
+{
+public:
+    // Raio (em pixels) da janela lida em torno do clique: linhas finas do
+    // wireframe raramente caem exatamente no pixel clicado
+    static constexpr int PICK_RADIUS = 2;
+    // Valor do fundo (nenhum segmento), o mesmo de "sem seleção"
+    static constexpr int NO_ID = -1;
+
+    GpuPicker() = default;
+    ~GpuPicker();
+    GpuPicker(const GpuPicker &) = delete;
+    GpuPicker &operator=(const GpuPicker &) = delete;
+
+    // Pede a leitura no pixel (x, y) do framebuffer (origem no canto superior esquerdo)
+    void request(int x, int y);
+    // Há um pedido aguardando a passada de IDs
+    bool needsPass() const { return pending; }
+
+    // Prepara o framebuffer de IDs (w x h) e o deixa ligado para os draws da
+    // cena; falso (pedido descartado) se o framebuffer não pôde ser criado
+    bool beginPass(int width, int height);
+    // Copia a janela do clique para o PBO sem esperar a GPU e volta ao framebuffer padrão
+    void endPass();
+    // Verdadeiro uma única vez, quando a leitura terminou: `id` recebe o ID
+    // mais próximo do centro da janela (NO_ID se só há fundo)
+    bool poll(int &id);
+
+private:
+    GLuint fbo = 0;
+    GLuint idBuffer = 0;
+    GLuint depthBuffer = 0;
+    GLuint pbo = 0;
+    GLsync fence = nullptr;
+    int fboWidth = 0, fboHeight = 0;
+
+    bool pending = false;
+    int requestX = 0, requestY = 0;
+    // Janela efetivamente lida (coordenadas do GL, origem embaixo) e o centro nela
+    int readX = 0, readY = 0, readWidth = 0, readHeight = 0;
+    int centerX = 0, centerY = 0;
+
+    void createTargets(int width, int height);
+    void deleteTargets();
+};
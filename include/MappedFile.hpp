@@ -0,0 +1,47 @@
+/*
+ * Universidade Federal de Ouro Preto - UFOP
+ * Departamento de Computação - DECOM
+ * Disciplina: BCC327 - Computação Gráfica (2025.2)
+ * Professor: Rafael Bonfim
+ * Trabalho Prático: Visualizador de Árvores Arteriais (CCO)
+ * Arquivo: MappedFile.hpp
+ * Autor: Mateus Honorato
+ * Data: Outubro/2026
+ * Descrição:
+ * Declara um wrapper RAII para mapear arquivos somente-leitura em memória
+ * (mmap), permitindo que os leitores percorram o conteúdo sem cópias.
+ */
+
+#pragma once
+
+#include <string>
+#include <cstddef>
+#ifdef _WIN32
+#include <vector>
+#endif
+
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    ~MappedFile();
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    // Mapeia o arquivo inteiro. Arquivos vazios são aceitos (size() == 0).
+    bool open(const std::string &filepath);
+    void close();
+
+    const char *data() const { return m_data; }
+    size_t size() const { return m_size; }
+    bool isOpen() const { return m_open; }
+
+private:
+    const char *m_data = nullptr;
+    size_t m_size = 0;
+    bool m_open = false;
+#ifdef _WIN32
+    // Sem mmap POSIX: o conteúdo é lido de uma vez para este buffer
+    std::vector<char> m_buffer;
+#endif
+};
@@ -18,5 +18,5 @@
 class MenuController
 {
 public:
-    void render(AnimationController &animCtrl, ArterialTree &tree, TreeRenderer &renderer, bool hideMainPanel = false);
+    void render(AnimationController &animCtrl, SharedTree &tree, TreeRenderer &renderer, bool hideMainPanel = false);
 };
\ No newline at end of file
@@ -0,0 +1,86 @@
+/*
+ * Universidade Federal de Ouro Preto - UFOP
+ * Departamento de Computação - DECOM
+ * Disciplina: BCC327 - Computação Gráfica (2025.2)
+ * Professor: Rafael Bonfim
+ * Trabalho Prático: Visualizador de Árvores Arteriais (CCO)
+ * Arquivo: ParallelUtils.hpp
+ * Autor: Mateus Honorato
+ * Data: Outubro/2026
+ * Descrição:
+ * Utilitários mínimos de paralelismo (std::thread) para laços sobre
+ * intervalos contíguos e reduções. Intervalos pequenos rodam na própria
+ * thread chamadora, sem custo de criação de threads.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+namespace ParallelUtils
+{
+    // Número de threads a usar: `requested` ou, se 0, todos os núcleos
+    inline unsigned threadCount(unsigned requested = 0)
+    {
+        if (requested > 0)
+            return requested;
+        unsigned hw = std::thread::hardware_concurrency();
+        return hw > 0 ? hw : 1;
+    }
+
+    // Executa fn(task) para cada task em [0, taskCount); a tarefa 0 roda na
+    // thread chamadora
+    template <typename F>
+    void runTasks(size_t taskCount, F &&fn)
+    {
+        std::vector<std::thread> workers;
+        workers.reserve(taskCount > 0 ? taskCount - 1 : 0);
+        for (size_t t = 1; t < taskCount; ++t)
+            workers.emplace_back([&fn, t]()
+                                 { fn(t); });
+        if (taskCount > 0)
+            fn(0);
+        for (auto &w : workers)
+            w.join();
+    }
+
+    // Quantidade de blocos para `count` itens com ao menos `minPerTask` itens cada
+    inline size_t taskCountFor(size_t count, size_t minPerTask, unsigned threads = 0)
+    {
+        size_t byWork = count / std::max<size_t>(minPerTask, 1);
+        return std::max<size_t>(1, std::min<size_t>(threadCount(threads), byWork));
+    }
+
+    // Divide [0, count) em blocos contíguos e chama fn(begin, end) em paralelo
+    template <typename F>
+    void parallelFor(size_t count, size_t minPerTask, F &&fn, unsigned threads = 0)
+    {
+        const size_t tasks = taskCountFor(count, minPerTask, threads);
+        runTasks(tasks, [&](size_t t)
+                 { fn(count * t / tasks, count * (t + 1) / tasks); });
+    }
+
+    // Redução paralela: cada bloco produz um parcial com fn(begin, end) e os
+    // parciais são combinados em ordem com combine(acc, parcial)
+    template <typename T, typename F, typename C>
+    T parallelReduce(size_t count, size_t minPerTask, T identity, F &&fn, C &&combine, unsigned threads = 0)
+    {
+        // Envolve T para que std::vector<bool> não compacte os parciais em bits
+        // (escritas concorrentes no mesmo byte)
+        struct Slot
+        {
+            T value;
+        };
+        const size_t tasks = taskCountFor(count, minPerTask, threads);
+        std::vector<Slot> partials(tasks, Slot{identity});
+        runTasks(tasks, [&](size_t t)
+                 { partials[t].value = fn(count * t / tasks, count * (t + 1) / tasks); });
+        T result = identity;
+        for (const Slot &p : partials)
+            result = combine(result, p.value);
+        return result;
+    }
+}
@@ -13,8 +13,25 @@
 
 #pragma once
 
+#include <cstddef>
 #include <glm/glm.hpp>
 
+struct SegmentSoA;
+
+// Parâmetros de um teste de picking (coordenadas do modelo)
+struct PickQuery
+{
+    glm::vec3 rayOrigin;
+    glm::vec3 rayDir;
+    // Raio de acerto de cada segmento: max(raio * radiusFactor, minRadius)
+    float radiusFactor = 1.0f;
+    float minRadius = 0.0f;
+    // Caixa de corte: segmentos inteiramente fora dela são ignorados
+    bool clipEnabled = false;
+    glm::vec3 clipMin = glm::vec3(0.0f);
+    glm::vec3 clipMax = glm::vec3(0.0f);
+};
+
 namespace PickingUtils
 {
     // Calcula origem e direção do raio (perspectiva e ortográfica)
@@ -33,4 +50,16 @@ namespace PickingUtils
         glm::vec3 segB,
         float segRadius,
         float &outDist);
+
+    // Versão em lote de rayIntersectsSegment sobre os segmentos [begin,
+    // begin + count) de `segments`, com o raio de acerto da consulta (a caixa
+    // de corte não é aplicada): outDist[i] recebe a distância ou -1 se o raio
+    // não atinge o segmento. Mesmo resultado da versão escalar, em pistas de
+    // 8 (AVX2) ou 4 (SSE2) segmentos conforme a CPU.
+    void rayIntersectsSegments(const PickQuery &query, const SegmentSoA &segments,
+                               size_t begin, size_t count, float *outDist);
+
+    // Segmento mais próximo atingido pelo raio (-1 se nenhum) por varredura
+    // linear em lote, com a caixa de corte; empates ficam com o menor índice
+    int pickSegment(const SegmentSoA &segments, const PickQuery &query, float &outDist);
 }
\ No newline at end of file
@@ -0,0 +1,90 @@
+/*
+ * Universidade Federal de Ouro Preto - UFOP
+ * Departamento de Computação - DECOM
+ * Disciplina: BCC327 - Computação Gráfica (2025.2)
+ * Professor: Rafael Bonfim
+ * Trabalho Prático: Visualizador de Árvores Arteriais (CCO)
+ * Arquivo: ProgressiveLoader.hpp
+ * Autor: Mateus Honorato
+ * Data: Outubro/2026
+ * Descrição:
+ * Declara o carregador progressivo: lê um arquivo VTK em uma thread de fundo
+ * com VtkReader::stream e expõe os lotes já decodificados para pré-visualização.
+ * Os lotes são escritos direto na árvore final, dimensionada em onBegin: o
+ * pico de memória é essa árvore (mais as janelas do leitor), sem cópia do
+ * texto nem segunda árvore. A normalização e a gravação do cache também
+ * rodam na thread de fundo, depois de encerrada a pré-visualização.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <glm/glm.hpp>
+#include "ArterialTree.hpp"
+#include "TreeCache.hpp"
+
+class ProgressiveLoader
+{
+public:
+    ProgressiveLoader() = default;
+    ~ProgressiveLoader();
+    ProgressiveLoader(const ProgressiveLoader &) = delete;
+    ProgressiveLoader &operator=(const ProgressiveLoader &) = delete;
+
+    // Inicia a leitura de `filepath` em segundo plano (cancela a anterior)
+    void start(const std::string &filepath);
+    // Interrompe a leitura atual e descarta o resultado
+    void cancel();
+
+    bool isActive() const { return m_thread.joinable(); }
+    bool isFinished() const { return m_finished.load(std::memory_order_acquire); }
+    const std::string &path() const { return m_path; }
+
+    // --- Pré-visualização (thread principal, com a leitura em andamento) ---
+    // Todos os nós foram lidos: previewCenter()/previewScale() são válidos e
+    // partialTree().nodes pode ser lido
+    bool nodesReady() const { return m_nodesReady.load(std::memory_order_acquire); }
+    // Segmentos [0, readySegments()) de partialTree() estão completos (índices e raio)
+    size_t readySegments() const { return m_readySegments.load(std::memory_order_acquire); }
+    // Reserva partialTree() para leitura: false quando a leitura terminou e a
+    // árvore está sendo finalizada em segundo plano (fim da pré-visualização).
+    // Cada true deve ser seguido de endPreview().
+    bool beginPreview();
+    void endPreview() { m_previewMutex.unlock(); }
+    // Valores ainda brutos (não normalizados, sem pontos médios); só entre
+    // beginPreview() e endPreview()
+    const ArterialTree &partialTree() const { return m_tree; }
+    // Centro e escala que ArterialTree::normalize() aplicará às posições
+    glm::vec3 previewCenter() const { return m_center; }
+    float previewScale() const;
+
+    // Após isFinished(): entrega a árvore, já normalizada e gravada no cache
+    // .atb. Retorna false se a leitura falhou. O carregador volta ao estado inativo.
+    bool take(ArterialTree &outTree);
+
+private:
+    class Builder;
+    void run();
+    void reset();
+
+    std::thread m_thread;
+    std::string m_path;
+    ArterialTree m_tree;
+    SourceStamp m_stamp;
+    bool m_hasStamp = false;
+    bool m_success = false;
+    glm::vec3 m_center = glm::vec3(0.0f);
+    glm::vec3 m_minPos = glm::vec3(0.0f);
+    glm::vec3 m_maxPos = glm::vec3(0.0f);
+    std::atomic<bool> m_cancel{false};
+    std::atomic<bool> m_finished{false};
+    std::atomic<bool> m_nodesReady{false};
+    std::atomic<size_t> m_readySegments{0};
+    // Pré-visualização encerrada: a thread de fundo passa a escrever na árvore
+    // inteira. O mutex cobre só a leitura de um lote pela thread principal.
+    std::atomic<bool> m_previewClosed{false};
+    std::mutex m_previewMutex;
+};
@@ -0,0 +1,64 @@
+/*
+ * Universidade Federal de Ouro Preto - UFOP
+ * Departamento de Computação - DECOM
+ * Disciplina: BCC327 - Computação Gráfica (2025.2)
+ * Professor: Rafael Bonfim
+ * Trabalho Prático: Visualizador de Árvores Arteriais (CCO)
+ * Arquivo: SegmentBVH.hpp
+ * Autor: Mateus Honorato
+ * Data: Outubro/2026
+ * Descrição:
+ * Declara a hierarquia de volumes envolventes (BVH) de cápsulas sobre os
+ * segmentos da árvore, usada no picking por raio.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "ArterialTree.hpp"
+#include "PickingUtils.hpp"
+
+// Nó da BVH em profundidade: o filho esquerdo de um nó interno vem logo
+// após ele e `offset` aponta o direito; nas folhas `offset` é o primeiro
+// primitivo e `count` > 0 a quantidade
+struct BVHNode
+{
+    glm::vec3 boundsMin; // caixa dos eixos (extremos dos segmentos, sem raio)
+    uint32_t offset;
+    glm::vec3 boundsMax;
+    uint32_t count;
+    float maxRadius; // maior raio base da subárvore
+};
+
+class SegmentBVH
+{
+public:
+    // Primitivos por folha e caixas da partição SAH (no eixo mais longo)
+    static constexpr uint32_t MAX_LEAF_SIZE = 4;
+    static constexpr int SAH_BINS = 16;
+
+    // Constrói com a heurística de área de superfície (SAH) em caixas
+    void build(const ArterialTree &tree);
+    // Recalcula as caixas com as posições atuais, mantendo a topologia;
+    // reconstrói se o número de segmentos mudou
+    void update(const ArterialTree &tree);
+    // Segmento mais próximo atingido pelo raio (-1 se nenhum) e a distância
+    // ao longo do raio, com o mesmo teste de PickingUtils::rayIntersectsSegment
+    int pick(const ArterialTree &tree, const PickQuery &query, float &outDist) const;
+
+    size_t getSegmentCount() const { return segmentCount; }
+    size_t getNodeCount() const { return nodes.size(); }
+
+private:
+    std::vector<BVHNode> nodes;
+    std::vector<uint32_t> primitives; // índices dos segmentos, na ordem das folhas
+    size_t segmentCount = 0;
+
+    // Caixa e raio de uma folha a partir dos seus primitivos
+    void fitLeaf(const ArterialTree &tree, BVHNode &node) const;
+    // Recalcula todas as caixas, das folhas para a raiz
+    void refit(const ArterialTree &tree);
+};
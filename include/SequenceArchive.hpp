@@ -0,0 +1,68 @@
+/*
+ * Universidade Federal de Ouro Preto - UFOP
+ * Departamento de Computação - DECOM
+ * Disciplina: BCC327 - Computação Gráfica (2025.2)
+ * Professor: Rafael Bonfim
+ * Trabalho Prático: Visualizador de Árvores Arteriais (CCO)
+ * Arquivo: SequenceArchive.hpp
+ * Autor: Mateus Honorato
+ * Data: Outubro/2026
+ * Descrição:
+ * Declara o arquivo de sequência (.ats): todos os passos CCO de um dataset
+ * em um único arquivo, com quadros-chave completos e, entre eles, apenas
+ * as diferenças de cada passo para o anterior.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "ArterialTree.hpp"
+#include "MappedFile.hpp"
+
+class SequenceArchive
+{
+public:
+    // Empacota os frames VTK (.vtk/.vtk.gz, em ordem alfabética) de uma pasta.
+    // Um quadro-chave é gravado a cada `keyframeInterval` frames ou sempre que
+    // a diferença ficaria maior que o próprio frame.
+    static bool pack(const std::string &folderPath, const std::string &outputPath,
+                     unsigned keyframeInterval = 16);
+    // Caminho padrão do pacote: "<pasta>.ats", ao lado da pasta
+    static std::string defaultPath(const std::string &folderPath);
+
+    bool open(const std::string &path);
+    void close();
+    bool isOpen() const { return m_file.isOpen(); }
+    size_t frameCount() const { return m_index.size(); }
+    // Nome do arquivo de origem de cada frame
+    const std::vector<std::string> &frameNames() const { return m_names; }
+
+    // Reconstrói o frame a partir do último reconstruído (avanço sequencial:
+    // só a diferença do passo é aplicada) ou do quadro-chave anterior a ele.
+    // A árvore entregue já vem normalizada, como a de VtkReader::load.
+    bool readFrame(size_t frame, ArterialTree &outTree);
+
+private:
+    struct IndexEntry
+    {
+        uint64_t offset;       // início do registro no arquivo
+        uint64_t size;         // tamanho do registro em bytes
+        uint64_t nodeCount;    // nós do frame reconstruído
+        uint64_t segmentCount; // segmentos do frame reconstruído
+        uint32_t keyframe;     // quadro-chave do qual o frame depende
+        uint32_t reserved;
+    };
+
+    bool decodeKeyframe(size_t frame);
+    bool applyDelta(size_t frame);
+
+    MappedFile m_file;
+    std::string m_path;
+    std::vector<IndexEntry> m_index;
+    std::vector<std::string> m_names;
+    // Último frame reconstruído, em coordenadas originais (sem normalização)
+    ArterialTree m_raw;
+    long long m_rawFrame = -1;
+};
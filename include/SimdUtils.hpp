@@ -0,0 +1,99 @@
+/*
+ * Universidade Federal de Ouro Preto - UFOP
+ * Departamento de Computação - DECOM
+ * Disciplina: BCC327 - Computação Gráfica (2025.2)
+ * Professor: Rafael Bonfim
+ * Trabalho Prático: Visualizador de Árvores Arteriais (CCO)
+ * Arquivo: SimdUtils.hpp
+ * Autor: Mateus Honorato
+ * Data: Outubro/2026
+ * Descrição:
+ * Segmentos em estrutura de arrays (SoA) para os testes em lote de picking
+ * e recorte, e a detecção em tempo de execução das instruções vetoriais
+ * (SSE2 em todo x86-64, AVX2 quando a CPU e o sistema suportam).
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "ArterialTree.hpp"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define SIMD_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+// O MSVC aceita intrínsecos AVX2 sem opções de compilação
+#define SIMD_TARGET_AVX2
+#else
+// Só as funções marcadas são compiladas com AVX2; o restante segue o alvo padrão
+#define SIMD_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#else
+#define SIMD_X86 0
+#endif
+
+// Extremos e raio de cada segmento em arrays separados (um float por pista)
+struct SegmentSoA
+{
+    std::vector<float> ax, ay, az;
+    std::vector<float> bx, by, bz;
+    std::vector<float> radius;
+
+    size_t size() const { return radius.size(); }
+
+    void assign(const ArterialTree &tree)
+    {
+        const size_t n = tree.segments.size();
+        for (std::vector<float> *array : {&ax, &ay, &az, &bx, &by, &bz, &radius})
+            array->resize(n);
+        for (size_t i = 0; i < n; ++i)
+        {
+            const ArterialSegment &seg = tree.segments[i];
+            const glm::vec3 &a = tree.nodes[seg.indexA].position;
+            const glm::vec3 &b = tree.nodes[seg.indexB].position;
+            ax[i] = a.x;
+            ay[i] = a.y;
+            az[i] = a.z;
+            bx[i] = b.x;
+            by[i] = b.y;
+            bz[i] = b.z;
+            radius[i] = seg.radius;
+        }
+    }
+};
+
+namespace SimdUtils
+{
+    // Verdadeiro se a CPU e o sistema operacional suportam AVX2 (consultado uma vez)
+    inline bool hasAVX2()
+    {
+#if SIMD_X86
+        static const bool supported = []()
+        {
+#if defined(_MSC_VER) && !defined(__clang__)
+            int info[4];
+            __cpuid(info, 0);
+            if (info[0] < 7)
+                return false;
+            __cpuid(info, 1);
+            const bool osxsave = (info[2] & (1 << 27)) != 0;
+            const bool avx = (info[2] & (1 << 28)) != 0;
+            // Registradores YMM preservados pelo sistema (XCR0 bits 1 e 2)
+            if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6)
+                return false;
+            __cpuidex(info, 7, 0);
+            return (info[1] & (1 << 5)) != 0;
+#else
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx2") != 0;
+#endif
+        }();
+        return supported;
+#else
+        return false;
+#endif
+    }
+}
@@ -0,0 +1,41 @@
+/*
+ * Universidade Federal de Ouro Preto - UFOP
+ * Departamento de Computação - DECOM
+ * Disciplina: BCC327 - Computação Gráfica (2025.2)
+ * Professor: Rafael Bonfim
+ * Trabalho Prático: Visualizador de Árvores Arteriais (CCO)
+ * Arquivo: TreeCache.hpp
+ * Autor: Mateus Honorato
+ * Data: Outubro/2026
+ * Descrição:
+ * Declara o cache binário de frames (.atb): uma cópia da árvore arterial
+ * (valores brutos e parâmetros da normalização) gravada ao lado do arquivo
+ * de origem, carregada com um único mmap e sem nenhuma conversão de texto.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include "ArterialTree.hpp"
+
+// Identifica a versão do arquivo de origem que gerou um cache
+struct SourceStamp
+{
+    uint64_t size = 0;
+    int64_t mtime = 0; // last_write_time em ticks do relógio do sistema de arquivos
+    uint64_t hash = 0; // impressão digital amostrada do conteúdo
+};
+
+class TreeCache
+{
+public:
+    // Caminho do sidecar: "<arquivo>.atb"
+    static std::string sidecarPath(const std::string &sourcePath);
+    // Calcula tamanho, mtime e hash do arquivo de origem já mapeado
+    static SourceStamp stamp(const std::string &sourcePath, const char *data, size_t size);
+
+    // Falha (sem mensagem) se o cache não existir ou não corresponder a `expected`
+    static bool load(const std::string &cachePath, const SourceStamp &expected, ArterialTree &outTree);
+    static bool save(const std::string &cachePath, const SourceStamp &stamp, const ArterialTree &tree);
+};
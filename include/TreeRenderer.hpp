@@ -13,18 +13,142 @@
 
 #pragma once
 
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <unordered_map>
 #include <vector>
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 #include "VtkReader.hpp"
 #include "Shader.hpp"
+#include "ColormapUtils.hpp"
+#include "TubeUtils.hpp"
 
+// Vértice das malhas de vasos, em valores brutos (antes da normalização da
+// árvore): a posição desenhada é calculada no vertex shader como
+// pos + normal * max(radius * radiusFactor, minRadius), e a normalização
+// entra na matriz `model`. Mudar a escala de raio ou a normalização do frame
+// não exige regerar a geometria. A cor vem do escalar de `segmentID` (ver
+// TreeRenderer::setColormap).
 struct Vertex
 {
-    glm::vec3 pos;
-    glm::vec3 normal;
-    glm::vec3 color;
-    int segmentID;
+    glm::vec3 pos;    // ponto no eixo do cilindro ou centro da esfera
+    glm::vec3 normal; // direção radial unitária
+    int segmentID;    // >= 0: segmento; esferas: -2 - índice do nó
+    float radius;     // raio base bruto (sem normalização nem escala da interface)
+};
+
+// Vértice compactado (16 bytes) do layout VertexLayout::Packed: posição em
+// 16 bits por eixo dentro da caixa de quantização, raio em 16 bits sobre
+// [0, raio máximo], normal octaédrica em 2x16 bits e segmentID com sinal em
+// 24 bits (8 bits reservados). Decodificado em vertex.glsl.
+struct PackedVertex
+{
+    uint16_t pos[3];
+    uint16_t radius;
+    int16_t normal[2];
+    uint32_t segmentID;
+};
+
+// Formato dos vértices das malhas de vasos (trocável em execução para comparação)
+enum class VertexLayout
+{
+    Full = 0,  // Vertex (32 bytes)
+    Packed = 1 // PackedVertex (16 bytes)
+};
+
+// Normalização provisória da árvore ainda não normalizada durante a
+// pré-visualização progressiva (valores brutos de VtkReader::stream), com o
+// mesmo papel de normCenter/normScale/normRadiusFix de ArterialTree
+struct PreviewTransform
+{
+    glm::vec3 center = glm::vec3(0.0f); // posição desenhada = (p - center) * scale
+    float scale = 1.0f;
+    float radiusFix = 1.0f;  // raio desenhado = raio bruto * scale * radiusFix (mais a escala do shader)
+    float minRadius = 0.0f;  // faixa (bruta) do mapa de calor
+    float maxRadius = 1.0f;
+};
+
+// Caminho de desenho dos vasos (cilindros e junções)
+enum class RenderPath
+{
+    Mesh = 0,     // malhas geradas na CPU, um slot por cilindro/esfera
+    Instanced = 1, // malhas unitárias compartilhadas, expandidas no vertex shader
+    Impostor = 2   // caixas envolventes; a superfície exata é traçada no fragment shader
+};
+
+// Instância dos caminhos instanciado e impostor: um segmento (cilindro) ou uma junção
+// (esfera, com a == b). 36 bytes contra ~2,9 KB do cilindro e ~59 KB da
+// esfera gerados na CPU.
+struct VesselInstance
+{
+    glm::vec4 a; // extremo A (xyz) e raio base em A (w), brutos
+    glm::vec4 b; // extremo B (xyz) e raio base em B (w), brutos
+    int segmentID; // mesma convenção de Vertex::segmentID
+};
+
+// Malha unitária compartilhada e buffer de instâncias de um tipo de primitiva
+struct InstanceBuffers
+{
+    GLuint vao = 0, meshVbo = 0, meshEbo = 0, instanceVbo = 0;
+    size_t indexCount = 0;       // índices da malha unitária
+    size_t instanceCount = 0;
+    size_t instanceCapacity = 0; // bytes alocados no buffer de instâncias
+};
+
+// Malha dividida em slots de tamanho fixo: cada cilindro (segmento) ou esfera
+// (nó) ocupa sempre o mesmo intervalo do VBO/EBO. A assinatura de cada slot
+// (parâmetros que geraram a geometria) permite comparar a árvore nova com a
+// já enviada e regravar só os slots que mudaram, com glBufferSubData.
+struct MeshPool
+{
+    GLuint vao = 0, vbo = 0, ebo = 0;
+    bool sphere = false;
+    int level = 0;            // nível de detalhe
+    int resolution = 0;       // lados do cilindro / segmentos da esfera
+    size_t vertsPerSlot = 0;
+    size_t indicesPerSlot = 0;
+    size_t signatureSize = 0; // floats por assinatura
+    size_t slotCount = 0;     // slots enviados (inclui livres no meio)
+    size_t liveCount = 0;     // slots com geometria
+    size_t vertexCapacity = 0; // bytes alocados nos buffers
+    size_t indexCapacity = 0;
+    std::vector<uint64_t> owner;      // chave do dono de cada slot
+    std::vector<uint32_t> generation; // última atualização que usou o slot
+    std::vector<float> signatures;    // signatureSize floats por slot
+    std::vector<uint32_t> freeSlots;
+    std::vector<uint32_t> dirty;      // slots a regravar no próximo envio
+    std::unordered_map<uint64_t, uint32_t> slotOf;
+};
+
+// Ordem dos índices de um slot, relativos ao seu primeiro vértice (todos os
+// slots de um mesmo nível e forma têm a mesma topologia), e o ACMR da ordem
+// gerada e da usada
+struct IndexOrder
+{
+    std::vector<unsigned int> indices;
+    float acmrGenerated = 0.0f;
+    float acmrUsed = 0.0f;
+};
+
+// ACMR (vértices transformados por triângulo) das malhas desenhadas, com a
+// ordem de índices dos geradores e com a ordem enviada
+struct IndexOrderStats
+{
+    float acmrBefore = 0.0f;
+    float acmrAfter = 0.0f;
+    size_t triangles = 0;
+};
+
+// Nível de detalhe de um cilindro (por segmento) ou esfera (por nó), em
+// valores brutos como os vértices
+struct LodItem
+{
+    glm::vec3 center = glm::vec3(0.0f);
+    float radius = -1.0f;    // raio base da primitiva; < 0 = não desenhada
+    float halfLength = 0.0f; // meio comprimento do cilindro (0 na esfera)
+    uint8_t level = 0xFF; // nível usado na última reconstrução (0xFF = nenhum)
 };
 
 struct WireframeRenderBuffers
@@ -36,28 +160,237 @@ struct WireframeRenderBuffers
 
 class TreeRenderer
 {
+public:
+    // Níveis de detalhe do caminho de malha (4/8/16/32 divisões)
+    static constexpr int LOD_LEVELS = 4;
+
+    // Lado das células da grade de blocos, em unidades da árvore normalizada
+    // (que ocupa um cubo de lado 2) quando a grade é fixada
+    static constexpr float CHUNK_SIZE = 0.25f;
+
 private:
-    unsigned int VAO = 0, VBO = 0, EBO = 0;
-    size_t indexCount = 0;
+    // Bloco espacial: uma célula da grade com pools próprios (um por nível de
+    // detalhe; o último tem a resolução completa) e a caixa das primitivas
+    // vivas, testada contra o frustum e a caixa de corte a cada draw()
+    struct MeshChunk
+    {
+        MeshPool cylinderPools[LOD_LEVELS];
+        MeshPool spherePools[LOD_LEVELS];
+        glm::vec3 boundsMin = glm::vec3(0.0f); // pontos dos eixos/centros (brutos)
+        glm::vec3 boundsMax = glm::vec3(0.0f);
+        float maxRadius = 0.0f;                // maior raio de vértice bruto
+        bool hasBounds = false;
+
+        // Inclui o ponto `p` com raio de vértice `radius`; a primeira chamada
+        // após hasBounds = false recomeça a caixa
+        void expand(const glm::vec3 &p, float radius)
+        {
+            boundsMin = hasBounds ? glm::min(boundsMin, p) : p;
+            boundsMax = hasBounds ? glm::max(boundsMax, p) : p;
+            maxRadius = hasBounds ? std::max(maxRadius, radius) : radius;
+            hasBounds = true;
+        }
+    };
+    // Blocos por código de Morton da célula: a iteração segue a curva de Morton
+    std::map<uint32_t, MeshChunk> chunks;
+    // Grade dos blocos em coordenadas brutas, fixada ao criar o primeiro bloco
+    // com a normalização da época: um frame que só muda a normalização não
+    // troca nenhuma primitiva de bloco. Refeita se a escala mudar mais de 2x.
+    glm::vec3 chunkOrigin = glm::vec3(0.0f);
+    float chunkCellSize = CHUNK_SIZE;
+    size_t chunksDrawn = 0; // blocos desenhados no último draw()
+    IndexOrder cylinderOrders[LOD_LEVELS];
+    IndexOrder sphereOrders[LOD_LEVELS];
+    uint32_t meshGeneration = 0;
+    float radiusScale = 1.0f; // escala de raio da interface, aplicada nos shaders
+    // Normalização da árvore desenhada (ArterialTree::normCenter/normScale/
+    // normRadiusFix), aplicada nos shaders sobre os valores brutos dos buffers:
+    // um frame que só muda a normalização não regrava nenhum slot
+    glm::vec3 normCenter = glm::vec3(0.0f);
+    float normScale = 1.0f;
+    float normRadiusFix = 1.0f;
+    // Caixa de corte, aplicada nos shaders (coordenadas da árvore normalizada)
+    bool clipEnabled = false;
+    bool clipCaps = true;
+    glm::vec3 clipMin = glm::vec3(-1000.0f);
+    glm::vec3 clipMax = glm::vec3(1000.0f);
+    // Escalares lidos nos shaders por segmentID (texture buffer RG32F): valor
+    // nos extremos A e B de cada segmento, seguidos de (valor, valor) por nó a
+    // partir de nodeScalarOffset. A cor é a LUT do mapa em (s - min) / (max - min).
+    GLuint scalarBuffer = 0;
+    GLuint scalarTexture = 0;
+    size_t scalarCapacity = 0; // bytes alocados em scalarBuffer
+    std::vector<glm::vec2> scalarData; // cópia do conteúdo de scalarBuffer
+    int nodeScalarOffset = 0;
+    float scalarMin = 0.0f;
+    float scalarMax = 1.0f;
+    Colormap colormap = Colormap::Heat;
+    GLuint colormapTexture = 0;
+    bool colormapDirty = true;
+    // Layout dos vértices e faixa de quantização do layout compactado (só
+    // cresce, com folga: mudá-la obriga a regravar todos os slots)
+    VertexLayout vertexLayout = VertexLayout::Full;
+    bool quantValid = false;
+    glm::vec3 quantMin = glm::vec3(0.0f);
+    glm::vec3 quantMax = glm::vec3(0.0f);
+    float quantRadiusMax = 0.0f;
+    // Tubos contínuos: anéis de junta compartilhados (TubeUtils::sweep) no
+    // lugar das esferas nos nós em que o ramo continua
+    bool sweptTubes = false;
+    // Ordem dos índices otimizada (Tipsify + agrupamentos contra overdraw)
+    bool optimizeIndexOrder = false;
+    // Seleção de LOD: câmera do frame e níveis por segmento/nó
+    bool lodEnabled = true;
+    size_t lodTriangleBudget = 0;
+    bool lodHasCamera = false;
+    bool lodOrthographic = false;
+    glm::mat4 lodModelView = glm::mat4(1.0f); // view * model, sem a normalização
+    float lodPixelScale = 1.0f; // pixels por unidade de raio (a 1 unidade da câmera, na perspectiva)
+    // Os níveis atuais são os que a câmera e as opções acima escolhem: updateLod()
+    // retorna sem varrer os itens até algo mudar (câmera, opções, escala de
+    // raio ou uma nova malha/normalização)
+    bool lodChecked = false;
+    std::vector<LodItem> cylinderLod;
+    std::vector<LodItem> sphereLod;
+    RenderPath renderPath = RenderPath::Mesh;
+    InstanceBuffers cylinderInstances;
+    InstanceBuffers sphereInstances;
 
     WireframeRenderBuffers wireframeBuf;
 
 public:
-    TreeRenderer() = default;
     ~TreeRenderer();
 
-    void init(const ArterialTree &tree, float radiusMultiplier = 1.0f, bool showSpheres = true,
-              bool clipEnabled = false, glm::vec3 clipMin = glm::vec3(-1000.0f), glm::vec3 clipMax = glm::vec3(1000.0f));
+    // Atualiza a malha para a árvore: só cilindros e esferas cujos extremos,
+    // raios, cores ou índice mudaram são regerados; os objetos GL são mantidos
+    void init(const ArterialTree &tree, bool showSpheres = true);
+    // Escala de raio dos vasos: só um uniform no draw(), sem regerar a malha
+    void setRadiusScale(float scale);
+    // Caixa de corte: planos de recorte (gl_ClipDistance) nos shaders, sem
+    // regerar a malha. Com `caps`, o interior dos vasos visto pelo corte é
+    // iluminado como uma tampa plana.
+    void setClipBox(bool enabled, const glm::vec3 &boxMin, const glm::vec3 &boxMax, bool caps);
+    // Mapa de cores dos escalares: troca só a LUT (256 texels), sem regerar a malha
+    void setColormap(Colormap map);
+    // Formato dos vértices do caminho de malha. A troca libera os pools; a
+    // malha é regerada no próximo init().
+    void setVertexLayout(VertexLayout layout);
+    VertexLayout getVertexLayout() const { return vertexLayout; }
+    // Junções do caminho de malha por tubos contínuos (em vez de cilindros
+    // soltos e esferas). Vale a partir do próximo init().
+    void setSweptTubes(bool enabled) { sweptTubes = enabled; }
+    // Reordena os índices de cada slot para o cache de vértices e contra
+    // overdraw, e desenha os cilindros antes das esferas (quase todas
+    // escondidas por eles). A troca libera os pools, como setVertexLayout.
+    void setOptimizeIndexOrder(bool enabled);
+    IndexOrderStats getIndexOrderStats() const;
+    // Blocos espaciais do caminho de malha e quantos passaram no último
+    // teste contra o frustum e a caixa de corte
+    size_t getChunkCount() const { return chunks.size(); }
+    size_t getChunksDrawn() const { return chunksDrawn; }
+    // No caminho instanciado `shader` deve ser o programa de instanced_vertex.glsl;
+    // no impostor, o de impostor_vertex.glsl + impostor_fragment.glsl
     void draw(Shader &shader, const glm::mat4 &view, const glm::mat4 &proj, const glm::mat4 &model, int selectedSegmentID = -1);
 
-    void initWireframe(const std::vector<ArterialNode> &nodes, const std::vector<ArterialSegment> &segments,
-                       bool clipEnabled, glm::vec3 clipMin, glm::vec3 clipMax);
+    // Troca o caminho de desenho, liberando a memória de GPU do anterior.
+    // A malha do novo caminho é montada no próximo init().
+    void setRenderPath(RenderPath path);
+    RenderPath getRenderPath() const { return renderPath; }
+
+    // Nível de detalhe do caminho de malha: cada cilindro/esfera usa 4, 8, 16
+    // ou 32 divisões conforme o raio projetado na tela, com histerese entre
+    // níveis. Com `triangleBudget` > 0 os níveis são reduzidos até o total de
+    // triângulos caber no orçamento. Desligado, tudo usa 32 divisões.
+    void setLodOptions(bool enabled, size_t triangleBudget);
+    // Registra a câmera do frame. Retorna true quando algum nível mudou: a
+    // malha deve ser atualizada com init() (só os slots trocados são regerados).
+    // Sem mudança de câmera, opções ou malha desde a última chamada retorna
+    // false sem varrer os itens.
+    bool updateLod(const glm::mat4 &view, const glm::mat4 &proj, const glm::mat4 &model, int viewportHeight);
+
+    // Pré-visualização progressiva: esvazia a malha e passa a acrescentar
+    // cilindros (sem esferas) conforme lotes de segmentos ficam completos.
+    // init() posterior substitui a pré-visualização pela malha definitiva.
+    // Cada segmento ocupa um slot da mesma malha.
+    void beginProgressive();
+    // Acrescenta os segmentos [first, first + count) da árvore parcial.
+    // Retorna false quando o limite de memória da pré-visualização é atingido.
+    bool appendProgressive(const ArterialTree &partial, size_t first, size_t count, const PreviewTransform &transform);
+
+    void initWireframe(const ArterialTree &tree);
     void drawWireframe(Shader &shader, const glm::mat4 &view, const glm::mat4 &projection, const glm::mat4 &model, float width, int selectedSegmentID = -1);
 
 private:
-    void buildMeshes(const ArterialTree &tree, float radiusMultiplier, bool showSpheres,
-                     bool clipEnabled, glm::vec3 clipMin, glm::vec3 clipMax);
-    void generateCylinder(const glm::vec3 &a, const glm::vec3 &b, float radiusA, float radiusB, const glm::vec3 &colorA, const glm::vec3 &colorB, int segmentID, std::vector<Vertex> &vertices, std::vector<unsigned int> &indices);
-    void generateSphere(const glm::vec3 &center, float radius, const glm::vec3 &color, int segmentID, std::vector<Vertex> &vertices, std::vector<unsigned int> &indices);
-    glm::vec3 getHeatMapColor(float value, float minVal, float maxVal);
+    // Normalização da árvore como matriz: (p - normCenter) * normScale
+    glm::mat4 normalization() const;
+    // Raio desenhado (bruto) do raio base bruto `radius`: o mesmo de vertex.glsl
+    float drawnRadius(float radius) const;
+    // Uniforms `model` (com a normalização), radiusFactor e minRadius
+    void applyNormalization(Shader &shader, const glm::mat4 &model) const;
+    void setupMeshAttributes();
+    size_t vertexSize() const;
+    // Amplia a faixa de quantização para conter [lo, hi] e raios até `maxRadius`;
+    // se ela mudar, todos os slots são agendados para regravação
+    void growQuantization(const glm::vec3 &lo, const glm::vec3 &hi, float maxRadius);
+    PackedVertex packVertex(const Vertex &v) const;
+    // Ordem dos índices de um slot de cilindro/esfera com `resolution`
+    // divisões (gerada e, se pedido, otimizada)
+    void buildIndexOrder(IndexOrder &order, bool sphere, int resolution) const;
+    const IndexOrder &indexOrderFor(const MeshPool &pool) const;
+    // Bloco da célula que contém o ponto bruto `p`, criado vazio se preciso
+    MeshChunk &chunkAt(const glm::vec3 &p);
+    // Apaga os pools de todos os blocos (objetos GL incluídos)
+    void deleteChunks();
+    // Envia os slots sujos de todos os pools de todos os blocos
+    void uploadDirtyChunks();
+    GLuint growBuffer(GLuint buffer, size_t usedBytes, size_t &capacity, size_t neededBytes);
+    // Esvazia o pool (sem apagar os objetos GL)
+    void resetPool(MeshPool &pool);
+    void deletePool(MeshPool &pool);
+    // Marca o slot da chave `key` como usado nesta atualização com a
+    // assinatura dada; aloca um slot se a chave for nova e agenda a regravação
+    // se a assinatura mudou
+    void useSlot(MeshPool &pool, uint64_t key, const float *signature);
+    // Libera os slots não usados nesta atualização
+    void releaseStaleSlots(MeshPool &pool);
+    // Garante a capacidade dos buffers e envia os slots marcados
+    void uploadDirtySlots(MeshPool &pool);
+    // Grava o slot em `vertices`/`indices` (vertsPerSlot/indicesPerSlot posições
+    // já alocadas); os índices são absolutos no VBO do pool
+    void generateSlot(const MeshPool &pool, uint32_t slot, Vertex *vertices, unsigned int *indices) const;
+    // Percorre os cilindros e esferas com raios base já calculados e atualiza
+    // os escalares (raio máximo por nó); comum aos caminhos de malha e instanciado
+    template <typename CylinderFn, typename SphereFn>
+    void forEachVesselPart(const ArterialTree &tree, bool showSpheres,
+                           const CylinderFn &onCylinder, const SphereFn &onSphere);
+    void buildMeshes(const ArterialTree &tree, bool showSpheres);
+    // Uniforms da caixa de corte; `clipPlanes` liga GL_CLIP_DISTANCE0..5
+    // (os impostores recortam no fragment shader)
+    void applyClipBox(Shader &shader, bool clipPlanes) const;
+    void releaseClipBox() const;
+    // Grava `values` em scalarData a partir de `first`, enviando só o trecho alterado
+    void uploadScalars(const std::vector<glm::vec2> &values, size_t first);
+    // Vincula a LUT (unidade 0) e os escalares (unidade 1) e define os uniforms
+    void applyColormap(Shader &shader);
+    void drawPool(const MeshPool &pool);
+    // Escolhe o nível de cada item (histerese em relação a `level`); retorna
+    // o total de triângulos. `bias` < 1 reduz os níveis (orçamento).
+    size_t selectLodLevels(const std::vector<LodItem> &items, bool sphere, float bias, std::vector<uint8_t> &levels) const;
+    // Níveis de cilindros e esferas respeitando o orçamento de triângulos
+    void selectAllLodLevels(std::vector<uint8_t> &cylinderLevels, std::vector<uint8_t> &sphereLevels) const;
+
+    void createUnitMesh(InstanceBuffers &buffers, bool sphere);
+    void deleteInstanceBuffers(InstanceBuffers &buffers);
+    // Grava `instances` a partir da instância `first`, crescendo o buffer se preciso
+    void uploadInstances(InstanceBuffers &buffers, const std::vector<VesselInstance> &instances, size_t first);
+    void buildInstances(const ArterialTree &tree, bool showSpheres);
+    void drawInstances(const InstanceBuffers &buffers);
+    // Geradores de primitivas: escrevem em posições pré-alocadas, com os
+    // índices a partir de `baseIdx` (sem estado, podem rodar em paralelo)
+    // Os vértices do cilindro alternam extremos A e B (paridade de gl_VertexID);
+    // os anéis dos extremos vêm de TubeUtils (retos ou de junta)
+    static void generateCylinder(const glm::vec3 &a, const glm::vec3 &b, float radiusA, float radiusB, int segmentID,
+                                 const TubeRing &ringA, const TubeRing &ringB, int sides, Vertex *vertices,
+                                 unsigned int *indices, unsigned int baseIdx);
+    static void generateSphere(const glm::vec3 &center, float radius, int segmentID, int segments, Vertex *vertices, unsigned int *indices, unsigned int baseIdx);
 };
\ No newline at end of file
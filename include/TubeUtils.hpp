@@ -0,0 +1,52 @@
+/*
+ * Universidade Federal de Ouro Preto - UFOP
+ * Departamento de Computação - DECOM
+ * Disciplina: BCC327 - Computação Gráfica (2025.2)
+ * Professor: Rafael Bonfim
+ * Trabalho Prático: Visualizador de Árvores Arteriais (CCO)
+ * Arquivo: TubeUtils.hpp
+ * Autor: Mateus Honorato
+ * Data: Outubro/2026
+ * Descrição:
+ * Declara a varredura de tubos contínuos: seções transversais (anéis) nos
+ * extremos de cada segmento, compartilhadas entre segmentos consecutivos de
+ * um mesmo ramo para que a malha não precise de esferas nas junções.
+ */
+
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "ArterialTree.hpp"
+
+// Anel de um extremo de tubo. O vértice de ângulo θ fica em
+// ringOffset(anel, cos θ, sin θ) * raio a partir do nó.
+struct TubeRing
+{
+    glm::vec3 tangent; // normal do plano do anel
+    glm::vec3 side;    // direção de θ = 0 (perpendicular a tangent)
+    glm::vec3 miter;   // junta: direção da dobra * (1 / cos φ - 1); zero = anel reto
+};
+
+class TubeUtils
+{
+public:
+    // Alongamento máximo do anel de junta (dobra de até 120° entre segmentos);
+    // dobras mais fechadas não são unidas
+    static constexpr float MAX_MITER_STRETCH = 2.0f;
+
+    // Anel reto perpendicular a `axis`, com a mesma base de
+    // TreeRenderer::generateCylinder e de instanced_vertex.glsl
+    static TubeRing plainRing(const glm::vec3 &axis);
+    // Deslocamento (unitário no anel reto) do vértice de ângulo θ
+    static glm::vec3 ringOffset(const TubeRing &ring, float cosTheta, float sinTheta);
+    // Percorre a árvore a partir das raízes e, em cada nó com um único
+    // segmento de entrada, continua o tubo pelo filho de maior raio: os dois
+    // segmentos recebem o mesmo anel de junta (plano bissetor) e o nó é
+    // marcado em `joinedNodes`. Os demais filhos começam com um anel reto no
+    // centro do nó, dentro do tubo principal. A referência `side` é
+    // transportada ao longo do ramo para evitar torção.
+    static void sweep(const ArterialTree &tree, std::vector<TubeRing> &ringsA, std::vector<TubeRing> &ringsB,
+                      std::vector<uint8_t> &joinedNodes);
+};
@@ -0,0 +1,41 @@
+/*
+ * Universidade Federal de Ouro Preto - UFOP
+ * Departamento de Computação - DECOM
+ * Disciplina: BCC327 - Computação Gráfica (2025.2)
+ * Professor: Rafael Bonfim
+ * Trabalho Prático: Visualizador de Árvores Arteriais (CCO)
+ * Arquivo: VertexCacheUtils.hpp
+ * Autor: Mateus Honorato
+ * Data: Outubro/2026
+ * Descrição:
+ * Declara a reordenação de listas de triângulos para o cache de vértices
+ * pós-transformação (Tipsify) e por agrupamentos contra overdraw,
+ * independentes de vista, além da medida de ACMR.
+ */
+
+#pragma once
+#include <cstddef>
+#include <vector>
+#include <glm/glm.hpp>
+
+class VertexCacheUtils
+{
+public:
+    // Entradas do cache FIFO simulado (ordem de grandeza das GPUs atuais)
+    static constexpr int CACHE_SIZE = 16;
+
+    // Média de vértices transformados por triângulo (ACMR) com um cache FIFO
+    // de `cacheSize` entradas
+    static float acmr(const std::vector<unsigned int> &indices, size_t vertexCount, int cacheSize = CACHE_SIZE);
+    // Tipsify (Sander, Nehab e Barczak, 2007): percorre leques de triângulos
+    // em torno de vértices ainda no cache. `clusterStarts` recebe o primeiro
+    // triângulo de cada trecho iniciado após um salto (cache esvaziado).
+    static std::vector<unsigned int> tipsify(const std::vector<unsigned int> &indices, size_t vertexCount,
+                                             std::vector<size_t> &clusterStarts, int cacheSize = CACHE_SIZE);
+    // Ordena os agrupamentos (mantendo a ordem interna de cada um) pela
+    // orientação para fora do objeto, dot(centróide - centro, normal), em
+    // ordem decrescente: faces externas primeiro escondem as internas
+    static std::vector<unsigned int> sortClustersForOverdraw(const std::vector<unsigned int> &indices,
+                                                             const std::vector<size_t> &clusterStarts,
+                                                             const std::vector<glm::vec3> &positions);
+};
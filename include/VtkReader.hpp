@@ -15,10 +15,69 @@
 #pragma once
 
 #include "ArterialTree.hpp"
+#include <atomic>
+#include <cstddef>
 #include <string>
 
+struct VtkReadOptions
+{
+    // Modo estrito: valida cada valor lido (número bem formado, n=2 em LINES,
+    // índices dentro do intervalo) e reporta o registro exato com erro.
+    // Modo tolerante: pula a validação por linha e só verifica, ao fim de
+    // cada seção, se algum valor falhou (útil em produção com dados confiáveis).
+    bool strict = true;
+    // Usa (e gera na primeira carga) o cache binário "<arquivo>.atb"
+    bool useCache = true;
+    // Threads para converter seções ASCII grandes (0 = todos os núcleos);
+    // seções pequenas são sempre lidas na thread chamadora
+    unsigned threads = 0;
+    // Se informado, a leitura é abandonada (retorna false, sem mensagem de
+    // erro) assim que o sinal for ligado; conferido entre as seções do arquivo
+    const std::atomic<bool> *cancel = nullptr;
+};
+
+// Recebe o conteúdo de um arquivo VTK em lotes, à medida que é decodificado
+// (VtkReader::stream). Ordem garantida: onBegin, todos os lotes de onNodes e
+// então pares onSegments/onRadii cobrindo o mesmo intervalo de segmentos.
+// Os ponteiros só são válidos durante a chamada; retornar false cancela a leitura.
+// Os valores chegam brutos: normalização e pontos médios ficam a cargo de quem recebe.
+class VtkVisitor
+{
+public:
+    virtual ~VtkVisitor() = default;
+    virtual bool onBegin(size_t numPoints, size_t numSegments) = 0;
+    virtual bool onNodes(size_t first, const glm::vec3 *positions, size_t count) = 0;
+    // `indexPairs` contém `count` pares (indexA, indexB)
+    virtual bool onSegments(size_t first, const int *indexPairs, size_t count) = 0;
+    virtual bool onRadii(size_t first, const float *radii, size_t count) = 0;
+};
+
 class VtkReader
 {
 public:
-    static bool load(const std::string &filepath, ArterialTree &outTree);
+    static bool load(const std::string &filepath, ArterialTree &outTree, const VtkReadOptions &options = VtkReadOptions());
+
+    // Leitura em lotes (ASCII ou BINARY, comprimido ou não): nenhuma árvore
+    // intermediária é montada. A memória do próprio leitor é a de um lote
+    // mais as janelas dos cursores (até quatro de ~1,3 MiB em entradas
+    // comprimidas); o arquivo, comprimido ou não, fica mapeado e suas páginas
+    // contam na memória residente. O que o visitante acumula é por conta dele.
+    // `options.useCache`, `options.threads` e `options.cancel` não se aplicam
+    // (para cancelar, o visitante retorna false).
+    static bool stream(const std::string &filepath, VtkVisitor &visitor, const VtkReadOptions &options = VtkReadOptions());
+
+private:
+    // Decide entre ASCII e BINARY pela terceira linha do cabeçalho
+    static bool parse(const char *data, size_t size, const std::string &filepath,
+                      ArterialTree &outTree, const VtkReadOptions &options);
+    static bool parseAscii(const char *data, size_t size, const std::string &filepath,
+                           ArterialTree &outTree, const VtkReadOptions &options);
+    // Formato legado BINARY: blocos big-endian logo após cada cabeçalho de seção
+    static bool parseBinary(const char *data, size_t size, const std::string &filepath,
+                            ArterialTree &outTree, const VtkReadOptions &options);
+    // Leitura em lotes sobre o conteúdo mapeado (comprimido ou não)
+    static bool streamData(const char *data, size_t size, const std::string &filepath,
+                           VtkVisitor &visitor, bool strict);
+    // Validação de índices (opcional), normalização e pontos médios
+    static bool finishTree(const std::string &filepath, ArterialTree &outTree, bool checkIndices);
 };
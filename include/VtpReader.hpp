@@ -0,0 +1,28 @@
+/*
+ * Universidade Federal de Ouro Preto - UFOP
+ * Departamento de Computação - DECOM
+ * Disciplina: BCC327 - Computação Gráfica (2025.2)
+ * Professor: Rafael Bonfim
+ * Trabalho Prático: Visualizador de Árvores Arteriais (CCO)
+ * Arquivo: VtpReader.hpp
+ * Autor: Mateus Honorato
+ * Data: Outubro/2026
+ * Descrição:
+ * Declara o leitor de arquivos VTK XML PolyData (.vtp) com dados anexados
+ * em formato bruto (<AppendedData encoding="raw">).
+ */
+
+#pragma once
+
+#include <string>
+#include "ArterialTree.hpp"
+#include "VtkReader.hpp"
+
+class VtpReader
+{
+public:
+    // Produz a mesma árvore (normalizada, com pontos médios) que VtkReader::load.
+    // Apenas `options.strict` é considerado: a leitura de arrays brutos não
+    // tem custo de parsing que justifique o cache .atb.
+    static bool load(const std::string &filepath, ArterialTree &outTree, const VtkReadOptions &options = VtkReadOptions());
+};
@@ -20,18 +20,43 @@ in vec3 FragPos;
 in vec3 Normal;
 in vec3 Color;
 in vec3 GouraudColor;
+in float gl_ClipDistance[6];
+uniform mat4 model;
 uniform int lightingMode; // 0=Phong, 1=Gouraud, 2=Flat
+uniform bool clipCaps;    // tampas no corte (só com a caixa de corte ativa)
 uniform int selectedSegmentID;
 flat in int vSegmentID;
 uniform vec3 lightPos;
 uniform vec3 viewPos;
 uniform float alpha;
-out vec4 FragColor;
+layout (location = 0) out vec4 FragColor;
+layout (location = 1) out int FragID; // buffer de IDs do picking (ignorado na tela)
+
+// Normais (coordenadas do modelo) das tampas de cada face da caixa de corte,
+// na ordem de gl_ClipDistance: a tampa olha para o lado removido
+const vec3 CAP_NORMALS[6] = vec3[6](vec3(-1.0, 0.0, 0.0), vec3(1.0, 0.0, 0.0),
+                                    vec3(0.0, -1.0, 0.0), vec3(0.0, 1.0, 0.0),
+                                    vec3(0.0, 0.0, -1.0), vec3(0.0, 0.0, 1.0));
 
 void main()
 {
     vec3 result = vec3(0.0);
-    if (lightingMode == 0) {
+    if (clipCaps && dot(Normal, viewPos - FragPos) < 0.0) {
+        // Interior do vaso visto pelo corte: iluminado como a tampa plana da
+        // face da caixa mais próxima
+        int face = 0;
+        for (int i = 1; i < 6; ++i) {
+            if (gl_ClipDistance[i] < gl_ClipDistance[face])
+                face = i;
+        }
+        float ambientStrength = 0.2;
+        vec3 ambient = ambientStrength * Color;
+        vec3 capNormal = normalize(mat3(model) * CAP_NORMALS[face]);
+        vec3 lightDir = normalize(lightPos - FragPos);
+        float diff = max(dot(capNormal, lightDir), 0.0);
+        vec3 diffuse = diff * Color;
+        result = ambient + diffuse;
+    } else if (lightingMode == 0) {
         // Phong shading (default): compute lighting per fragment
         float ambientStrength = 0.2;
         vec3 ambient = ambientStrength * Color;
@@ -69,4 +94,5 @@ void main()
         result *= 1.4;
     }
     FragColor = vec4(result, alpha);
+    FragID = vSegmentID;
 }
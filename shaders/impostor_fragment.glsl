@@ -0,0 +1,217 @@
+#version 330 core
+/*
+ * Universidade Federal de Ouro Preto - UFOP
+ * Departamento de Computação - DECOM
+ * Disciplina: BCC327 - Computação Gráfica (2025.2)
+ * Professor: Rafael Bonfim
+ * Trabalho Prático: Visualizador de Árvores Arteriais (CCO)
+ * Arquivo: impostor_fragment.glsl
+ * Autor: Mateus Honorato
+ * Data: Outubro/2026
+ * Descrição:
+ * Fragment shader dos impostores: intercepta o raio do pixel com o tronco de
+ * cone (segmento) ou a esfera (junção) exatos, grava a profundidade do ponto
+ * atingido e aplica os modelos Phong/Gouraud/Flat e o destaque de seleção de
+ * fragment.glsl. A caixa de corte é aplicada ao ponto atingido (e não à caixa
+ * envolvente), com as mesmas tampas de fragment.glsl.
+ *
+ * Créditos:
+ * Implementação baseada no modelo de iluminação de Phong do LearnOpenGL.com.
+ */
+
+in vec4 vClipPos;
+flat in vec4 vEndA;
+flat in vec4 vEndB;
+flat in vec3 vColorA;
+flat in vec3 vColorB;
+flat in int vSegmentID;
+
+uniform mat4 model;      // inclui a normalização da árvore (escala uniforme)
+uniform mat4 view;
+uniform mat4 projection;
+uniform mat4 inverseMVP; // inversa de projection * view * model
+uniform int lightingMode; // 0=Phong, 1=Gouraud, 2=Flat
+uniform int selectedSegmentID;
+uniform int instanceShape; // 0=Cilindro, 1=Esfera
+uniform vec3 lightPos;
+uniform vec3 viewPos;
+uniform float alpha;
+uniform bool clipEnabled;
+uniform bool clipCaps;
+uniform vec3 clipMin; // caixa de corte (coordenadas brutas, como as instâncias)
+uniform vec3 clipMax;
+layout (location = 0) out vec4 FragColor;
+layout (location = 1) out int FragID; // buffer de IDs do picking (ignorado na tela)
+
+const float PI = 3.14159265358979323846;
+const float FACETS = 32.0; // CYLINDER_SIDES / SPHERE_SEGMENTS das malhas
+
+// Mesmo modelo de fragment.glsl (posição e normal em coordenadas de mundo)
+vec3 shade(vec3 fragPos, vec3 norm, vec3 color)
+{
+    float ambientStrength = 0.2;
+    vec3 ambient = ambientStrength * color;
+    vec3 lightDir = normalize(lightPos - fragPos);
+    float diff = max(dot(norm, lightDir), 0.0);
+    vec3 diffuse = diff * color;
+    float specularStrength = 0.5;
+    vec3 viewDir = normalize(viewPos - fragPos);
+    vec3 reflectDir = reflect(-lightDir, norm);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), 32);
+    vec3 specular = specularStrength * spec * vec3(1.0);
+    return ambient + diffuse + specular;
+}
+
+vec3 toWorld(vec3 p)
+{
+    return vec3(model * vec4(p, 1.0));
+}
+
+// `model` é rotação com escala uniforme nesta aplicação: a normal usa a mesma
+// matriz, renormalizada
+vec3 normalToWorld(vec3 n)
+{
+    return normalize(mat3(model) * n);
+}
+
+bool insideClipBox(vec3 p)
+{
+    return !clipEnabled || (all(greaterThanEqual(p, clipMin)) && all(lessThanEqual(p, clipMax)));
+}
+
+// Tampa do corte (como em fragment.glsl): normal da face mais próxima da caixa
+vec3 shadeCap(vec3 p, vec3 color)
+{
+    vec3 toMin = p - clipMin;
+    vec3 toMax = clipMax - p;
+    vec3 normal = vec3(-1.0, 0.0, 0.0);
+    float nearest = toMin.x;
+    if (toMax.x < nearest) { nearest = toMax.x; normal = vec3(1.0, 0.0, 0.0); }
+    if (toMin.y < nearest) { nearest = toMin.y; normal = vec3(0.0, -1.0, 0.0); }
+    if (toMax.y < nearest) { nearest = toMax.y; normal = vec3(0.0, 1.0, 0.0); }
+    if (toMin.z < nearest) { nearest = toMin.z; normal = vec3(0.0, 0.0, -1.0); }
+    if (toMax.z < nearest) { nearest = toMax.z; normal = vec3(0.0, 0.0, 1.0); }
+    vec3 fragPos = toWorld(p);
+    float diff = max(dot(normalToWorld(normal), normalize(lightPos - fragPos)), 0.0);
+    return 0.2 * color + diff * color;
+}
+
+void main()
+{
+    // Raio do pixel em coordenadas brutas (vale para perspectiva e ortográfica)
+    vec2 ndc = vClipPos.xy / vClipPos.w;
+    vec4 nearPoint = inverseMVP * vec4(ndc, -1.0, 1.0);
+    vec4 farPoint = inverseMVP * vec4(ndc, 1.0, 1.0);
+    vec3 ro = nearPoint.xyz / nearPoint.w;
+    vec3 rd = normalize(farPoint.xyz / farPoint.w - ro);
+
+    vec3 hit;
+    vec3 color;
+    vec3 result;
+    if (instanceShape == 0) {
+        // Superfície lateral do tronco de cone: |q⊥|² = (rA + k·h)², h ∈ [0, L]
+        vec3 ba = vEndB.xyz - vEndA.xyz;
+        float len = length(ba);
+        vec3 axis = ba / len;
+        float rA = vEndA.w;
+        float k = (vEndB.w - rA) / len;
+        vec3 o = ro - vEndA.xyz;
+        float ho = dot(o, axis);
+        float hd = dot(rd, axis);
+        float radiusAtO = rA + k * ho;
+        float a = 1.0 - hd * hd * (1.0 + k * k);
+        float b = dot(o, rd) - ho * hd - k * hd * radiusAtO;
+        float c = dot(o, o) - ho * ho - radiusAtO * radiusAtO;
+        float disc = b * b - a * c;
+        if (disc < 0.0 || abs(a) < 1e-8)
+            discard;
+        float sq = sqrt(disc);
+        float s0 = (-b - sq) / a;
+        float s1 = (-b + sq) / a;
+        if (s0 > s1) {
+            float tmp = s0;
+            s0 = s1;
+            s1 = tmp;
+        }
+        // Primeira interseção dentro do segmento e da caixa de corte (a segunda
+        // mostra o interior, como a malha sem tampas)
+        float s = s0;
+        float h = ho + s * hd;
+        if (s < 0.0 || h < 0.0 || h > len || !insideClipBox(ro + s * rd)) {
+            s = s1;
+            h = ho + s * hd;
+            if (s < 0.0 || h < 0.0 || h > len || !insideClipBox(ro + s * rd))
+                discard;
+        }
+        hit = ro + s * rd;
+        float t = h / len;
+        color = mix(vColorA, vColorB, t);
+        vec3 radial = normalize(hit - vEndA.xyz - h * axis);
+        vec3 normal = normalize(radial - k * axis);
+
+        if (clipCaps && dot(normal, rd) > 0.0) {
+            result = shadeCap(hit, color);
+        } else if (lightingMode == 1) {
+            // Gouraud: iluminação nos anéis das extremidades, interpolada ao longo do eixo
+            vec3 n = normalToWorld(normal);
+            vec3 litA = shade(toWorld(vEndA.xyz + radial * rA), n, vColorA);
+            vec3 litB = shade(toWorld(vEndB.xyz + radial * vEndB.w), n, vColorB);
+            result = mix(litA, litB, t);
+        } else {
+            if (lightingMode == 2) {
+                // Flat: normal do centro da face da malha de FACETS lados
+                vec3 up = vec3(0.0, 1.0, 0.0);
+                if (abs(dot(axis, up)) > 0.99)
+                    up = vec3(1.0, 0.0, 0.0);
+                vec3 side = normalize(cross(axis, up));
+                vec3 ortho = normalize(cross(axis, side));
+                float facetAngle = 2.0 * PI / FACETS;
+                float theta = atan(dot(radial, ortho), dot(radial, side));
+                theta = (floor(theta / facetAngle) + 0.5) * facetAngle;
+                normal = normalize(side * cos(theta) + ortho * sin(theta) - k * axis);
+            }
+            result = shade(toWorld(hit), normalToWorld(normal), color);
+        }
+    } else {
+        vec3 o = ro - vEndA.xyz;
+        float b = dot(o, rd);
+        float c = dot(o, o) - vEndA.w * vEndA.w;
+        float disc = b * b - c;
+        if (disc < 0.0)
+            discard;
+        float sq = sqrt(disc);
+        float s = -b - sq;
+        if (s < 0.0 || !insideClipBox(ro + s * rd))
+            s = -b + sq;
+        if (s < 0.0 || !insideClipBox(ro + s * rd))
+            discard;
+        hit = ro + s * rd;
+        color = vColorA;
+        vec3 normal = (hit - vEndA.xyz) / vEndA.w;
+        if (lightingMode == 2) {
+            // Flat: normal do centro da célula da parametrização de generateSphere
+            float u = atan(normal.z, normal.x) / (2.0 * PI);
+            u = fract(u);
+            float v = acos(clamp(normal.y, -1.0, 1.0)) / PI;
+            u = (floor(u * FACETS) + 0.5) / FACETS;
+            v = (min(floor(v * FACETS), FACETS - 1.0) + 0.5) / FACETS;
+            normal = vec3(cos(u * 2.0 * PI) * sin(v * PI), cos(v * PI), sin(u * 2.0 * PI) * sin(v * PI));
+        }
+        // Na esfera de 32x32 o Gouraud é praticamente igual ao Phong
+        if (clipCaps && dot(normal, rd) > 0.0)
+            result = shadeCap(hit, color);
+        else
+            result = shade(toWorld(hit), normalToWorld(normal), color);
+    }
+
+    vec4 clip = projection * (view * (model * vec4(hit, 1.0)));
+    gl_FragDepth = 0.5 * (clip.z / clip.w) + 0.5;
+
+    // Highlight selected segment
+    if (selectedSegmentID != -1 && vSegmentID == selectedSegmentID) {
+        result = mix(result, vec3(1.0, 1.0, 0.0), 0.6);
+        result *= 1.4;
+    }
+    FragColor = vec4(result, alpha);
+    FragID = vSegmentID;
+}
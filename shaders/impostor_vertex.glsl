@@ -0,0 +1,85 @@
+#version 330 core
+/*
+ * Universidade Federal de Ouro Preto - UFOP
+ * Departamento de Computação - DECOM
+ * Disciplina: BCC327 - Computação Gráfica (2025.2)
+ * Professor: Rafael Bonfim
+ * Trabalho Prático: Visualizador de Árvores Arteriais (CCO)
+ * Arquivo: impostor_vertex.glsl
+ * Autor: Mateus Honorato
+ * Data: Outubro/2026
+ * Descrição:
+ * Vertex shader dos impostores: posiciona a caixa envolvente de cada
+ * instância (tronco de cone ou esfera). A superfície é traçada por raio em
+ * impostor_fragment.glsl.
+ */
+
+layout (location = 0) in vec3 aLocal;      // canto da caixa unitária
+layout (location = 4) in vec4 aEndA;       // extremo A (xyz) e raio base (w)
+layout (location = 5) in vec4 aEndB;       // extremo B (xyz) e raio base (w)
+layout (location = 6) in int aSegmentID;
+
+uniform mat4 model;        // inclui a normalização da árvore (escala uniforme)
+uniform mat4 view;
+uniform mat4 projection;
+uniform int instanceShape; // 0=Cilindro, 1=Esfera
+uniform float radiusFactor; // raio bruto -> desenhado: normRadiusFix * escala da interface
+uniform float minRadius;    // raio mínimo desenhado (0,002 na árvore normalizada)
+uniform samplerBuffer scalarBuffer; // escalares (extremo A, extremo B) por segmentID
+uniform sampler1D colormap;         // LUT do mapa de cores
+uniform int nodeScalarOffset;       // esferas: segmentID = -2 - nó
+uniform float scalarMin;
+uniform float scalarMax;
+
+out vec4 vClipPos;
+flat out vec4 vEndA;
+flat out vec4 vEndB;
+flat out vec3 vColorA;
+flat out vec3 vColorB;
+flat out int vSegmentID;
+
+// Escalares do segmento ou, com segmentID negativo, do nó da esfera
+vec2 fetchScalars(int id)
+{
+    return texelFetch(scalarBuffer, id >= 0 ? id : nodeScalarOffset - 2 - id).rg;
+}
+
+// Cor da LUT para o escalar normalizado em [scalarMin, scalarMax]
+vec3 mapColor(float value)
+{
+    float range = scalarMax - scalarMin;
+    float t = range < 0.00001 ? 0.5 : clamp((value - scalarMin) / range, 0.0, 1.0);
+    // Entre os centros do primeiro e do último texel
+    return texture(colormap, (t * 255.0 + 0.5) / 256.0).rgb;
+}
+
+void main()
+{
+    // Raios desenhados (mesmo clamp de vertex.glsl), repassados ao fragment shader
+    vec4 endA = vec4(aEndA.xyz, max(aEndA.w * radiusFactor, minRadius));
+    vec4 endB = vec4(aEndB.xyz, max(aEndB.w * radiusFactor, minRadius));
+    vec3 pos;
+    if (instanceShape == 0) {
+        // Mesma base de TreeRenderer::generateCylinder, com o maior raio
+        vec3 axis = aEndB.xyz - aEndA.xyz;
+        vec3 dir = normalize(axis);
+        vec3 up = vec3(0.0, 1.0, 0.0);
+        if (abs(dot(dir, up)) > 0.99)
+            up = vec3(1.0, 0.0, 0.0);
+        vec3 side = normalize(cross(dir, up));
+        vec3 ortho = normalize(cross(dir, side));
+        float radius = max(endA.w, endB.w);
+        pos = aEndA.xyz + axis * aLocal.z + (side * aLocal.x + ortho * aLocal.y) * radius;
+    } else {
+        pos = aEndA.xyz + aLocal * endA.w;
+    }
+
+    vEndA = endA;
+    vEndB = endB;
+    vec2 scalars = fetchScalars(aSegmentID);
+    vColorA = mapColor(scalars.x);
+    vColorB = mapColor(scalars.y);
+    vSegmentID = aSegmentID;
+    gl_Position = projection * view * model * vec4(pos, 1.0);
+    vClipPos = gl_Position;
+}
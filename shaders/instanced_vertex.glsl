@@ -0,0 +1,117 @@
+#version 330 core
+/*
+ * Universidade Federal de Ouro Preto - UFOP
+ * Departamento de Computação - DECOM
+ * Disciplina: BCC327 - Computação Gráfica (2025.2)
+ * Professor: Rafael Bonfim
+ * Trabalho Prático: Visualizador de Árvores Arteriais (CCO)
+ * Arquivo: instanced_vertex.glsl
+ * Autor: Mateus Honorato
+ * Data: Outubro/2026
+ * Descrição:
+ * Vertex shader do caminho instanciado: expande a malha unitária (cilindro ou
+ * esfera) de cada instância na posição, orientação e raio do vaso. A base do
+ * cilindro é a mesma de TreeRenderer::generateCylinder, e as saídas são as de
+ * vertex.glsl, usando o mesmo fragment shader.
+ */
+
+layout (location = 0) in vec3 aLocal;      // cilindro: (cos θ, sin θ, t); esfera: ponto unitário
+layout (location = 4) in vec4 aEndA;       // extremo A (xyz) e raio base (w)
+layout (location = 5) in vec4 aEndB;       // extremo B (xyz) e raio base (w)
+layout (location = 6) in int aSegmentID;
+
+uniform mat4 model;        // inclui a normalização da árvore (escala uniforme)
+uniform mat4 view;
+uniform mat4 projection;
+uniform int lightingMode; // 0=Phong, 1=Gouraud, 2=Flat
+uniform vec3 lightPos;
+uniform vec3 viewPos;
+uniform int instanceShape; // 0=Cilindro, 1=Esfera
+uniform float radiusFactor; // raio bruto -> desenhado: normRadiusFix * escala da interface
+uniform float minRadius;    // raio mínimo desenhado (0,002 na árvore normalizada)
+uniform samplerBuffer scalarBuffer; // escalares (extremo A, extremo B) por segmentID
+uniform sampler1D colormap;         // LUT do mapa de cores
+uniform int nodeScalarOffset;       // esferas: segmentID = -2 - nó
+uniform float scalarMin;
+uniform float scalarMax;
+uniform vec3 clipMin;      // caixa de corte (coordenadas brutas, como as instâncias)
+uniform vec3 clipMax;
+
+out vec3 FragPos;
+out vec3 Normal;
+out vec3 Color;
+out vec3 GouraudColor;
+flat out int vSegmentID;
+out float gl_ClipDistance[6];
+
+// Escalares do segmento ou, com segmentID negativo, do nó da esfera
+vec2 fetchScalars(int id)
+{
+    return texelFetch(scalarBuffer, id >= 0 ? id : nodeScalarOffset - 2 - id).rg;
+}
+
+// Cor da LUT para o escalar normalizado em [scalarMin, scalarMax]
+vec3 mapColor(float value)
+{
+    float range = scalarMax - scalarMin;
+    float t = range < 0.00001 ? 0.5 : clamp((value - scalarMin) / range, 0.0, 1.0);
+    // Entre os centros do primeiro e do último texel
+    return texture(colormap, (t * 255.0 + 0.5) / 256.0).rgb;
+}
+
+void main()
+{
+    vec3 pos;
+    vec3 normal;
+    vec3 color;
+    // Mesmo clamp de vertex.glsl
+    float rA = max(aEndA.w * radiusFactor, minRadius);
+    float rB = max(aEndB.w * radiusFactor, minRadius);
+    vec2 scalars = fetchScalars(aSegmentID);
+    if (instanceShape == 0) {
+        vec3 axis = normalize(aEndB.xyz - aEndA.xyz);
+        vec3 up = vec3(0.0, 1.0, 0.0);
+        if (abs(dot(axis, up)) > 0.99)
+            up = vec3(1.0, 0.0, 0.0);
+        vec3 side = normalize(cross(axis, up));
+        vec3 ortho = normalize(cross(axis, side));
+        vec3 dirVec = side * aLocal.x + ortho * aLocal.y;
+        float t = aLocal.z;
+        pos = mix(aEndA.xyz, aEndB.xyz, t) + dirVec * mix(rA, rB, t);
+        normal = normalize(dirVec);
+        color = mix(mapColor(scalars.x), mapColor(scalars.y), t);
+    } else {
+        pos = aEndA.xyz + aLocal * rA;
+        normal = aLocal;
+        color = mapColor(scalars.x);
+    }
+
+    FragPos = vec3(model * vec4(pos, 1.0));
+    Normal = mat3(transpose(inverse(model))) * normal;
+    Color = color;
+    GouraudColor = vec3(0.0);
+    vSegmentID = aSegmentID;
+    if (lightingMode == 1) {
+        // Gouraud shading: compute lighting here
+        float ambientStrength = 0.2;
+        vec3 ambient = ambientStrength * color;
+        vec3 norm = normalize(Normal);
+        vec3 lightDir = normalize(lightPos - FragPos);
+        float diff = max(dot(norm, lightDir), 0.0);
+        vec3 diffuse = diff * color;
+        float specularStrength = 0.5;
+        vec3 viewDir = normalize(viewPos - FragPos);
+        vec3 reflectDir = reflect(-lightDir, norm);
+        float spec = pow(max(dot(viewDir, reflectDir), 0.0), 32);
+        vec3 specular = specularStrength * spec * vec3(1.0);
+        GouraudColor = ambient + diffuse + specular;
+    }
+    // Distâncias às faces da caixa de corte (GL_CLIP_DISTANCE0..5, ligados só com o corte ativo)
+    gl_ClipDistance[0] = pos.x - clipMin.x;
+    gl_ClipDistance[1] = clipMax.x - pos.x;
+    gl_ClipDistance[2] = pos.y - clipMin.y;
+    gl_ClipDistance[3] = clipMax.y - pos.y;
+    gl_ClipDistance[4] = pos.z - clipMin.z;
+    gl_ClipDistance[5] = clipMax.z - pos.z;
+    gl_Position = projection * view * model * vec4(pos, 1.0);
+}
@@ -19,7 +19,8 @@ flat in int vSegmentID;
 uniform int selectedSegmentID;
 uniform float alpha;
 
-out vec4 FragColor;
+layout (location = 0) out vec4 FragColor;
+layout (location = 1) out int FragID; // buffer de IDs do picking (ignorado na tela)
 
 void main()
 {
@@ -28,4 +29,5 @@ void main()
         outColor = vec4(1.0, 1.0, 0.0, alpha); // Highlight: Yellow
     }
     FragColor = outColor;
+    FragID = vSegmentID;
 }
@@ -13,19 +13,49 @@
  */
 
 layout (location = 0) in vec3 aPos;
-layout (location = 2) in vec3 aColor;
 layout (location = 3) in int aSegmentID;
 
-uniform mat4 model;
+uniform mat4 model;        // inclui a normalização da árvore (escala uniforme)
 uniform mat4 view;
 uniform mat4 projection;
+uniform samplerBuffer scalarBuffer; // escalares (extremo A, extremo B) por segmentID
+uniform sampler1D colormap;         // LUT do mapa de cores
+uniform int nodeScalarOffset;       // esferas: segmentID = -2 - nó
+uniform float scalarMin;
+uniform float scalarMax;
+uniform vec3 clipMin;      // caixa de corte (coordenadas brutas, como aPos)
+uniform vec3 clipMax;
 
 out vec3 Color;
 flat out int vSegmentID;
+out float gl_ClipDistance[6];
+
+// Escalares do segmento ou, com segmentID negativo, do nó da esfera
+vec2 fetchScalars(int id)
+{
+    return texelFetch(scalarBuffer, id >= 0 ? id : nodeScalarOffset - 2 - id).rg;
+}
+
+// Cor da LUT para o escalar normalizado em [scalarMin, scalarMax]
+vec3 mapColor(float value)
+{
+    float range = scalarMax - scalarMin;
+    float t = range < 0.00001 ? 0.5 : clamp((value - scalarMin) / range, 0.0, 1.0);
+    // Entre os centros do primeiro e do último texel
+    return texture(colormap, (t * 255.0 + 0.5) / 256.0).rgb;
+}
 
 void main()
 {
+    // Distâncias às faces da caixa de corte (GL_CLIP_DISTANCE0..5, ligados só com o corte ativo)
+    gl_ClipDistance[0] = aPos.x - clipMin.x;
+    gl_ClipDistance[1] = clipMax.x - aPos.x;
+    gl_ClipDistance[2] = aPos.y - clipMin.y;
+    gl_ClipDistance[3] = clipMax.y - aPos.y;
+    gl_ClipDistance[4] = aPos.z - clipMin.z;
+    gl_ClipDistance[5] = clipMax.z - aPos.z;
     gl_Position = projection * view * model * vec4(aPos, 1.0);
-    Color = aColor;
+    // Vértices pares no extremo A do segmento, ímpares no B
+    Color = mapColor(fetchScalars(aSegmentID)[gl_VertexID & 1]);
     vSegmentID = aSegmentID;
 }
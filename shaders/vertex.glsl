@@ -10,44 +10,99 @@
  * Data: Fevereiro/2026
  * Descrição:
  * Vertex shader para renderização das malhas com suporte a Phong/Gouraud/Flat.
+ * Os vértices chegam com posições e raios brutos; a normalização da árvore
+ * vem em `model` e em radiusFactor/minRadius.
  *
  * Créditos:
  * Implementação baseada no modelo de iluminação de Phong do LearnOpenGL.com.
  */
 
 layout (location = 0) in vec3 aPos;
-layout (location = 1) in vec3 aNormal;
-layout (location = 2) in vec3 aColor;
-layout (location = 3) in int aSegmentID;
+layout (location = 1) in vec3 aNormal;      // compactado: normal octaédrica em xy
+layout (location = 3) in int aSegmentID;    // compactado: 24 bits com sinal
+layout (location = 4) in float aRadius;     // raio base; aPos é o ponto no eixo
 
-uniform mat4 model;
+uniform mat4 model;        // inclui a normalização da árvore (escala uniforme)
 uniform mat4 view;
 uniform mat4 projection;
 uniform int lightingMode; // 0=Phong, 1=Gouraud, 2=Flat
 uniform vec3 lightPos;
 uniform vec3 viewPos;
+uniform float radiusFactor; // raio bruto -> desenhado: normRadiusFix * escala da interface
+uniform float minRadius;    // raio mínimo desenhado (0,002 na árvore normalizada)
+uniform samplerBuffer scalarBuffer; // escalares (extremo A, extremo B) por segmentID
+uniform sampler1D colormap;         // LUT do mapa de cores
+uniform int nodeScalarOffset;       // esferas: segmentID = -2 - nó
+uniform float scalarMin;
+uniform float scalarMax;
+uniform vec3 clipMin;      // caixa de corte (coordenadas brutas, como aPos)
+uniform vec3 clipMax;
+uniform bool packedVertices; // PackedVertex: posição e raio quantizados em [0, 1]
+uniform vec3 quantMin;       // caixa de quantização das posições
+uniform vec3 quantExtent;
+uniform float quantRadiusMax;
 
 out vec3 FragPos;
 out vec3 Normal;
 out vec3 Color;
 out vec3 GouraudColor;
 flat out int vSegmentID;
+out float gl_ClipDistance[6];
+
+// Escalares do segmento ou, com segmentID negativo, do nó da esfera
+vec2 fetchScalars(int id)
+{
+    return texelFetch(scalarBuffer, id >= 0 ? id : nodeScalarOffset - 2 - id).rg;
+}
+
+// Cor da LUT para o escalar normalizado em [scalarMin, scalarMax]
+vec3 mapColor(float value)
+{
+    float range = scalarMax - scalarMin;
+    float t = range < 0.00001 ? 0.5 : clamp((value - scalarMin) / range, 0.0, 1.0);
+    // Entre os centros do primeiro e do último texel
+    return texture(colormap, (t * 255.0 + 0.5) / 256.0).rgb;
+}
+
+// Inverso da codificação octaédrica de TreeRenderer::packVertex
+vec3 octDecode(vec2 e)
+{
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return normalize(n);
+}
 
 void main()
 {
-    FragPos = vec3(model * vec4(aPos, 1.0));
-    Normal = mat3(transpose(inverse(model))) * aNormal;
-    Color = aColor;
+    vec3 axisPos = aPos;
+    vec3 normal = aNormal;
+    float radius = aRadius;
+    int segmentID = aSegmentID;
+    if (packedVertices) {
+        axisPos = quantMin + aPos * quantExtent;
+        normal = octDecode(aNormal.xy);
+        radius = aRadius * quantRadiusMax;
+        segmentID = (aSegmentID << 8) >> 8; // extensão de sinal dos 24 bits
+    }
+    // Superfície do vaso: deslocamento radial pelo raio escalado (com mínimo)
+    vec3 pos = axisPos + normal * max(radius * radiusFactor, minRadius);
+    FragPos = vec3(model * vec4(pos, 1.0));
+    Normal = mat3(transpose(inverse(model))) * normal;
+    // Vértices pares no extremo A, ímpares no B (esferas: os dois iguais)
+    vec3 color = mapColor(fetchScalars(segmentID)[gl_VertexID & 1]);
+    Color = color;
     GouraudColor = vec3(0.0);
-        vSegmentID = aSegmentID;
+        vSegmentID = segmentID;
     if (lightingMode == 1) {
         // Gouraud shading: compute lighting here
         float ambientStrength = 0.2;
-        vec3 ambient = ambientStrength * aColor;
+        vec3 ambient = ambientStrength * color;
         vec3 norm = normalize(Normal);
         vec3 lightDir = normalize(lightPos - FragPos);
         float diff = max(dot(norm, lightDir), 0.0);
-        vec3 diffuse = diff * aColor;
+        vec3 diffuse = diff * color;
         float specularStrength = 0.5;
         vec3 viewDir = normalize(viewPos - FragPos);
         vec3 reflectDir = reflect(-lightDir, norm);
@@ -55,5 +110,12 @@ void main()
         vec3 specular = specularStrength * spec * vec3(1.0);
         GouraudColor = ambient + diffuse + specular;
     }
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
+    // Distâncias às faces da caixa de corte (GL_CLIP_DISTANCE0..5, ligados só com o corte ativo)
+    gl_ClipDistance[0] = pos.x - clipMin.x;
+    gl_ClipDistance[1] = clipMax.x - pos.x;
+    gl_ClipDistance[2] = pos.y - clipMin.y;
+    gl_ClipDistance[3] = clipMax.y - pos.y;
+    gl_ClipDistance[4] = pos.z - clipMin.z;
+    gl_ClipDistance[5] = clipMax.z - pos.z;
+    gl_Position = projection * view * model * vec4(pos, 1.0);
 }
@@ -13,18 +13,28 @@
  */
 
 #include <algorithm>
+#include <cstdlib>
 #include <iostream>
+#include <limits>
 #include "AnimationController.hpp"
+#include "VtpReader.hpp"
 
-void AnimationController::setModeWireframe(ArterialTree *tree, TreeRenderer *renderer)
+namespace
+{
+    // Arquivos a partir deste tamanho são lidos em segundo plano com pré-visualização
+    const uintmax_t PROGRESSIVE_MIN_BYTES = uintmax_t(32) << 20;
+    // Segmentos acrescentados à pré-visualização por quadro (mantém a interface fluida)
+    const size_t PREVIEW_SEGMENTS_PER_FRAME = 8192;
+}
+
+void AnimationController::setModeWireframe(SharedTree *tree, TreeRenderer *renderer)
 {
     currentMode = ModeWireframe;
     this->selectedSegmentIndex = -1;
     currentRootPath = "../data/TP1_2D/";
     if (tree && renderer)
     {
-        renderer->initWireframe(tree->nodes, tree->segments,
-                                clipping.enabled, clipping.min, clipping.max);
+        renderer->initWireframe(**tree);
     }
     refreshDatasets(tree, renderer);
     requestCameraReset();
@@ -45,7 +55,7 @@ AnimationController::AnimationController()
     requestCameraReset();
 }
 // --- Troca de modos ---
-void AnimationController::setMode2D(ArterialTree *tree, TreeRenderer *renderer)
+void AnimationController::setMode2D(SharedTree *tree, TreeRenderer *renderer)
 {
     currentMode = Mode2D;
     this->selectedSegmentIndex = -1;
@@ -54,7 +64,7 @@ void AnimationController::setMode2D(ArterialTree *tree, TreeRenderer *renderer)
     requestCameraReset();
 }
 
-void AnimationController::setMode3D(ArterialTree *tree, TreeRenderer *renderer)
+void AnimationController::setMode3D(SharedTree *tree, TreeRenderer *renderer)
 {
     currentMode = Mode3D;
     this->selectedSegmentIndex = -1;
@@ -63,8 +73,9 @@ void AnimationController::setMode3D(ArterialTree *tree, TreeRenderer *renderer)
     requestCameraReset();
 }
 
-void AnimationController::refreshDatasets(ArterialTree *tree, TreeRenderer *renderer)
+void AnimationController::refreshDatasets(SharedTree *tree, TreeRenderer *renderer)
 {
+    m_loader.cancel();
     availableDatasets.clear();
     currentPlaylist.clear();
     currentDatasetIndex = 0;
@@ -73,7 +84,9 @@ void AnimationController::refreshDatasets(ArterialTree *tree, TreeRenderer *rend
     {
         for (const auto &entry : std::filesystem::directory_iterator(currentRootPath))
         {
-            if (entry.is_directory())
+            // Pastas de frames ou sequências empacotadas (.ats)
+            if (entry.is_directory() ||
+                (entry.is_regular_file() && entry.path().extension() == ".ats"))
             {
                 availableDatasets.push_back(entry.path().filename().string());
             }
@@ -92,12 +105,12 @@ void AnimationController::refreshDatasets(ArterialTree *tree, TreeRenderer *rend
         // Limpa árvore/renderizador se não houver datasets
         if (tree)
         {
-            tree->nodes.clear();
-            tree->segments.clear();
+            *tree = std::make_shared<const ArterialTree>();
+            ++m_treeVersion;
         }
         if (renderer && tree)
         {
-            renderer->init(*tree); // Reinicializa com árvore vazia
+            renderer->init(**tree); // Reinicializa com árvore vazia
         }
     }
 }
@@ -105,13 +118,30 @@ void AnimationController::refreshDatasets(ArterialTree *tree, TreeRenderer *rend
 void AnimationController::loadPlaylist(const std::string &folderName)
 {
     currentPlaylist.clear();
+    m_archive.close();
     std::string folderPath = currentRootPath + folderName + "/";
 
+    if (std::filesystem::path(folderName).extension() == ".ats")
+    {
+        // Sequência empacotada: a playlist são os nomes dos frames de origem.
+        // Reconstruir um passo custa só a diferença, sem pré-carregamento.
+        if (m_archive.open(currentRootPath + folderName))
+            currentPlaylist = m_archive.frameNames();
+        currentFrameIndex = 0;
+        m_requestedFrame = -1;
+        m_direction = 1;
+        m_prefetcher.setPlaylist(std::vector<std::string>());
+        return;
+    }
     if (std::filesystem::exists(folderPath))
     {
         for (const auto &entry : std::filesystem::directory_iterator(folderPath))
         {
-            if (entry.is_regular_file() && entry.path().extension() == ".vtk")
+            // Aceita VTK legado (.vtk, ou comprimido .vtk.gz) e VTK XML PolyData (.vtp)
+            const std::filesystem::path &path = entry.path();
+            bool isFrame = path.extension() == ".vtk" || path.extension() == ".vtp" ||
+                           (path.extension() == ".gz" && path.stem().extension() == ".vtk");
+            if (entry.is_regular_file() && isFrame)
             {
                 currentPlaylist.push_back(entry.path().string());
             }
@@ -120,55 +150,210 @@ void AnimationController::loadPlaylist(const std::string &folderName)
 
     std::sort(currentPlaylist.begin(), currentPlaylist.end());
     currentFrameIndex = 0;
+    m_requestedFrame = -1;
+    m_direction = 1;
+    m_prefetcher.setPlaylist(currentPlaylist);
 }
 
-void AnimationController::loadCurrentFrame(ArterialTree &tree, TreeRenderer &renderer)
+bool AnimationController::loadFrameFile(const std::string &path, ArterialTree &tree,
+                                        const std::atomic<bool> *cancel)
+{
+    // Escolhe o leitor pela extensão do arquivo (VTP é lido de uma vez, sem cancelamento)
+    if (std::filesystem::path(path).extension() == ".vtp")
+        return VtpReader::load(path, tree);
+    VtkReadOptions options;
+    options.cancel = cancel;
+    return VtkReader::load(path, tree, options);
+}
+
+void AnimationController::loadCurrentFrame(SharedTree &tree, TreeRenderer &renderer)
 {
     if (currentPlaylist.empty())
         return;
 
     if (currentFrameIndex >= 0 && currentFrameIndex < (int)currentPlaylist.size())
     {
-        if (!VtkReader::load(currentPlaylist[currentFrameIndex], tree))
+        const std::string &path = currentPlaylist[currentFrameIndex];
+        // Um novo frame substitui qualquer leitura em segundo plano
+        m_loader.cancel();
+        if (m_archive.isOpen())
         {
-            std::cerr << "Falha ao carregar frame: " << currentPlaylist[currentFrameIndex] << std::endl;
-        }
-        else
-        {
-            if (currentMode == ModeWireframe)
+            auto frame = std::make_shared<ArterialTree>();
+            if (m_archive.readFrame(static_cast<size_t>(currentFrameIndex), *frame))
             {
-                renderer.initWireframe(tree.nodes, tree.segments,
-                                       clipping.enabled, clipping.min, clipping.max);
+                tree = std::move(frame);
+                onFrameLoaded(*tree, renderer);
             }
             else
             {
-                renderer.init(tree, radiusScale, showSpheres,
-                              clipping.enabled, clipping.min, clipping.max);
+                std::cerr << "Falha ao carregar frame: " << path << std::endl;
             }
-            // Restaura seleção persistente se `lastSelectedMidpoint` for válido
-            if (selectedSegmentIndex != -1 && tree.segments.size() > 0)
+            return;
+        }
+        // Retira o frame antes de mover a janela: ao sair dela o slot
+        // poderia ser reaproveitado
+        bool prefetched = m_prefetcher.take(currentFrameIndex, tree);
+        m_prefetcher.setCursor(currentFrameIndex, m_direction, m_isPlaying);
+        if (prefetched)
+        {
+            onFrameLoaded(*tree, renderer);
+            return;
+        }
+        if (startProgressiveLoad(path, tree, renderer))
+            return;
+        auto frame = std::make_shared<ArterialTree>();
+        if (!loadFrameFile(path, *frame))
+        {
+            std::cerr << "Falha ao carregar frame: " << path << std::endl;
+        }
+        else
+        {
+            tree = std::move(frame);
+            onFrameLoaded(*tree, renderer);
+        }
+    }
+}
+
+void AnimationController::onFrameLoaded(const ArterialTree &tree, TreeRenderer &renderer)
+{
+    ++m_treeVersion;
+    if (currentMode == ModeWireframe)
+    {
+        renderer.initWireframe(tree);
+    }
+    else
+    {
+        renderer.init(tree, showSpheres);
+    }
+    // Restaura seleção persistente se `lastSelectedMidpoint` for válido
+    if (selectedSegmentIndex != -1 && tree.segments.size() > 0)
+    {
+        float minDist = std::numeric_limits<float>::max();
+        int bestIdx = -1;
+        for (size_t i = 0; i < tree.segments.size(); ++i)
+        {
+            float dist = glm::distance(tree.segments[i].midpoint, lastSelectedMidpoint);
+            if (dist < minDist)
             {
-                float minDist = std::numeric_limits<float>::max();
-                int bestIdx = -1;
-                for (size_t i = 0; i < tree.segments.size(); ++i)
-                {
-                    float dist = glm::distance(tree.segments[i].midpoint, lastSelectedMidpoint);
-                    if (dist < minDist)
-                    {
-                        minDist = dist;
-                        bestIdx = static_cast<int>(i);
-                    }
-                }
-                selectedSegmentIndex = bestIdx;
+                minDist = dist;
+                bestIdx = static_cast<int>(i);
             }
         }
+        selectedSegmentIndex = bestIdx;
+    }
+}
+
+bool AnimationController::startProgressiveLoad(const std::string &path, SharedTree &tree, TreeRenderer &renderer)
+{
+    // Só malhas (2D/3D) têm pré-visualização; VTP é lido direto dos arrays brutos
+    if (currentMode == ModeWireframe || std::filesystem::path(path).extension() == ".vtp")
+        return false;
+    std::error_code ec;
+    uintmax_t size = std::filesystem::file_size(path, ec);
+    if (ec || size < PROGRESSIVE_MIN_BYTES)
+        return false;
+
+    m_loader.start(path);
+    m_previewSegments = 0;
+    m_previewFull = false;
+    m_previewMinRadius = std::numeric_limits<float>::max();
+    m_previewMaxRadius = 0.0f;
+    // A árvore anterior não corresponde mais à malha exibida
+    tree = std::make_shared<const ArterialTree>();
+    ++m_treeVersion;
+    renderer.beginProgressive();
+    return true;
+}
+
+void AnimationController::pollProgressiveLoad(SharedTree &tree, TreeRenderer &renderer)
+{
+    if (m_loader.isFinished())
+    {
+        std::string path = m_loader.path();
+        auto loaded = std::make_shared<ArterialTree>();
+        if (!m_loader.take(*loaded))
+            std::cerr << "Falha ao carregar frame: " << path << std::endl;
+        // Substitui a pré-visualização pela malha definitiva (ou vazia, em caso de falha)
+        tree = std::move(loaded);
+        onFrameLoaded(*tree, renderer);
+        return;
+    }
+    if (!m_loader.nodesReady() || m_previewFull)
+        return;
+    size_t ready = std::min(m_loader.readySegments(), m_previewSegments + PREVIEW_SEGMENTS_PER_FRAME);
+    // A leitura acabou e a árvore está sendo finalizada: a malha definitiva
+    // chega com isFinished()
+    if (ready <= m_previewSegments || !m_loader.beginPreview())
+        return;
+
+    const ArterialTree &partial = m_loader.partialTree();
+    for (size_t i = m_previewSegments; i < ready; ++i)
+    {
+        m_previewMinRadius = std::min(m_previewMinRadius, partial.segments[i].radius);
+        m_previewMaxRadius = std::max(m_previewMaxRadius, partial.segments[i].radius);
+    }
+    PreviewTransform transform;
+    transform.center = m_loader.previewCenter();
+    transform.scale = m_loader.previewScale();
+    // Mesma heurística de ArterialTree::normalize(), com o maior raio visto até agora
+    float maxRadiusScaled = m_previewMaxRadius * transform.scale;
+    float fixFactor = maxRadiusScaled > 0.2f ? 0.05f / maxRadiusScaled : 1.0f;
+    // A normalização e a escala de raio da interface são aplicadas nos shaders
+    transform.radiusFix = fixFactor;
+    transform.minRadius = m_previewMinRadius;
+    transform.maxRadius = m_previewMaxRadius;
+    m_previewFull = !renderer.appendProgressive(partial, m_previewSegments, ready - m_previewSegments, transform);
+    m_loader.endPreview();
+    m_previewSegments = ready;
+}
+
+void AnimationController::pollFrameRequest(SharedTree &tree, TreeRenderer &renderer)
+{
+    const int target = m_requestedFrame;
+    if (m_prefetcher.take(target, tree))
+    {
+        m_requestedFrame = -1;
+        currentFrameIndex = target;
+        m_prefetcher.setCursor(target, m_direction, m_isPlaying);
+        onFrameLoaded(*tree, renderer);
+        return;
+    }
+    if (!m_prefetcher.isPending(target))
+    {
+        // Falhou em segundo plano: tenta a leitura direta (que reporta o erro)
+        m_requestedFrame = -1;
+        currentFrameIndex = target;
+        loadCurrentFrame(tree, renderer);
+        return;
+    }
+    // Enquanto isso, exibe o frame já decodificado mais próximo do pedido
+    int nearest = m_prefetcher.nearestReady(target);
+    bool closer = nearest >= 0 &&
+                  (tree->nodes.empty() || std::abs(nearest - target) < std::abs(currentFrameIndex - target));
+    if (closer && m_prefetcher.take(nearest, tree))
+    {
+        currentFrameIndex = nearest;
+        onFrameLoaded(*tree, renderer);
     }
 }
 
-void AnimationController::update(float deltaTime, ArterialTree &tree, TreeRenderer &renderer)
+void AnimationController::update(float deltaTime, SharedTree &tree, TreeRenderer &renderer)
 {
+    // Frame grande em leitura: avança a pré-visualização e segura a reprodução
+    if (m_loader.isActive())
+    {
+        pollProgressiveLoad(tree, renderer);
+        return;
+    }
+    // Navegação pela timeline: no máximo uma malha reconstruída por quadro
+    if (m_requestedFrame >= 0)
+    {
+        pollFrameRequest(tree, renderer);
+        return;
+    }
+
     // Garante carregamento inicial se a árvore estiver vazia e tivermos arquivos
-    if (tree.nodes.empty() && !currentPlaylist.empty())
+    if (tree->nodes.empty() && !currentPlaylist.empty())
     {
         loadCurrentFrame(tree, renderer);
     }
@@ -182,12 +367,18 @@ void AnimationController::update(float deltaTime, ArterialTree &tree, TreeRender
 
         if (timeAccumulator >= timePerFrame)
         {
-            timeAccumulator = 0.0f;
-            currentFrameIndex++;
-            if (currentFrameIndex >= (int)currentPlaylist.size())
+            int next = currentFrameIndex + 1;
+            if (next >= (int)currentPlaylist.size())
             {
-                currentFrameIndex = 0;
+                next = 0;
             }
+            // Próximo frame ainda em decodificação: mantém o atual em vez de
+            // travar a renderização com uma leitura síncrona
+            if (m_prefetcher.isPending(next))
+                return;
+            timeAccumulator = 0.0f;
+            currentFrameIndex = next;
+            m_direction = 1;
             loadCurrentFrame(tree, renderer);
         }
     }
@@ -204,7 +395,7 @@ int AnimationController::getCurrentDatasetIndex() const
     return currentDatasetIndex;
 }
 
-void AnimationController::setDatasetIndex(int index, ArterialTree &tree, TreeRenderer &renderer)
+void AnimationController::setDatasetIndex(int index, SharedTree &tree, TreeRenderer &renderer)
 {
     if (index >= 0 && index < (int)availableDatasets.size())
     {
@@ -218,7 +409,8 @@ void AnimationController::setDatasetIndex(int index, ArterialTree &tree, TreeRen
 
 int AnimationController::getCurrentFrameIndex() const
 {
-    return currentFrameIndex;
+    // A timeline acompanha o pedido, não o frame ainda em exibição
+    return m_requestedFrame >= 0 ? m_requestedFrame : currentFrameIndex;
 }
 
 int AnimationController::getTotalFrames() const
@@ -226,13 +418,27 @@ int AnimationController::getTotalFrames() const
     return (int)currentPlaylist.size();
 }
 
-void AnimationController::setFrameIndex(int index, ArterialTree &tree, TreeRenderer &renderer)
+void AnimationController::setFrameIndex(int index, SharedTree &tree)
 {
     if (index >= 0 && index < (int)currentPlaylist.size())
     {
-        currentFrameIndex = index;
         m_isPlaying = false; // Pausa se o usuário mexer na timeline
-        loadCurrentFrame(tree, renderer);
+        const int target = getCurrentFrameIndex();
+        if (index == target)
+            return;
+        m_direction = (index > target) ? 1 : -1;
+        // A pré-visualização de um frame grande deixou de interessar
+        m_loader.cancel();
+        if (index == currentFrameIndex && !tree->nodes.empty())
+        {
+            // Voltou ao frame em exibição antes de o pedido ficar pronto
+            m_requestedFrame = -1;
+            m_prefetcher.setCursor(currentFrameIndex, m_direction, m_isPlaying);
+            return;
+        }
+        // Sem leitura síncrona: update() exibe o frame quando ficar pronto
+        m_requestedFrame = index;
+        m_prefetcher.request(index, m_direction);
     }
 }
 
@@ -244,6 +450,21 @@ bool AnimationController::isPlaying() const
 void AnimationController::togglePlay()
 {
     m_isPlaying = !m_isPlaying;
+    // Reproduzindo só interessam os frames à frente (um pedido pendente
+    // mantém a janela até ser exibido)
+    if (!currentPlaylist.empty() && m_requestedFrame < 0)
+        m_prefetcher.setCursor(currentFrameIndex, m_direction, m_isPlaying);
+}
+
+void AnimationController::setPreloadAll(bool enabled)
+{
+    m_prefetcher.setPreloadAll(enabled);
+    if (currentPlaylist.empty())
+        return;
+    if (m_requestedFrame >= 0)
+        m_prefetcher.request(m_requestedFrame, m_direction);
+    else
+        m_prefetcher.setCursor(currentFrameIndex, m_direction, m_isPlaying);
 }
 
 float &AnimationController::getSpeedMultiplierRef()
@@ -8,25 +8,51 @@
  * Autor: Mateus Honorato
  * Data: Fevereiro/2026
  * Descrição:
- * Implementa a normalização da árvore arterial.
+ * Implementa a normalização da árvore arterial e utilitários de consistência.
  */
 
 #include "ArterialTree.hpp"
+#include "ParallelUtils.hpp"
 #include <limits>
 #include <algorithm>
+#include <utility>
+
+namespace
+{
+    // Abaixo disso o custo de criar threads supera o do próprio laço
+    const size_t MIN_ITEMS_PER_TASK = 1 << 16;
+}
 
 void ArterialTree::normalize()
 {
     if (nodes.empty())
-        return;
-    // 1. Computar caixa delimitadora
-    glm::vec3 minPos(std::numeric_limits<float>::max());
-    glm::vec3 maxPos(-std::numeric_limits<float>::max());
-    for (const auto &node : nodes)
     {
-        minPos = glm::min(minPos, node.position);
-        maxPos = glm::max(maxPos, node.position);
+        normCenter = glm::vec3(0.0f);
+        normScale = 1.0f;
+        normRadiusFix = 1.0f;
+        rawPositions.clear();
+        rawRadii.clear();
+        return;
     }
+    // 1. Computar caixa delimitadora (redução paralela; min/max independe da ordem)
+    using Bounds = std::pair<glm::vec3, glm::vec3>;
+    const Bounds empty(glm::vec3(std::numeric_limits<float>::max()), glm::vec3(-std::numeric_limits<float>::max()));
+    Bounds bounds = ParallelUtils::parallelReduce(
+        nodes.size(), MIN_ITEMS_PER_TASK, empty,
+        [this, &empty](size_t begin, size_t end)
+        {
+            Bounds b = empty;
+            for (size_t i = begin; i < end; ++i)
+            {
+                b.first = glm::min(b.first, nodes[i].position);
+                b.second = glm::max(b.second, nodes[i].position);
+            }
+            return b;
+        },
+        [](const Bounds &a, const Bounds &b)
+        { return Bounds(glm::min(a.first, b.first), glm::max(a.second, b.second)); });
+    const glm::vec3 minPos = bounds.first;
+    const glm::vec3 maxPos = bounds.second;
     // 2. Computar dimensão máxima
     float maxDim = glm::max(glm::max(maxPos.x - minPos.x, maxPos.y - minPos.y), maxPos.z - minPos.z);
     if (maxDim < 1e-6f)
@@ -35,12 +61,18 @@ void ArterialTree::normalize()
     float scaleFactor = 2.0f / maxDim;
     // 4. Centralizar na raiz (sem jitter)
     glm::vec3 center = nodes[0].position;
-    for (auto &node : nodes)
-        node.position = (node.position - center) * scaleFactor;
     // 5. Encontrar maior raio
-    float maxRadius = 0.0f;
-    for (const auto &seg : segments)
-        maxRadius = std::max(maxRadius, seg.radius);
+    float maxRadius = ParallelUtils::parallelReduce(
+        segments.size(), MIN_ITEMS_PER_TASK, 0.0f,
+        [this](size_t begin, size_t end)
+        {
+            float m = 0.0f;
+            for (size_t i = begin; i < end; ++i)
+                m = std::max(m, segments[i].radius);
+            return m;
+        },
+        [](float a, float b)
+        { return std::max(a, b); });
     float maxRadiusScaled = maxRadius * scaleFactor;
     float fixFactor = 1.0f;
     // 6. Heurística: se maxRadiusScaled for grande, reduzir raios
@@ -48,7 +80,60 @@ void ArterialTree::normalize()
     {
         fixFactor = 0.05f / maxRadiusScaled;
     }
-    // 7. Aplicar escala e correção aos raios
-    for (auto &seg : segments)
-        seg.radius = seg.radius * scaleFactor * fixFactor;
+    // 7. Aplicar escala às posições e escala e correção aos raios
+    applyNormalization(center, scaleFactor, fixFactor);
+}
+
+void ArterialTree::applyNormalization(const glm::vec3 &center, float scale, float radiusFix)
+{
+    rawPositions.resize(nodes.size());
+    rawRadii.resize(segments.size());
+    ParallelUtils::parallelFor(nodes.size(), MIN_ITEMS_PER_TASK, [&](size_t begin, size_t end)
+                               {
+        for (size_t i = begin; i < end; ++i)
+        {
+            rawPositions[i] = nodes[i].position;
+            nodes[i].position = (nodes[i].position - center) * scale;
+        } });
+    ParallelUtils::parallelFor(segments.size(), MIN_ITEMS_PER_TASK, [&](size_t begin, size_t end)
+                               {
+        for (size_t i = begin; i < end; ++i)
+        {
+            rawRadii[i] = segments[i].radius;
+            segments[i].radius = segments[i].radius * scale * radiusFix;
+        } });
+    // Metadados usados pelo cache binário .atb e pelo renderizador
+    normCenter = center;
+    normScale = scale;
+    normRadiusFix = radiusFix;
+}
+
+void ArterialTree::updateMidpoints()
+{
+    ParallelUtils::parallelFor(segments.size(), MIN_ITEMS_PER_TASK, [this](size_t begin, size_t end)
+                               {
+        for (size_t i = begin; i < end; ++i)
+        {
+            ArterialSegment &seg = segments[i];
+            seg.midpoint = (nodes[seg.indexA].position + nodes[seg.indexB].position) / 2.0f;
+        } });
+}
+
+bool ArterialTree::hasValidIndices() const
+{
+    const int nodeCount = static_cast<int>(nodes.size());
+    return ParallelUtils::parallelReduce(
+        segments.size(), MIN_ITEMS_PER_TASK, true,
+        [this, nodeCount](size_t begin, size_t end)
+        {
+            int minIndex = 0, maxIndex = -1;
+            for (size_t i = begin; i < end; ++i)
+            {
+                minIndex = std::min(minIndex, std::min(segments[i].indexA, segments[i].indexB));
+                maxIndex = std::max(maxIndex, std::max(segments[i].indexA, segments[i].indexB));
+            }
+            return minIndex >= 0 && maxIndex < nodeCount;
+        },
+        [](bool a, bool b)
+        { return a && b; });
 }
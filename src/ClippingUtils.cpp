@@ -16,6 +16,7 @@
  */
 
 #include "ClippingUtils.hpp"
+#include "SimdUtils.hpp"
 
 // Implementação do Algoritmo de Liang-Barsky para recorte de segmentos de reta,
 // conforme detalhado na Aula 17 da disciplina.
@@ -67,4 +68,110 @@ bool ClippingUtils::clipSegment(glm::vec3 &p0, glm::vec3 &p1, const glm::vec3 &b
     p1 = origP0 + t1 * p;
     p0 = origP0 + t0 * p;
     return true;
-}
\ No newline at end of file
+}
+namespace
+{
+#if SIMD_X86
+    // Máscaras em vez de desvios: pistas paralelas ao eixo (d == 0) não
+    // alteram [t0, t1] e só exigem a coordenada entre os planos. As
+    // comparações e max/min reproduzem os `if` da versão escalar.
+    inline __m128 select(__m128 mask, __m128 a, __m128 b)
+    {
+        return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+    }
+
+    // Retorna quantos segmentos foram tratados (múltiplo de 4)
+    size_t clipSegmentsSSE(const glm::vec3 &boxMin, const glm::vec3 &boxMax, const SegmentSoA &segments,
+                           size_t begin, size_t count, uint8_t *outInside)
+    {
+        const float *first[3] = {segments.ax.data() + begin, segments.ay.data() + begin, segments.az.data() + begin};
+        const float *second[3] = {segments.bx.data() + begin, segments.by.data() + begin, segments.bz.data() + begin};
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 one = _mm_set1_ps(1.0f);
+        const __m128 allSet = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4)
+        {
+            __m128 t0 = zero, t1 = one, inside = allSet;
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                const __m128 min = _mm_set1_ps(boxMin[axis]);
+                const __m128 max = _mm_set1_ps(boxMax[axis]);
+                const __m128 q0 = _mm_loadu_ps(first[axis] + i);
+                const __m128 d = _mm_sub_ps(_mm_loadu_ps(second[axis] + i), q0);
+                const __m128 tMin = _mm_div_ps(_mm_sub_ps(min, q0), d);
+                const __m128 tMax = _mm_div_ps(_mm_sub_ps(max, q0), d);
+                const __m128 positive = _mm_cmpgt_ps(d, zero);
+                const __m128 moving = _mm_cmpneq_ps(d, zero);
+                const __m128 enter = select(positive, tMin, tMax);
+                const __m128 leave = select(positive, tMax, tMin);
+                t0 = select(moving, _mm_max_ps(enter, t0), t0);
+                t1 = select(moving, _mm_min_ps(leave, t1), t1);
+                const __m128 within = _mm_and_ps(_mm_cmpnlt_ps(q0, min), _mm_cmpngt_ps(q0, max));
+                inside = _mm_and_ps(inside, _mm_or_ps(moving, within));
+            }
+            const int bits = _mm_movemask_ps(_mm_and_ps(inside, _mm_cmpngt_ps(t0, t1)));
+            for (int lane = 0; lane < 4; ++lane)
+                outInside[i + lane] = static_cast<uint8_t>((bits >> lane) & 1);
+        }
+        return i;
+    }
+
+    // Mesmo laço da versão SSE em pistas de 8 (múltiplo de 8)
+    SIMD_TARGET_AVX2 size_t clipSegmentsAVX2(const glm::vec3 &boxMin, const glm::vec3 &boxMax,
+                                             const SegmentSoA &segments, size_t begin, size_t count,
+                                             uint8_t *outInside)
+    {
+        const float *first[3] = {segments.ax.data() + begin, segments.ay.data() + begin, segments.az.data() + begin};
+        const float *second[3] = {segments.bx.data() + begin, segments.by.data() + begin, segments.bz.data() + begin};
+        const __m256 zero = _mm256_setzero_ps();
+        const __m256 one = _mm256_set1_ps(1.0f);
+        const __m256 allSet = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8)
+        {
+            __m256 t0 = zero, t1 = one, inside = allSet;
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                const __m256 min = _mm256_set1_ps(boxMin[axis]);
+                const __m256 max = _mm256_set1_ps(boxMax[axis]);
+                const __m256 q0 = _mm256_loadu_ps(first[axis] + i);
+                const __m256 d = _mm256_sub_ps(_mm256_loadu_ps(second[axis] + i), q0);
+                const __m256 tMin = _mm256_div_ps(_mm256_sub_ps(min, q0), d);
+                const __m256 tMax = _mm256_div_ps(_mm256_sub_ps(max, q0), d);
+                const __m256 positive = _mm256_cmp_ps(d, zero, _CMP_GT_OQ);
+                const __m256 moving = _mm256_cmp_ps(d, zero, _CMP_NEQ_UQ);
+                const __m256 enter = _mm256_blendv_ps(tMax, tMin, positive);
+                const __m256 leave = _mm256_blendv_ps(tMin, tMax, positive);
+                t0 = _mm256_blendv_ps(t0, _mm256_max_ps(enter, t0), moving);
+                t1 = _mm256_blendv_ps(t1, _mm256_min_ps(leave, t1), moving);
+                const __m256 within = _mm256_and_ps(_mm256_cmp_ps(q0, min, _CMP_NLT_UQ),
+                                                    _mm256_cmp_ps(q0, max, _CMP_NGT_UQ));
+                inside = _mm256_and_ps(inside, _mm256_or_ps(moving, within));
+            }
+            const int bits = _mm256_movemask_ps(_mm256_and_ps(inside, _mm256_cmp_ps(t0, t1, _CMP_NGT_UQ)));
+            for (int lane = 0; lane < 8; ++lane)
+                outInside[i + lane] = static_cast<uint8_t>((bits >> lane) & 1);
+        }
+        return i;
+    }
+#endif
+}
+
+void ClippingUtils::clipSegments(const glm::vec3 &boxMin, const glm::vec3 &boxMax, const SegmentSoA &segments,
+                                 size_t begin, size_t count, uint8_t *outInside)
+{
+    size_t done = 0;
+#if SIMD_X86
+    done = SimdUtils::hasAVX2() ? clipSegmentsAVX2(boxMin, boxMax, segments, begin, count, outInside)
+                                : clipSegmentsSSE(boxMin, boxMax, segments, begin, count, outInside);
+#endif
+    // Restante (e CPUs sem SIMD): a versão escalar
+    for (size_t i = done; i < count; ++i)
+    {
+        const size_t s = begin + i;
+        glm::vec3 p0(segments.ax[s], segments.ay[s], segments.az[s]);
+        glm::vec3 p1(segments.bx[s], segments.by[s], segments.bz[s]);
+        outInside[i] = clipSegment(p0, p1, boxMin, boxMax) ? 1 : 0;
+    }
+}
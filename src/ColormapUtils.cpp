@@ -0,0 +1,72 @@
+/*
+ * Universidade Federal de Ouro Preto - UFOP
+ * Departamento de Computação - DECOM
+ * Disciplina: BCC327 - Computação Gráfica (2025.2)
+ * Professor: Rafael Bonfim
+ * Trabalho Prático: Visualizador de Árvores Arteriais (CCO)
+ * Arquivo: ColormapUtils.cpp
+ * Autor: Mateus Honorato
+ * Data: Outubro/2026
+ * Descrição:
+ * Implementa os mapas de cores embutidos como paradas igualmente espaçadas,
+ * interpoladas linearmente, e a geração das LUTs de 8 bits.
+ *
+ * Créditos:
+ * Paradas do Viridis e do Cool-Warm aproximadas dos mapas publicados por
+ * van der Walt & Smith (matplotlib) e Moreland (2009).
+ */
+
+#include <algorithm>
+#include <cmath>
+
+#include "ColormapUtils.hpp"
+
+namespace
+{
+    struct ColormapStops
+    {
+        const char *name;
+        int count;
+        glm::vec3 stops[9];
+    };
+
+    const ColormapStops COLORMAPS[ColormapUtils::COUNT] = {
+        {"Calor", 3, {{0.0f, 0.0f, 1.0f}, {0.0f, 1.0f, 0.0f}, {1.0f, 0.0f, 0.0f}}},
+        {"Viridis", 9, {{0.267f, 0.005f, 0.329f}, {0.283f, 0.141f, 0.458f}, {0.254f, 0.265f, 0.530f},
+                        {0.207f, 0.372f, 0.553f}, {0.164f, 0.471f, 0.558f}, {0.128f, 0.567f, 0.551f},
+                        {0.135f, 0.659f, 0.518f}, {0.478f, 0.821f, 0.318f}, {0.993f, 0.906f, 0.144f}}},
+        {"Frio-Quente", 3, {{0.230f, 0.299f, 0.754f}, {0.865f, 0.865f, 0.865f}, {0.706f, 0.016f, 0.150f}}},
+        {"Escala de Cinza", 2, {{0.0f, 0.0f, 0.0f}, {1.0f, 1.0f, 1.0f}}},
+    };
+
+    const ColormapStops &stopsOf(Colormap map)
+    {
+        int index = static_cast<int>(map);
+        if (index < 0 || index >= ColormapUtils::COUNT)
+            index = 0;
+        return COLORMAPS[index];
+    }
+}
+
+const char *ColormapUtils::name(Colormap map)
+{
+    return stopsOf(map).name;
+}
+
+glm::vec3 ColormapUtils::sample(Colormap map, float t)
+{
+    const ColormapStops &cm = stopsOf(map);
+    t = std::clamp(t, 0.0f, 1.0f) * (cm.count - 1);
+    const int i = std::min(static_cast<int>(t), cm.count - 2);
+    return glm::mix(cm.stops[i], cm.stops[i + 1], t - i);
+}
+
+void ColormapUtils::buildLut(Colormap map, unsigned char *rgb)
+{
+    for (int i = 0; i < LUT_SIZE; ++i)
+    {
+        glm::vec3 color = sample(map, static_cast<float>(i) / (LUT_SIZE - 1));
+        for (int c = 0; c < 3; ++c)
+            *rgb++ = static_cast<unsigned char>(std::lround(std::clamp(color[c], 0.0f, 1.0f) * 255.0f));
+    }
+}
@@ -0,0 +1,593 @@
+/*
+ * Universidade Federal de Ouro Preto - UFOP
+ * Departamento de Computação - DECOM
+ * Disciplina: BCC327 - Computação Gráfica (2025.2)
+ * Professor: Rafael Bonfim
+ * Trabalho Prático: Visualizador de Árvores Arteriais (CCO)
+ * Arquivo: Decompressor.cpp
+ * Autor: Mateus Honorato
+ * Data: Outubro/2026
+ * Descrição:
+ * Implementa a leitura de contêineres gzip (RFC 1952) e zlib (RFC 1950) e
+ * um decodificador deflate (RFC 1951) incremental. A entrada comprimida é
+ * lida direto do arquivo mapeado e a saída é entregue aos poucos, mantendo
+ * em memória apenas a janela de referência e um bloco descomprimido.
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include "Decompressor.hpp"
+#include "ByteOrder.hpp"
+
+namespace
+{
+    // Flags do cabeçalho gzip
+    const unsigned char GZIP_FHCRC = 0x02;
+    const unsigned char GZIP_FEXTRA = 0x04;
+    const unsigned char GZIP_FNAME = 0x08;
+    const unsigned char GZIP_FCOMMENT = 0x10;
+    // Flag do cabeçalho zlib para dicionário predefinido (não usado em arquivos)
+    const unsigned char ZLIB_FDICT = 0x20;
+
+    // Distância máxima de uma cópia do deflate e maior cópia possível
+    const size_t HISTORY_SIZE = 32768;
+    const size_t MAX_MATCH = 258;
+    // Bytes descomprimidos de uma vez entre duas entregas
+    const size_t OUTPUT_CHUNK = 1 << 18;
+    // Nenhum fluxo deflate expande mais que ~1032:1
+    const size_t MAX_RATIO = 1032;
+
+    const uint16_t LENGTH_BASE[29] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+                                      35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+    const uint8_t LENGTH_EXTRA[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+                                      3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+    const uint16_t DIST_BASE[30] = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129,
+                                    193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097,
+                                    6145, 8193, 12289, 16385, 24577};
+    const uint8_t DIST_EXTRA[30] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6,
+                                    6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+    // Ordem dos comprimentos do código de comprimentos nos blocos dinâmicos
+    const uint8_t CODE_LENGTH_ORDER[19] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+    // Avança `pos` até depois do terminador nulo de um campo de texto do cabeçalho
+    bool skipZeroTerminated(const unsigned char *data, size_t size, size_t &pos)
+    {
+        while (pos < size && data[pos] != 0)
+            ++pos;
+        if (pos >= size)
+            return false;
+        ++pos;
+        return true;
+    }
+
+    uint32_t crc32Update(uint32_t crc, const unsigned char *data, size_t size)
+    {
+        static const auto table = []()
+        {
+            std::vector<uint32_t> t(256);
+            for (uint32_t i = 0; i < 256; ++i)
+            {
+                uint32_t c = i;
+                for (int k = 0; k < 8; ++k)
+                    c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                t[i] = c;
+            }
+            return t;
+        }();
+        crc = ~crc;
+        for (size_t i = 0; i < size; ++i)
+            crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+        return ~crc;
+    }
+
+    uint32_t adler32Update(uint32_t adler, const unsigned char *data, size_t size)
+    {
+        uint32_t a = adler & 0xffff, b = adler >> 16;
+        while (size > 0)
+        {
+            // Maior bloco cuja soma não estoura 32 bits antes do módulo
+            const size_t n = std::min<size_t>(size, 5552);
+            for (size_t i = 0; i < n; ++i)
+            {
+                a += data[i];
+                b += a;
+            }
+            a %= 65521;
+            b %= 65521;
+            data += n;
+            size -= n;
+        }
+        return (b << 16) | a;
+    }
+
+    unsigned reverseBits(unsigned code, unsigned length)
+    {
+        unsigned result = 0;
+        for (unsigned i = 0; i < length; ++i, code >>= 1)
+            result = (result << 1) | (code & 1);
+        return result;
+    }
+}
+
+Decompressor::Format Decompressor::detect(const char *data, size_t size)
+{
+    if (size < 2)
+        return Format::None;
+    const unsigned char b0 = static_cast<unsigned char>(data[0]);
+    const unsigned char b1 = static_cast<unsigned char>(data[1]);
+    if (b0 == 0x1f && b1 == 0x8b)
+        return Format::Gzip;
+    // zlib: método 8 (deflate), janela <= 32K e checksum do cabeçalho múltiplo de 31.
+    // Um VTK legado começa com "# vtk", que nunca satisfaz essas condições.
+    if ((b0 & 0x0f) == 8 && (b0 >> 4) <= 7 && ((b0 << 8) | b1) % 31 == 0)
+        return Format::Zlib;
+    return Format::None;
+}
+
+bool InflateStream::open(const char *data, size_t size, const std::string &filepath)
+{
+    *this = InflateStream();
+    m_path = filepath;
+    m_in = reinterpret_cast<const unsigned char *>(data);
+    m_inSize = size;
+    m_format = Decompressor::detect(data, size);
+
+    if (m_format == Decompressor::Format::Zlib)
+    {
+        if (m_in[1] & ZLIB_FDICT)
+            return fail("Fluxo zlib com dicionário predefinido não suportado");
+        m_inPos = 2;
+    }
+    else if (m_format == Decompressor::Format::Gzip)
+    {
+        // Cabeçalho fixo de 10 bytes + campos opcionais
+        if (size < 18 || m_in[2] != 8)
+            return fail("Cabeçalho gzip inválido");
+        const unsigned char flags = m_in[3];
+        size_t pos = 10;
+        bool headerOk = true;
+        if (flags & GZIP_FEXTRA)
+        {
+            const size_t extraLen = m_in[pos] | (static_cast<size_t>(m_in[pos + 1]) << 8);
+            pos += 2 + extraLen;
+        }
+        if (flags & GZIP_FNAME)
+            headerOk &= pos < size && skipZeroTerminated(m_in, size, pos);
+        if (flags & GZIP_FCOMMENT)
+            headerOk &= pos < size && skipZeroTerminated(m_in, size, pos);
+        if (flags & GZIP_FHCRC)
+            pos += 2;
+        if (!headerOk || pos + 8 > size)
+            return fail("Arquivo gzip truncado");
+        m_inPos = pos;
+    }
+    else
+    {
+        return fail("Formato comprimido não reconhecido");
+    }
+
+    m_window.resize(HISTORY_SIZE + OUTPUT_CHUNK + MAX_MATCH);
+    m_state = State::BlockHeader;
+    return true;
+}
+
+bool InflateStream::fail(const char *message)
+{
+    if (m_state != State::Error)
+        std::cerr << "[Decompressor] " << message << ": " << m_path << std::endl;
+    m_state = State::Error;
+    return false;
+}
+
+size_t InflateStream::sizeBound() const
+{
+    const size_t pending = m_outEnd - m_outRead;
+    const size_t inputLeft = m_inSize - std::min(m_inPos, m_inSize) + m_bitCount / 8;
+    if (inputLeft > (std::numeric_limits<size_t>::max() - pending) / MAX_RATIO)
+        return std::numeric_limits<size_t>::max();
+    return pending + inputLeft * MAX_RATIO;
+}
+
+void InflateStream::refill()
+{
+    if (m_inPos + 8 <= m_inSize)
+    {
+        // Oito bytes de uma vez; os bits além de m_bitCount repetem os
+        // próximos bytes da entrada e são regravados iguais na recarga seguinte
+        m_bitBuffer |= ByteOrder::load<uint64_t>(reinterpret_cast<const char *>(m_in + m_inPos), false) << m_bitCount;
+        m_inPos += (63 - m_bitCount) >> 3;
+        m_bitCount |= 56;
+        return;
+    }
+    while (m_bitCount <= 56 && m_inPos < m_inSize)
+    {
+        m_bitBuffer |= static_cast<uint64_t>(m_in[m_inPos++]) << m_bitCount;
+        m_bitCount += 8;
+    }
+}
+
+bool InflateStream::bits(unsigned n, uint32_t &out)
+{
+    if (m_bitCount < n)
+    {
+        refill();
+        if (m_bitCount < n)
+            return fail("Arquivo comprimido truncado");
+    }
+    out = static_cast<uint32_t>(m_bitBuffer & ((uint64_t(1) << n) - 1));
+    m_bitBuffer >>= n;
+    m_bitCount -= n;
+    return true;
+}
+
+int InflateStream::decodeSymbol(const HuffmanTable &table)
+{
+    if (m_bitCount < 15)
+        refill();
+    const uint16_t entry = table.fast[m_bitBuffer & ((1u << HuffmanTable::FAST_BITS) - 1)];
+    if (entry != 0)
+    {
+        const unsigned length = entry & 15;
+        if (length > m_bitCount)
+        {
+            fail("Arquivo comprimido truncado");
+            return -1;
+        }
+        m_bitBuffer >>= length;
+        m_bitCount -= length;
+        return entry >> 4;
+    }
+
+    // Códigos longos: decodificação canônica bit a bit
+    int code = 0, first = 0, index = 0;
+    for (unsigned length = 1; length <= 15; ++length)
+    {
+        if (length > m_bitCount)
+        {
+            fail("Arquivo comprimido truncado");
+            return -1;
+        }
+        code |= static_cast<int>((m_bitBuffer >> (length - 1)) & 1);
+        const int count = table.count[length];
+        if (code - first < count)
+        {
+            m_bitBuffer >>= length;
+            m_bitCount -= length;
+            return table.symbol[index + code - first];
+        }
+        index += count;
+        first = (first + count) << 1;
+        code <<= 1;
+    }
+    fail("Código de Huffman inválido");
+    return -1;
+}
+
+bool InflateStream::buildTable(HuffmanTable &table, const uint8_t *lengths, unsigned count)
+{
+    std::memset(table.count, 0, sizeof(table.count));
+    for (unsigned i = 0; i < count; ++i)
+        ++table.count[lengths[i]];
+    table.count[0] = 0;
+
+    // Códigos em excesso tornam o código ambíguo; incompletos são aceitos
+    int left = 1;
+    for (unsigned length = 1; length <= 15; ++length)
+    {
+        left = (left << 1) - table.count[length];
+        if (left < 0)
+            return fail("Código de Huffman inválido");
+    }
+
+    uint16_t offset[16] = {0};
+    for (unsigned length = 1; length < 15; ++length)
+        offset[length + 1] = static_cast<uint16_t>(offset[length] + table.count[length]);
+    // Primeiro código de cada comprimento (RFC 1951, 3.2.2)
+    unsigned nextCode[16] = {0};
+    unsigned code = 0;
+    for (unsigned length = 1; length < 16; ++length)
+    {
+        nextCode[length] = code;
+        code = (code + table.count[length]) << 1;
+    }
+
+    std::memset(table.fast, 0, sizeof(table.fast));
+    for (unsigned symbol = 0; symbol < count; ++symbol)
+    {
+        const unsigned length = lengths[symbol];
+        if (length == 0)
+            continue;
+        table.symbol[offset[length]++] = static_cast<uint16_t>(symbol);
+        const unsigned symbolCode = nextCode[length]++;
+        if (length > HuffmanTable::FAST_BITS)
+            continue;
+        // Os bits chegam do menos significativo: o código entra invertido,
+        // repetido para todos os valores dos bits seguintes
+        const uint16_t entry = static_cast<uint16_t>((symbol << 4) | length);
+        for (unsigned i = reverseBits(symbolCode, length); i < (1u << HuffmanTable::FAST_BITS); i += 1u << length)
+            table.fast[i] = entry;
+    }
+    return true;
+}
+
+bool InflateStream::readDynamicTables()
+{
+    uint32_t hlit = 0, hdist = 0, hclen = 0;
+    if (!bits(5, hlit) || !bits(5, hdist) || !bits(4, hclen))
+        return false;
+    hlit += 257;
+    hdist += 1;
+    hclen += 4;
+    if (hlit > 286 || hdist > 30)
+        return fail("Fluxo deflate inválido");
+
+    uint8_t lengths[286 + 30] = {0};
+    for (uint32_t i = 0; i < hclen; ++i)
+    {
+        uint32_t length = 0;
+        if (!bits(3, length))
+            return false;
+        lengths[CODE_LENGTH_ORDER[i]] = static_cast<uint8_t>(length);
+    }
+    // A tabela de literais serve de tabela temporária do código de comprimentos
+    if (!buildTable(m_litLen, lengths, 19))
+        return false;
+    std::memset(lengths, 0, 19);
+
+    uint32_t index = 0;
+    while (index < hlit + hdist)
+    {
+        const int symbol = decodeSymbol(m_litLen);
+        if (symbol < 0)
+            return false;
+        if (symbol < 16)
+        {
+            lengths[index++] = static_cast<uint8_t>(symbol);
+            continue;
+        }
+        uint8_t value = 0;
+        uint32_t repeat = 0;
+        if (symbol == 16)
+        {
+            // Repete o comprimento anterior: inválido como primeiro símbolo
+            if (index == 0)
+                return fail("Fluxo deflate inválido");
+            if (!bits(2, repeat))
+                return false;
+            value = lengths[index - 1];
+            repeat += 3;
+        }
+        else if (symbol == 17)
+        {
+            if (!bits(3, repeat))
+                return false;
+            repeat += 3;
+        }
+        else
+        {
+            if (!bits(7, repeat))
+                return false;
+            repeat += 11;
+        }
+        if (index + repeat > hlit + hdist)
+            return fail("Fluxo deflate inválido");
+        std::memset(lengths + index, value, repeat);
+        index += repeat;
+    }
+    if (lengths[256] == 0)
+        return fail("Fluxo deflate inválido");
+    return buildTable(m_litLen, lengths, hlit) && buildTable(m_dist, lengths + hlit, hdist);
+}
+
+bool InflateStream::readBlockHeader()
+{
+    uint32_t last = 0, type = 0;
+    if (!bits(1, last) || !bits(2, type))
+        return false;
+    m_lastBlock = last != 0;
+
+    if (type == 0)
+    {
+        // Bloco sem compressão: alinha ao byte e lê LEN/NLEN
+        m_bitBuffer >>= m_bitCount & 7;
+        m_bitCount -= m_bitCount & 7;
+        uint32_t len = 0, nlen = 0;
+        if (!bits(16, len) || !bits(16, nlen))
+            return false;
+        if ((len ^ 0xffff) != nlen)
+            return fail("Fluxo deflate inválido");
+        // Devolve à entrada os bytes inteiros que estavam no buffer de bits
+        m_inPos -= m_bitCount / 8;
+        m_bitBuffer = 0;
+        m_bitCount = 0;
+        m_storedLeft = len;
+        m_state = State::Stored;
+        return true;
+    }
+    if (type == 1)
+    {
+        uint8_t lengths[288 + 30];
+        std::fill(lengths, lengths + 144, 8);
+        std::fill(lengths + 144, lengths + 256, 9);
+        std::fill(lengths + 256, lengths + 280, 7);
+        std::fill(lengths + 280, lengths + 288, 8);
+        std::fill(lengths + 288, lengths + 318, 5);
+        if (!buildTable(m_litLen, lengths, 288) || !buildTable(m_dist, lengths + 288, 30))
+            return false;
+    }
+    else if (type == 2)
+    {
+        if (!readDynamicTables())
+            return false;
+    }
+    else
+    {
+        return fail("Fluxo deflate inválido");
+    }
+    m_state = State::Huffman;
+    return true;
+}
+
+void InflateStream::produce()
+{
+    unsigned char *window = m_window.data();
+    // Uma cópia pode escrever até MAX_MATCH bytes além do limite
+    const size_t limit = m_window.size() - MAX_MATCH;
+    while (m_outEnd < limit)
+    {
+        if (m_state == State::BlockHeader)
+        {
+            if (m_lastBlock)
+            {
+                m_state = State::Trailer;
+                return;
+            }
+            if (!readBlockHeader())
+                return;
+        }
+        else if (m_state == State::Stored)
+        {
+            const size_t n = std::min({m_storedLeft, limit - m_outEnd, m_inSize - m_inPos});
+            if (n == 0 && m_storedLeft > 0)
+            {
+                fail("Arquivo comprimido truncado");
+                return;
+            }
+            std::memcpy(window + m_outEnd, m_in + m_inPos, n);
+            m_outEnd += n;
+            m_inPos += n;
+            m_storedLeft -= n;
+            if (m_storedLeft == 0)
+                m_state = State::BlockHeader;
+        }
+        else if (m_state == State::Huffman)
+        {
+            while (m_outEnd < limit)
+            {
+                int symbol = decodeSymbol(m_litLen);
+                if (symbol < 0)
+                    return;
+                if (symbol < 256)
+                {
+                    window[m_outEnd++] = static_cast<unsigned char>(symbol);
+                    continue;
+                }
+                if (symbol == 256)
+                {
+                    m_state = State::BlockHeader;
+                    break;
+                }
+                symbol -= 257;
+                if (symbol >= 29)
+                {
+                    fail("Fluxo deflate inválido");
+                    return;
+                }
+                uint32_t extra = 0;
+                if (!bits(LENGTH_EXTRA[symbol], extra))
+                    return;
+                const size_t length = LENGTH_BASE[symbol] + extra;
+                const int distSymbol = decodeSymbol(m_dist);
+                if (distSymbol < 0)
+                    return;
+                if (distSymbol >= 30 || !bits(DIST_EXTRA[distSymbol], extra))
+                {
+                    fail("Fluxo deflate inválido");
+                    return;
+                }
+                const size_t distance = DIST_BASE[distSymbol] + extra;
+                if (distance > m_outEnd)
+                {
+                    fail("Fluxo deflate inválido");
+                    return;
+                }
+                // Origem e destino podem se sobrepor (repetição de padrão)
+                const unsigned char *src = window + m_outEnd - distance;
+                unsigned char *dst = window + m_outEnd;
+                for (size_t i = 0; i < length; ++i)
+                    dst[i] = src[i];
+                m_outEnd += length;
+            }
+        }
+        else
+        {
+            return;
+        }
+    }
+}
+
+void InflateStream::checkTrailer()
+{
+    // Descarta o resto do byte atual e devolve à entrada os bytes inteiros
+    m_inPos -= m_bitCount / 8;
+    m_bitBuffer = 0;
+    m_bitCount = 0;
+
+    const char *trailer = reinterpret_cast<const char *>(m_in + m_inPos);
+    if (m_format == Decompressor::Format::Gzip)
+    {
+        // CRC32 e tamanho módulo 2^32 (ISIZE), little-endian
+        if (m_inPos + 8 > m_inSize)
+        {
+            fail("Arquivo gzip truncado");
+            return;
+        }
+        if (ByteOrder::load<uint32_t>(trailer, false) != m_crc ||
+            ByteOrder::load<uint32_t>(trailer + 4, false) != static_cast<uint32_t>(m_total))
+        {
+            fail("CRC32 ou tamanho gzip não confere");
+            return;
+        }
+    }
+    else
+    {
+        if (m_inPos + 4 > m_inSize)
+        {
+            fail("Arquivo zlib truncado");
+            return;
+        }
+        if (ByteOrder::load<uint32_t>(trailer, true) != m_adler)
+        {
+            fail("Adler-32 não confere");
+            return;
+        }
+    }
+    m_state = State::Done;
+}
+
+size_t InflateStream::read(char *out, size_t max)
+{
+    size_t done = 0;
+    while (done < max)
+    {
+        if (m_outRead == m_outEnd)
+        {
+            if (m_state == State::Trailer)
+                checkTrailer();
+            if (m_state == State::Done || m_state == State::Error)
+                break;
+            // Tudo já foi entregue: mantém só a janela de referência
+            if (m_outEnd + MAX_MATCH >= m_window.size())
+            {
+                const size_t keep = std::min(m_outEnd, HISTORY_SIZE);
+                std::memmove(m_window.data(), m_window.data() + m_outEnd - keep, keep);
+                m_outEnd = m_outRead = keep;
+            }
+            produce();
+            continue;
+        }
+        const size_t n = std::min(max - done, m_outEnd - m_outRead);
+        const unsigned char *src = m_window.data() + m_outRead;
+        if (m_format == Decompressor::Format::Gzip)
+            m_crc = crc32Update(m_crc, src, n);
+        else
+            m_adler = adler32Update(m_adler, src, n);
+        std::memcpy(out + done, src, n);
+        m_outRead += n;
+        m_total += n;
+        done += n;
+    }
+    return done;
+}
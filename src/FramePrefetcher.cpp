@@ -0,0 +1,264 @@
+/*
+ * Universidade Federal de Ouro Preto - UFOP
+ * Departamento de Computação - DECOM
+ * Disciplina: BCC327 - Computação Gráfica (2025.2)
+ * Professor: Rafael Bonfim
+ * Trabalho Prático: Visualizador de Árvores Arteriais (CCO)
+ * Arquivo: FramePrefetcher.cpp
+ * Autor: Mateus Honorato
+ * Data: Outubro/2026
+ * Descrição:
+ * Implementa o pré-carregador de frames. Os workers escolhem, sob um mutex,
+ * o frame de maior prioridade ainda sem slot, decodificam fora do mutex e
+ * publicam a árvore pronta no slot reservado.
+ */
+
+#include <algorithm>
+#include <cstdlib>
+#include <utility>
+#include "FramePrefetcher.hpp"
+#include "ParallelUtils.hpp"
+
+FramePrefetcher::FramePrefetcher(LoadFunction load, size_t capacity)
+    : m_load(load), m_capacity(std::max<size_t>(capacity, 1))
+{
+    m_slots.resize(m_capacity);
+    m_cancel.reset(new std::atomic<bool>[m_slots.size()]());
+    startWorkers();
+}
+
+FramePrefetcher::~FramePrefetcher()
+{
+    stopWorkers();
+}
+
+void FramePrefetcher::startWorkers()
+{
+    m_stop = false;
+    const unsigned count = m_preloadAll ? ParallelUtils::threadCount() : 1;
+    for (unsigned i = 0; i < count; ++i)
+        m_workers.emplace_back(&FramePrefetcher::workerLoop, this);
+}
+
+void FramePrefetcher::stopWorkers()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+    // Decodificações em andamento terminam antes do join
+    for (auto &w : m_workers)
+        w.join();
+    m_workers.clear();
+}
+
+void FramePrefetcher::setPlaylist(const std::vector<std::string> &paths)
+{
+    stopWorkers();
+    m_paths = paths;
+    m_wanted.clear();
+    m_slots.clear();
+    m_slots.resize(m_preloadAll ? std::max<size_t>(m_paths.size(), 1) : m_capacity);
+    m_cancel.reset(new std::atomic<bool>[m_slots.size()]());
+    startWorkers();
+}
+
+void FramePrefetcher::setPreloadAll(bool enabled)
+{
+    if (enabled == m_preloadAll)
+        return;
+    m_preloadAll = enabled;
+    // Reinicia com o novo número de workers e slots
+    setPlaylist(std::vector<std::string>(m_paths));
+    if (enabled)
+        setCursor(0, 1, false);
+}
+
+int FramePrefetcher::findSlot(int frame) const
+{
+    for (size_t i = 0; i < m_slots.size(); ++i)
+    {
+        if (m_slots[i].frame == frame && m_slots[i].state != SlotState::Empty)
+            return static_cast<int>(i);
+    }
+    return -1;
+}
+
+bool FramePrefetcher::isWanted(int frame) const
+{
+    return std::find(m_wanted.begin(), m_wanted.end(), frame) != m_wanted.end();
+}
+
+void FramePrefetcher::setCursor(int frame, int direction, bool playing)
+{
+    setWindow(frame, direction, playing, false);
+}
+
+void FramePrefetcher::request(int frame, int direction)
+{
+    setWindow(frame, direction, false, true);
+}
+
+void FramePrefetcher::setWindow(int frame, int direction, bool playing, bool includeFrame)
+{
+    const int count = static_cast<int>(m_paths.size());
+    if (count == 0)
+        return;
+    direction = direction < 0 ? -1 : 1;
+    auto wrap = [count](int f)
+    { return ((f % count) + count) % count; };
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_wanted.clear();
+    if (m_preloadAll)
+    {
+        // Todos os frames, dos mais próximos do atual para os mais distantes
+        for (int d = 0; d < count; ++d)
+            m_wanted.push_back(wrap(frame + direction * d));
+    }
+    else
+    {
+        // O frame atual já foi entregue e fica fora da janela; um frame pedido
+        // ocupa a primeira posição, e a janela encolhe para caber no anel
+        if (includeFrame)
+            m_wanted.push_back(wrap(frame));
+        const size_t room = m_capacity - m_wanted.size();
+        const int window = static_cast<int>(m_wanted.size() + std::min<size_t>(room, static_cast<size_t>(count - 1)));
+        for (int d = 1; static_cast<int>(m_wanted.size()) < window && d < count; ++d)
+        {
+            // Reproduzindo: só à frente (com volta ao início, como o laço de reprodução)
+            int ahead = wrap(frame + direction * d);
+            if (!isWanted(ahead))
+                m_wanted.push_back(ahead);
+            if (!playing && static_cast<int>(m_wanted.size()) < window)
+            {
+                int behind = wrap(frame - direction * d);
+                if (!isWanted(behind))
+                    m_wanted.push_back(behind);
+            }
+        }
+    }
+    // Leituras de frames que saíram da janela liberam o worker para o novo pedido
+    for (size_t i = 0; i < m_slots.size(); ++i)
+    {
+        if (m_slots[i].state == SlotState::Loading && !isWanted(m_slots[i].frame))
+            m_cancel[i].store(true, std::memory_order_relaxed);
+    }
+    m_wake.notify_all();
+}
+
+bool FramePrefetcher::pickWork(int &frame, size_t &slot)
+{
+    for (int candidate : m_wanted)
+    {
+        if (findSlot(candidate) >= 0)
+            continue;
+        // Slot livre: vazio ou com um frame pronto que saiu da janela
+        for (size_t i = 0; i < m_slots.size(); ++i)
+        {
+            const Slot &s = m_slots[i];
+            bool reusable = s.state == SlotState::Empty ||
+                            (s.state != SlotState::Loading && !isWanted(s.frame));
+            if (reusable)
+            {
+                frame = candidate;
+                slot = i;
+                return true;
+            }
+        }
+        return false; // anel cheio com frames ainda desejados
+    }
+    return false;
+}
+
+void FramePrefetcher::workerLoop()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_stop)
+    {
+        int frame = -1;
+        size_t slot = 0;
+        if (!pickWork(frame, slot))
+        {
+            m_wake.wait(lock);
+            continue;
+        }
+        m_slots[slot].frame = frame;
+        m_slots[slot].state = SlotState::Loading;
+        m_cancel[slot].store(false, std::memory_order_relaxed);
+        // Libera a árvore antiga do slot fora do mutex
+        SharedTree previous = std::move(m_slots[slot].tree);
+        const std::string path = m_paths[frame];
+
+        lock.unlock();
+        previous.reset();
+        auto decoded = std::make_shared<ArterialTree>();
+        bool ok = m_load(path, *decoded, &m_cancel[slot]);
+        lock.lock();
+
+        if (ok)
+            m_slots[slot].tree = std::move(decoded);
+        if (!ok && m_cancel[slot].load(std::memory_order_relaxed))
+        {
+            // Cancelado antes do fim: o slot volta a ficar livre (e o frame,
+            // se voltar à janela, é lido de novo)
+            m_slots[slot].frame = -1;
+            m_slots[slot].state = SlotState::Empty;
+        }
+        else
+        {
+            m_slots[slot].state = ok ? SlotState::Ready : SlotState::Failed;
+        }
+    }
+}
+
+bool FramePrefetcher::take(int frame, SharedTree &outTree)
+{
+    // A árvore anterior do chamador é liberada fora do mutex
+    SharedTree previous;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        int index = findSlot(frame);
+        if (index < 0 || m_slots[index].state != SlotState::Ready)
+            return false;
+        Slot &slot = m_slots[index];
+        previous = std::move(outTree);
+        if (m_preloadAll)
+        {
+            // O slot continua com o frame: só o contador de referências muda
+            outTree = slot.tree;
+            return true;
+        }
+        outTree = std::move(slot.tree);
+        slot.frame = -1;
+        slot.state = SlotState::Empty;
+        // Já entregue: não deve ser decodificado de novo até o próximo setCursor
+        m_wanted.erase(std::remove(m_wanted.begin(), m_wanted.end(), frame), m_wanted.end());
+    }
+    m_wake.notify_all();
+    return true;
+}
+
+bool FramePrefetcher::isPending(int frame) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    int index = findSlot(frame);
+    if (index >= 0)
+        return m_slots[index].state == SlotState::Loading;
+    return isWanted(frame);
+}
+
+int FramePrefetcher::nearestReady(int frame) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    int best = -1;
+    for (const Slot &s : m_slots)
+    {
+        if (s.state != SlotState::Ready)
+            continue;
+        if (best < 0 || std::abs(s.frame - frame) < std::abs(best - frame))
+            best = s.frame;
+    }
+    return best;
+}
@@ -0,0 +1,187 @@
+/*
+ * Universidade Federal de Ouro Preto - UFOP
+ * Departamento de Computação - DECOM
+ * Disciplina: BCC327 - Computação Gráfica (2025.2)
+ * Professor: Rafael Bonfim
+ * Trabalho Prático: Visualizador de Árvores Arteriais (CCO)
+ * Arquivo: GpuPicker.cpp
+ * Autor: Mateus Honorato
+ * Data: Outubro/2026
+ * Descrição:
+ * Implementa o picking por buffer de IDs (R32I) com leitura assíncrona
+ * da janela do clique por um PBO protegido por fence.
+ */
+
+#include <algorithm>
+#include <climits>
+#include <iostream>
+#include "GpuPicker.hpp"
+
+GpuPicker::~GpuPicker()
+{
+    deleteTargets();
+    if (pbo)
+        glDeleteBuffers(1, &pbo);
+    if (fence)
+        glDeleteSync(fence);
+}
+
+void GpuPicker::request(int x, int y)
+{
+    requestX = x;
+    requestY = y;
+    pending = true;
+}
+
+void GpuPicker::createTargets(int width, int height)
+{
+    deleteTargets();
+    glGenFramebuffers(1, &fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+
+    glGenRenderbuffers(1, &idBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, idBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_R32I, width, height);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, idBuffer);
+
+    glGenRenderbuffers(1, &depthBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    // Os shaders escrevem a cor em location 0 e o ID em location 1: aqui só o ID vai ao anexo
+    const GLenum drawBuffers[2] = {GL_NONE, GL_COLOR_ATTACHMENT0};
+    glDrawBuffers(2, drawBuffers);
+    glReadBuffer(GL_COLOR_ATTACHMENT0);
+
+    fboWidth = width;
+    fboHeight = height;
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+    {
+        std::cerr << "[GpuPicker] Framebuffer de IDs incompleto" << std::endl;
+        deleteTargets();
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void GpuPicker::deleteTargets()
+{
+    if (fbo)
+        glDeleteFramebuffers(1, &fbo);
+    if (idBuffer)
+        glDeleteRenderbuffers(1, &idBuffer);
+    if (depthBuffer)
+        glDeleteRenderbuffers(1, &depthBuffer);
+    fbo = idBuffer = depthBuffer = 0;
+    fboWidth = fboHeight = 0;
+}
+
+bool GpuPicker::beginPass(int width, int height)
+{
+    if (width <= 0 || height <= 0)
+    {
+        pending = false;
+        return false;
+    }
+    if (!fbo || width != fboWidth || height != fboHeight)
+        createTargets(width, height);
+    if (!fbo)
+    {
+        pending = false;
+        return false;
+    }
+
+    // Janela do clique em coordenadas do GL (origem embaixo), recortada à tela
+    const int x = std::clamp(requestX, 0, width - 1);
+    const int y = std::clamp(height - 1 - requestY, 0, height - 1);
+    const int x0 = std::max(x - PICK_RADIUS, 0);
+    const int y0 = std::max(y - PICK_RADIUS, 0);
+    readX = x0;
+    readY = y0;
+    readWidth = std::min(x + PICK_RADIUS, width - 1) - x0 + 1;
+    readHeight = std::min(y + PICK_RADIUS, height - 1) - y0 + 1;
+    centerX = x - x0;
+    centerY = y - y0;
+
+    // Só a janela é rasterizada: a passada custa quase só o processamento de vértices
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glEnable(GL_SCISSOR_TEST);
+    glScissor(readX, readY, readWidth, readHeight);
+    const GLint background[4] = {NO_ID, NO_ID, NO_ID, NO_ID};
+    const GLfloat farDepth = 1.0f;
+    glClearBufferiv(GL_COLOR, 1, background);
+    glClearBufferfv(GL_DEPTH, 0, &farDepth);
+    return true;
+}
+
+void GpuPicker::endPass()
+{
+    const GLsizeiptr windowBytes = (2 * PICK_RADIUS + 1) * (2 * PICK_RADIUS + 1) * sizeof(GLint);
+    if (!pbo)
+    {
+        glGenBuffers(1, &pbo);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo);
+        glBufferData(GL_PIXEL_PACK_BUFFER, windowBytes, nullptr, GL_STREAM_READ);
+    }
+    else
+    {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo);
+    }
+
+    // Com um PBO ligado o glReadPixels só enfileira a cópia e retorna
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glReadPixels(readX, readY, readWidth, readHeight, GL_RED_INTEGER, GL_INT, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    if (fence)
+        glDeleteSync(fence);
+    fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    glDisable(GL_SCISSOR_TEST);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    pending = false;
+}
+
+bool GpuPicker::poll(int &id)
+{
+    if (!fence)
+        return false;
+    // Espera zero: se a GPU ainda não terminou tenta de novo no próximo quadro
+    GLenum status = glClientWaitSync(fence, 0, 0);
+    if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+        return false;
+    glDeleteSync(fence);
+    fence = nullptr;
+
+    id = NO_ID;
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo);
+    const GLint *ids = static_cast<const GLint *>(
+        glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, readWidth * readHeight * sizeof(GLint), GL_MAP_READ_BIT));
+    if (ids)
+    {
+        // ID válido mais próximo do pixel clicado
+        int bestDist = INT_MAX;
+        for (int row = 0; row < readHeight; ++row)
+        {
+            for (int col = 0; col < readWidth; ++col)
+            {
+                const GLint value = ids[row * readWidth + col];
+                if (value == NO_ID)
+                    continue;
+                const int dist = (col - centerX) * (col - centerX) + (row - centerY) * (row - centerY);
+                if (dist < bestDist)
+                {
+                    bestDist = dist;
+                    id = value;
+                }
+            }
+        }
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    else
+    {
+        std::cerr << "[GpuPicker] Falha ao mapear o PBO de leitura" << std::endl;
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    return true;
+}
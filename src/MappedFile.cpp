@@ -0,0 +1,102 @@
+/*
+ * Universidade Federal de Ouro Preto - UFOP
+ * Departamento de Computação - DECOM
+ * Disciplina: BCC327 - Computação Gráfica (2025.2)
+ * Professor: Rafael Bonfim
+ * Trabalho Prático: Visualizador de Árvores Arteriais (CCO)
+ * Arquivo: MappedFile.cpp
+ * Autor: Mateus Honorato
+ * Data: Outubro/2026
+ * Descrição:
+ * Implementa o mapeamento de arquivos em memória (mmap no Linux, leitura
+ * única em buffer como alternativa no Windows).
+ */
+
+#include "MappedFile.hpp"
+
+#ifdef _WIN32
+#include <fstream>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::open(const std::string &filepath)
+{
+    close();
+    std::ifstream file(filepath, std::ios::binary | std::ios::ate);
+    if (!file.is_open())
+        return false;
+    std::streamsize size = file.tellg();
+    file.seekg(0, std::ios::beg);
+    m_buffer.resize(static_cast<size_t>(size));
+    if (size > 0 && !file.read(m_buffer.data(), size))
+        return false;
+    m_data = m_buffer.data();
+    m_size = m_buffer.size();
+    m_open = true;
+    return true;
+}
+
+void MappedFile::close()
+{
+    m_buffer.clear();
+    m_buffer.shrink_to_fit();
+    m_data = nullptr;
+    m_size = 0;
+    m_open = false;
+}
+
+#else
+
+bool MappedFile::open(const std::string &filepath)
+{
+    close();
+    int fd = ::open(filepath.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+    {
+        ::close(fd);
+        return false;
+    }
+    m_size = static_cast<size_t>(st.st_size);
+    if (m_size > 0)
+    {
+        void *addr = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (addr == MAP_FAILED)
+        {
+            ::close(fd);
+            m_size = 0;
+            return false;
+        }
+        // Os leitores percorrem o arquivo do início ao fim
+        madvise(addr, m_size, MADV_SEQUENTIAL);
+        m_data = static_cast<const char *>(addr);
+    }
+    // O mapeamento continua válido após fechar o descritor
+    ::close(fd);
+    m_open = true;
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (m_data && m_size > 0)
+        munmap(const_cast<char *>(m_data), m_size);
+    m_data = nullptr;
+    m_size = 0;
+    m_open = false;
+}
+
+#endif
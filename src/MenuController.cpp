@@ -18,8 +18,10 @@
 #include <string>
 #include "imgui.h"
 #include "MenuController.hpp"
+#include "ColormapUtils.hpp"
+#include "VertexCacheUtils.hpp"
 
-void MenuController::render(AnimationController &animCtrl, ArterialTree &tree, TreeRenderer &renderer, bool hideMainPanel)
+void MenuController::render(AnimationController &animCtrl, SharedTree &tree, TreeRenderer &renderer, bool hideMainPanel)
 {
     if (!hideMainPanel)
     {
@@ -109,7 +111,7 @@ void MenuController::render(AnimationController &animCtrl, ArterialTree &tree, T
             int maxFrame = (totalFrames > 0) ? totalFrames - 1 : 0;
             if (ImGui::SliderInt("Frame Atual", &currentFrame, 0, maxFrame))
             {
-                animCtrl.setFrameIndex(currentFrame, tree, renderer);
+                animCtrl.setFrameIndex(currentFrame, tree);
                 animChanged = true;
             }
             // Botão Play/Pause (atalhos de teclado são tratados globalmente abaixo)
@@ -133,6 +135,12 @@ void MenuController::render(AnimationController &animCtrl, ArterialTree &tree, T
                 animCtrl.getSpeedMultiplierRef() = 1.0f;
                 animChanged = true;
             }
+            // Decodifica todos os frames em paralelo (usa mais memória)
+            bool preloadAll = animCtrl.isPreloadAll();
+            if (ImGui::Checkbox("Pré-carregar Playlist", &preloadAll))
+            {
+                animCtrl.setPreloadAll(preloadAll);
+            }
             // Visualização da timeline (mantém lógica existente)
             // ...código existente de visualização da timeline...
             if (animChanged)
@@ -156,13 +164,11 @@ void MenuController::render(AnimationController &animCtrl, ArterialTree &tree, T
             }
             else
             {
-                visualChanged |= ImGui::SliderFloat("Espessura da Linha", &animCtrl.radiusScale, 0.1f, 5.0f, "%.2f");
+                // A escala de raio é um uniform: não exige regerar a malha
+                ImGui::SliderFloat("Espessura da Linha", &animCtrl.radiusScale, 0.1f, 5.0f, "%.2f");
                 ImGui::SameLine();
                 if (ImGui::Button("Reset##radius"))
-                {
                     animCtrl.radiusScale = 1.0f;
-                    visualChanged = true;
-                }
             }
             // Transparência
             visualChanged |= ImGui::SliderFloat("Transparência     ", &animCtrl.transparency, 0.0f, 1.0f, "%.2f");
@@ -180,6 +186,70 @@ void MenuController::render(AnimationController &animCtrl, ArterialTree &tree, T
             // Suavizar Conexões (moved here)
             ImGui::SameLine();
             visualChanged |= ImGui::Checkbox("Suavizar Conexões", &animCtrl.showSpheres);
+            // Mapa de cores aplicado nos shaders: a troca não regera a malha
+            if (ImGui::BeginCombo("Mapa de Cores", ColormapUtils::name(static_cast<Colormap>(animCtrl.colormap))))
+            {
+                for (int i = 0; i < ColormapUtils::COUNT; ++i)
+                {
+                    if (ImGui::Selectable(ColormapUtils::name(static_cast<Colormap>(i)), animCtrl.colormap == i))
+                        animCtrl.colormap = i;
+                }
+                ImGui::EndCombo();
+            }
+            // Caminho de desenho dos vasos (malhas ou instâncias)
+            if (animCtrl.getCurrentMode() != AnimationController::ModeWireframe)
+            {
+                if (ImGui::RadioButton("Malha", animCtrl.renderPath == 0))
+                {
+                    animCtrl.renderPath = 0;
+                    visualChanged = true;
+                }
+                ImGui::SameLine();
+                if (ImGui::RadioButton("Instanciada", animCtrl.renderPath == 1))
+                {
+                    animCtrl.renderPath = 1;
+                    visualChanged = true;
+                }
+                ImGui::SameLine();
+                if (ImGui::RadioButton("Impostor", animCtrl.renderPath == 2))
+                {
+                    animCtrl.renderPath = 2;
+                    visualChanged = true;
+                }
+                // Nível de detalhe (só no caminho de malha); a troca de níveis
+                // é detectada pelo renderizador a cada frame
+                if (animCtrl.renderPath == 0)
+                {
+                    // Formato dos vértices: a troca regera a malha
+                    ImGui::TextUnformatted("Vértices:");
+                    ImGui::SameLine();
+                    if (ImGui::RadioButton("Completo", animCtrl.vertexLayout == 0))
+                    {
+                        animCtrl.vertexLayout = 0;
+                        visualChanged = true;
+                    }
+                    ImGui::SameLine();
+                    if (ImGui::RadioButton("Compactado", animCtrl.vertexLayout == 1))
+                    {
+                        animCtrl.vertexLayout = 1;
+                        visualChanged = true;
+                    }
+                    // Ramos como tubos contínuos: sem esferas onde o ramo continua
+                    visualChanged |= ImGui::Checkbox("Tubos Contínuos", &animCtrl.sweptTubes);
+                    // Ordem dos índices para o cache de vértices; ACMR da malha atual
+                    visualChanged |= ImGui::Checkbox("Otimizar Ordem dos Índices", &animCtrl.optimizeIndexOrder);
+                    IndexOrderStats indexStats = renderer.getIndexOrderStats();
+                    if (indexStats.triangles > 0)
+                        ImGui::Text("ACMR: %.3f -> %.3f (cache FIFO de %d)", indexStats.acmrBefore,
+                                    indexStats.acmrAfter, VertexCacheUtils::CACHE_SIZE);
+                    // Blocos espaciais que passaram no teste de frustum/corte no último frame
+                    ImGui::Text("Blocos visíveis: %zu / %zu", renderer.getChunksDrawn(), renderer.getChunkCount());
+                    ImGui::Checkbox("Nível de Detalhe (LOD)", &animCtrl.lodEnabled);
+                    if (animCtrl.lodEnabled)
+                        ImGui::SliderInt("Orçamento (mil triângulos)", &animCtrl.triangleBudget, 0, 20000,
+                                         animCtrl.triangleBudget == 0 ? "sem limite" : "%d");
+                }
+            }
             if (visualChanged)
                 animCtrl.m_visualDirty = true;
         }
@@ -247,8 +317,8 @@ void MenuController::render(AnimationController &animCtrl, ArterialTree &tree, T
         // --- Categoria 5: Ferramentas de Corte ---
         if (ImGui::CollapsingHeader("Ferramentas de Corte", ImGuiTreeNodeFlags_DefaultOpen))
         {
-            bool clipChanged = false;
-            clipChanged |= ImGui::Checkbox("Ativar Corte                                             ", &animCtrl.clipping.enabled);
+            // O corte é aplicado nos shaders: os controles não pedem atualização da malha
+            ImGui::Checkbox("Ativar Corte                                             ", &animCtrl.clipping.enabled);
             ImGui::SameLine();
             if (ImGui::Button("Resetar Todos##clip"))
             {
@@ -258,26 +328,20 @@ void MenuController::render(AnimationController &animCtrl, ArterialTree &tree, T
                 animCtrl.clipping.max.y = 2.0f;
                 animCtrl.clipping.min.z = -2.0f;
                 animCtrl.clipping.max.z = 2.0f;
-                clipChanged = true;
             }
+            ImGui::Checkbox("Tampar Cortes", &animCtrl.clipping.caps);
 
             auto drawAxisControl = [&](const char *label, float *minVal, float *maxVal, float defaultMin, float defaultMax)
             {
                 ImGui::Text("%s", label);
-                clipChanged |= ImGui::SliderFloat((std::string("Min ##") + label).c_str(), minVal, -2.0f, 2.0f);
+                ImGui::SliderFloat((std::string("Min ##") + label).c_str(), minVal, -2.0f, 2.0f);
                 ImGui::SameLine();
                 if (ImGui::Button((std::string("Reset##min") + label).c_str()))
-                {
                     *minVal = defaultMin;
-                    clipChanged = true;
-                }
-                clipChanged |= ImGui::SliderFloat((std::string("Max ##") + label).c_str(), maxVal, -2.0f, 2.0f);
+                ImGui::SliderFloat((std::string("Max ##") + label).c_str(), maxVal, -2.0f, 2.0f);
                 ImGui::SameLine();
                 if (ImGui::Button((std::string("Reset##max") + label).c_str()))
-                {
                     *maxVal = defaultMax;
-                    clipChanged = true;
-                }
                 if (*minVal > *maxVal)
                     *minVal = *maxVal;
             };
@@ -296,9 +360,6 @@ void MenuController::render(AnimationController &animCtrl, ArterialTree &tree, T
                 ImGui::Spacing();
                 drawAxisControl("Eixo Z (Profundidade)", &animCtrl.clipping.min.z, &animCtrl.clipping.max.z, -2.0f, 2.0f);
             }
-
-            if (clipChanged)
-                animCtrl.m_visualDirty = true;
         }
 
         // --- Footer: Salvar PNG ---
@@ -311,11 +372,11 @@ void MenuController::render(AnimationController &animCtrl, ArterialTree &tree, T
     }
 
     int selIdx = animCtrl.getSelectedSegment();
-    if (selIdx != -1 && selIdx < (int)tree.segments.size())
+    if (selIdx != -1 && selIdx < (int)tree->segments.size())
     {
-        const auto &seg = tree.segments[selIdx];
-        const auto &nodeA = tree.nodes[seg.indexA];
-        const auto &nodeB = tree.nodes[seg.indexB];
+        const auto &seg = tree->segments[selIdx];
+        const auto &nodeA = tree->nodes[seg.indexA];
+        const auto &nodeB = tree->nodes[seg.indexB];
 
         // --- Cálculos Físicos (Baseado em VTK/Cilindros) ---
         float length = glm::length(nodeA.position - nodeB.position);
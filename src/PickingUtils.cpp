@@ -16,12 +16,169 @@
  */
 
 #include <algorithm>
+#include <limits>
 #include <glm/gtc/matrix_transform.hpp> // Necessário para unProject
 #include "PickingUtils.hpp"
+#include "ClippingUtils.hpp"
+#include "SimdUtils.hpp"
 
 // Implementação de Ray Casting utilizando a inversão das matrizes de Projeção
 // e View (glm::unProject).
 
+namespace
+{
+    // Segmentos por bloco da varredura linear (distâncias e máscara na pilha)
+    constexpr size_t PICK_BLOCK = 1024;
+
+#if SIMD_X86
+    // rayIntersectsSegment em pistas: os dois ramos (raio quase paralelo ou
+    // não) são calculados e escolhidos por máscara, na mesma ordem de
+    // operações da versão escalar. Retorna quantos segmentos foram tratados.
+    inline __m128 select(__m128 mask, __m128 a, __m128 b)
+    {
+        return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+    }
+
+    size_t rayIntersectsSegmentsSSE(const PickQuery &query, const SegmentSoA &segments,
+                                    size_t begin, size_t count, float *outDist)
+    {
+        const __m128 ox = _mm_set1_ps(query.rayOrigin.x);
+        const __m128 oy = _mm_set1_ps(query.rayOrigin.y);
+        const __m128 oz = _mm_set1_ps(query.rayOrigin.z);
+        const __m128 dx = _mm_set1_ps(query.rayDir.x);
+        const __m128 dy = _mm_set1_ps(query.rayDir.y);
+        const __m128 dz = _mm_set1_ps(query.rayDir.z);
+        const __m128 a = _mm_set1_ps(glm::dot(query.rayDir, query.rayDir));
+        const __m128 radiusFactor = _mm_set1_ps(query.radiusFactor);
+        const __m128 minRadius = _mm_set1_ps(query.minRadius);
+        const __m128 epsilon = _mm_set1_ps(1e-6f);
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 one = _mm_set1_ps(1.0f);
+        const __m128 miss = _mm_set1_ps(-1.0f);
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4)
+        {
+            const size_t s = begin + i;
+            const __m128 ax = _mm_loadu_ps(segments.ax.data() + s);
+            const __m128 ay = _mm_loadu_ps(segments.ay.data() + s);
+            const __m128 az = _mm_loadu_ps(segments.az.data() + s);
+            const __m128 vx = _mm_sub_ps(_mm_loadu_ps(segments.bx.data() + s), ax);
+            const __m128 vy = _mm_sub_ps(_mm_loadu_ps(segments.by.data() + s), ay);
+            const __m128 vz = _mm_sub_ps(_mm_loadu_ps(segments.bz.data() + s), az);
+            const __m128 wx = _mm_sub_ps(ox, ax);
+            const __m128 wy = _mm_sub_ps(oy, ay);
+            const __m128 wz = _mm_sub_ps(oz, az);
+
+            const __m128 c = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy)), _mm_mul_ps(vz, vz));
+            const __m128 b = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, vx), _mm_mul_ps(dy, vy)), _mm_mul_ps(dz, vz));
+            const __m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, wx), _mm_mul_ps(dy, wy)), _mm_mul_ps(dz, wz));
+            const __m128 e = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, wx), _mm_mul_ps(vy, wy)), _mm_mul_ps(vz, wz));
+            const __m128 denom = _mm_sub_ps(_mm_mul_ps(a, c), _mm_mul_ps(b, b));
+
+            const __m128 parallel = _mm_cmplt_ps(denom, epsilon);
+            const __m128 tcParallel = select(_mm_cmpgt_ps(b, c), _mm_div_ps(d, b), _mm_div_ps(e, c));
+            const __m128 sc = select(parallel, zero,
+                                     _mm_div_ps(_mm_sub_ps(_mm_mul_ps(b, e), _mm_mul_ps(c, d)), denom));
+            const __m128 tc = select(parallel, tcParallel,
+                                     _mm_div_ps(_mm_sub_ps(_mm_mul_ps(a, e), _mm_mul_ps(b, d)), denom));
+            const __m128 tSeg = _mm_min_ps(_mm_max_ps(tc, zero), one);
+
+            // Ponto do raio relativo à origem e distância ao ponto do segmento
+            const __m128 px = _mm_add_ps(ox, _mm_mul_ps(sc, dx));
+            const __m128 py = _mm_add_ps(oy, _mm_mul_ps(sc, dy));
+            const __m128 pz = _mm_add_ps(oz, _mm_mul_ps(sc, dz));
+            const __m128 rx = _mm_sub_ps(px, ox);
+            const __m128 ry = _mm_sub_ps(py, oy);
+            const __m128 rz = _mm_sub_ps(pz, oz);
+            const __m128 gx = _mm_sub_ps(px, _mm_add_ps(ax, _mm_mul_ps(tSeg, vx)));
+            const __m128 gy = _mm_sub_ps(py, _mm_add_ps(ay, _mm_mul_ps(tSeg, vy)));
+            const __m128 gz = _mm_sub_ps(pz, _mm_add_ps(az, _mm_mul_ps(tSeg, vz)));
+            const __m128 gap = _mm_sqrt_ps(
+                _mm_add_ps(_mm_add_ps(_mm_mul_ps(gx, gx), _mm_mul_ps(gy, gy)), _mm_mul_ps(gz, gz)));
+            const __m128 dist = _mm_sqrt_ps(
+                _mm_add_ps(_mm_add_ps(_mm_mul_ps(rx, rx), _mm_mul_ps(ry, ry)), _mm_mul_ps(rz, rz)));
+
+            const __m128 hitRadius = _mm_max_ps(_mm_mul_ps(_mm_loadu_ps(segments.radius.data() + s), radiusFactor),
+                                                minRadius);
+            const __m128 hit = _mm_and_ps(_mm_and_ps(_mm_cmpnlt_ps(c, epsilon), _mm_cmpnlt_ps(sc, zero)),
+                                          _mm_cmple_ps(gap, hitRadius));
+            _mm_storeu_ps(outDist + i, select(hit, dist, miss));
+        }
+        return i;
+    }
+
+    // Mesmo laço da versão SSE em pistas de 8
+    SIMD_TARGET_AVX2 size_t rayIntersectsSegmentsAVX2(const PickQuery &query, const SegmentSoA &segments,
+                                                      size_t begin, size_t count, float *outDist)
+    {
+        const __m256 ox = _mm256_set1_ps(query.rayOrigin.x);
+        const __m256 oy = _mm256_set1_ps(query.rayOrigin.y);
+        const __m256 oz = _mm256_set1_ps(query.rayOrigin.z);
+        const __m256 dx = _mm256_set1_ps(query.rayDir.x);
+        const __m256 dy = _mm256_set1_ps(query.rayDir.y);
+        const __m256 dz = _mm256_set1_ps(query.rayDir.z);
+        const __m256 a = _mm256_set1_ps(glm::dot(query.rayDir, query.rayDir));
+        const __m256 radiusFactor = _mm256_set1_ps(query.radiusFactor);
+        const __m256 minRadius = _mm256_set1_ps(query.minRadius);
+        const __m256 epsilon = _mm256_set1_ps(1e-6f);
+        const __m256 zero = _mm256_setzero_ps();
+        const __m256 one = _mm256_set1_ps(1.0f);
+        const __m256 miss = _mm256_set1_ps(-1.0f);
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8)
+        {
+            const size_t s = begin + i;
+            const __m256 ax = _mm256_loadu_ps(segments.ax.data() + s);
+            const __m256 ay = _mm256_loadu_ps(segments.ay.data() + s);
+            const __m256 az = _mm256_loadu_ps(segments.az.data() + s);
+            const __m256 vx = _mm256_sub_ps(_mm256_loadu_ps(segments.bx.data() + s), ax);
+            const __m256 vy = _mm256_sub_ps(_mm256_loadu_ps(segments.by.data() + s), ay);
+            const __m256 vz = _mm256_sub_ps(_mm256_loadu_ps(segments.bz.data() + s), az);
+            const __m256 wx = _mm256_sub_ps(ox, ax);
+            const __m256 wy = _mm256_sub_ps(oy, ay);
+            const __m256 wz = _mm256_sub_ps(oz, az);
+
+            const __m256 c = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(vx, vx), _mm256_mul_ps(vy, vy)), _mm256_mul_ps(vz, vz));
+            const __m256 b = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, vx), _mm256_mul_ps(dy, vy)), _mm256_mul_ps(dz, vz));
+            const __m256 d = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, wx), _mm256_mul_ps(dy, wy)), _mm256_mul_ps(dz, wz));
+            const __m256 e = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(vx, wx), _mm256_mul_ps(vy, wy)), _mm256_mul_ps(vz, wz));
+            const __m256 denom = _mm256_sub_ps(_mm256_mul_ps(a, c), _mm256_mul_ps(b, b));
+
+            const __m256 parallel = _mm256_cmp_ps(denom, epsilon, _CMP_LT_OQ);
+            const __m256 tcParallel = _mm256_blendv_ps(_mm256_div_ps(e, c), _mm256_div_ps(d, b),
+                                                       _mm256_cmp_ps(b, c, _CMP_GT_OQ));
+            const __m256 sc = _mm256_blendv_ps(
+                _mm256_div_ps(_mm256_sub_ps(_mm256_mul_ps(b, e), _mm256_mul_ps(c, d)), denom), zero, parallel);
+            const __m256 tc = _mm256_blendv_ps(
+                _mm256_div_ps(_mm256_sub_ps(_mm256_mul_ps(a, e), _mm256_mul_ps(b, d)), denom), tcParallel, parallel);
+            const __m256 tSeg = _mm256_min_ps(_mm256_max_ps(tc, zero), one);
+
+            const __m256 px = _mm256_add_ps(ox, _mm256_mul_ps(sc, dx));
+            const __m256 py = _mm256_add_ps(oy, _mm256_mul_ps(sc, dy));
+            const __m256 pz = _mm256_add_ps(oz, _mm256_mul_ps(sc, dz));
+            const __m256 rx = _mm256_sub_ps(px, ox);
+            const __m256 ry = _mm256_sub_ps(py, oy);
+            const __m256 rz = _mm256_sub_ps(pz, oz);
+            const __m256 gx = _mm256_sub_ps(px, _mm256_add_ps(ax, _mm256_mul_ps(tSeg, vx)));
+            const __m256 gy = _mm256_sub_ps(py, _mm256_add_ps(ay, _mm256_mul_ps(tSeg, vy)));
+            const __m256 gz = _mm256_sub_ps(pz, _mm256_add_ps(az, _mm256_mul_ps(tSeg, vz)));
+            const __m256 gap = _mm256_sqrt_ps(
+                _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(gx, gx), _mm256_mul_ps(gy, gy)), _mm256_mul_ps(gz, gz)));
+            const __m256 dist = _mm256_sqrt_ps(
+                _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(rx, rx), _mm256_mul_ps(ry, ry)), _mm256_mul_ps(rz, rz)));
+
+            const __m256 hitRadius = _mm256_max_ps(
+                _mm256_mul_ps(_mm256_loadu_ps(segments.radius.data() + s), radiusFactor), minRadius);
+            const __m256 hit = _mm256_and_ps(_mm256_and_ps(_mm256_cmp_ps(c, epsilon, _CMP_NLT_UQ),
+                                                           _mm256_cmp_ps(sc, zero, _CMP_NLT_UQ)),
+                                             _mm256_cmp_ps(gap, hitRadius, _CMP_LE_OQ));
+            _mm256_storeu_ps(outDist + i, _mm256_blendv_ps(miss, dist, hit));
+        }
+        return i;
+    }
+#endif
+}
+
 namespace PickingUtils
 {
 
@@ -119,4 +276,53 @@ namespace PickingUtils
         }
         return false;
     }
+
+    void rayIntersectsSegments(const PickQuery &query, const SegmentSoA &segments,
+                               size_t begin, size_t count, float *outDist)
+    {
+        size_t done = 0;
+#if SIMD_X86
+        done = SimdUtils::hasAVX2() ? rayIntersectsSegmentsAVX2(query, segments, begin, count, outDist)
+                                    : rayIntersectsSegmentsSSE(query, segments, begin, count, outDist);
+#endif
+        // Restante (e CPUs sem SIMD): a versão escalar
+        for (size_t i = done; i < count; ++i)
+        {
+            const size_t s = begin + i;
+            const float hitRadius = std::max(segments.radius[s] * query.radiusFactor, query.minRadius);
+            float dist;
+            outDist[i] = rayIntersectsSegment(query.rayOrigin, query.rayDir,
+                                              glm::vec3(segments.ax[s], segments.ay[s], segments.az[s]),
+                                              glm::vec3(segments.bx[s], segments.by[s], segments.bz[s]),
+                                              hitRadius, dist)
+                             ? dist
+                             : -1.0f;
+        }
+    }
+
+    int pickSegment(const SegmentSoA &segments, const PickQuery &query, float &outDist)
+    {
+        int bestIndex = -1;
+        float bestDist = std::numeric_limits<float>::max();
+        float dists[PICK_BLOCK];
+        uint8_t inside[PICK_BLOCK];
+        for (size_t begin = 0; begin < segments.size(); begin += PICK_BLOCK)
+        {
+            const size_t count = std::min(PICK_BLOCK, segments.size() - begin);
+            rayIntersectsSegments(query, segments, begin, count, dists);
+            if (query.clipEnabled)
+                ClippingUtils::clipSegments(query.clipMin, query.clipMax, segments, begin, count, inside);
+            for (size_t i = 0; i < count; ++i)
+            {
+                // Índices crescentes: o primeiro com a menor distância vence o empate
+                if (dists[i] >= 0.0f && dists[i] < bestDist && (!query.clipEnabled || inside[i]))
+                {
+                    bestDist = dists[i];
+                    bestIndex = static_cast<int>(begin + i);
+                }
+            }
+        }
+        outDist = bestDist;
+        return bestIndex;
+    }
 }
\ No newline at end of file
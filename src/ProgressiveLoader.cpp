@@ -0,0 +1,187 @@
+/*
+ * Universidade Federal de Ouro Preto - UFOP
+ * Departamento de Computação - DECOM
+ * Disciplina: BCC327 - Computação Gráfica (2025.2)
+ * Professor: Rafael Bonfim
+ * Trabalho Prático: Visualizador de Árvores Arteriais (CCO)
+ * Arquivo: ProgressiveLoader.cpp
+ * Autor: Mateus Honorato
+ * Data: Outubro/2026
+ * Descrição:
+ * Implementa o carregador progressivo. A thread de fundo escreve nos vetores
+ * da árvore já dimensionados em onBegin; a thread principal só lê intervalos
+ * publicados pelos contadores atômicos. Ao fim da leitura a pré-visualização
+ * é encerrada e a árvore é normalizada e gravada no cache em segundo plano.
+ */
+
+#include <limits>
+#include "ProgressiveLoader.hpp"
+#include "VtkReader.hpp"
+#include "MappedFile.hpp"
+
+// Preenche a árvore parcial a partir dos lotes de VtkReader::stream
+class ProgressiveLoader::Builder : public VtkVisitor
+{
+public:
+    explicit Builder(ProgressiveLoader &owner) : m_owner(owner) {}
+
+    bool onBegin(size_t numPoints, size_t numSegments) override
+    {
+        m_owner.m_tree.nodes.resize(numPoints);
+        m_owner.m_tree.segments.resize(numSegments);
+        m_minPos = glm::vec3(std::numeric_limits<float>::max());
+        m_maxPos = glm::vec3(-std::numeric_limits<float>::max());
+        return !cancelled();
+    }
+
+    bool onNodes(size_t first, const glm::vec3 *positions, size_t count) override
+    {
+        std::vector<ArterialNode> &nodes = m_owner.m_tree.nodes;
+        for (size_t i = 0; i < count; ++i)
+        {
+            nodes[first + i].position = positions[i];
+            m_minPos = glm::min(m_minPos, positions[i]);
+            m_maxPos = glm::max(m_maxPos, positions[i]);
+        }
+        if (first + count == nodes.size())
+        {
+            m_owner.m_center = nodes[0].position;
+            m_owner.m_minPos = m_minPos;
+            m_owner.m_maxPos = m_maxPos;
+            m_owner.m_nodesReady.store(true, std::memory_order_release);
+        }
+        return !cancelled();
+    }
+
+    bool onSegments(size_t first, const int *indexPairs, size_t count) override
+    {
+        std::vector<ArterialSegment> &segments = m_owner.m_tree.segments;
+        for (size_t i = 0; i < count; ++i)
+        {
+            segments[first + i].indexA = indexPairs[2 * i];
+            segments[first + i].indexB = indexPairs[2 * i + 1];
+        }
+        return !cancelled();
+    }
+
+    bool onRadii(size_t first, const float *radii, size_t count) override
+    {
+        std::vector<ArterialSegment> &segments = m_owner.m_tree.segments;
+        for (size_t i = 0; i < count; ++i)
+            segments[first + i].radius = radii[i];
+        m_owner.m_readySegments.store(first + count, std::memory_order_release);
+        return !cancelled();
+    }
+
+private:
+    bool cancelled() const { return m_owner.m_cancel.load(std::memory_order_relaxed); }
+
+    ProgressiveLoader &m_owner;
+    glm::vec3 m_minPos = glm::vec3(0.0f);
+    glm::vec3 m_maxPos = glm::vec3(0.0f);
+};
+
+ProgressiveLoader::~ProgressiveLoader()
+{
+    cancel();
+}
+
+void ProgressiveLoader::start(const std::string &filepath)
+{
+    cancel();
+    m_path = filepath;
+    m_thread = std::thread(&ProgressiveLoader::run, this);
+}
+
+void ProgressiveLoader::cancel()
+{
+    if (!isActive())
+        return;
+    m_cancel.store(true, std::memory_order_relaxed);
+    m_thread.join();
+    reset();
+}
+
+void ProgressiveLoader::reset()
+{
+    m_tree.nodes.clear();
+    m_tree.segments.clear();
+    m_hasStamp = false;
+    m_success = false;
+    m_cancel.store(false, std::memory_order_relaxed);
+    m_finished.store(false, std::memory_order_relaxed);
+    m_nodesReady.store(false, std::memory_order_relaxed);
+    m_readySegments.store(0, std::memory_order_relaxed);
+    m_previewClosed.store(false, std::memory_order_relaxed);
+}
+
+bool ProgressiveLoader::beginPreview()
+{
+    if (m_previewClosed.load(std::memory_order_acquire))
+        return false;
+    m_previewMutex.lock();
+    if (m_previewClosed.load(std::memory_order_relaxed))
+    {
+        m_previewMutex.unlock();
+        return false;
+    }
+    return true;
+}
+
+float ProgressiveLoader::previewScale() const
+{
+    // Mesma escala de ArterialTree::normalize()
+    glm::vec3 extent = m_maxPos - m_minPos;
+    float maxDim = glm::max(glm::max(extent.x, extent.y), extent.z);
+    if (maxDim < 1e-6f)
+        maxDim = 1.0f;
+    return 2.0f / maxDim;
+}
+
+void ProgressiveLoader::run()
+{
+    // Com cache .atb válido a árvore fica pronta de imediato (sem pré-visualização)
+    {
+        MappedFile file;
+        if (file.open(m_path))
+        {
+            m_stamp = TreeCache::stamp(m_path, file.data(), file.size());
+            m_hasStamp = true;
+            if (TreeCache::load(TreeCache::sidecarPath(m_path), m_stamp, m_tree))
+            {
+                m_success = true;
+                m_finished.store(true, std::memory_order_release);
+                return;
+            }
+        }
+    }
+    Builder builder(*this);
+    bool ok = VtkReader::stream(m_path, builder) && !m_cancel.load(std::memory_order_relaxed);
+    // Espera a thread principal terminar o lote que estiver lendo; depois
+    // disso ela não lê mais a árvore parcial
+    {
+        std::lock_guard<std::mutex> lock(m_previewMutex);
+        m_previewClosed.store(true, std::memory_order_release);
+    }
+    if (ok)
+    {
+        m_tree.normalize();
+        m_tree.updateMidpoints();
+        if (m_hasStamp && !m_cancel.load(std::memory_order_relaxed))
+            TreeCache::save(TreeCache::sidecarPath(m_path), m_stamp, m_tree);
+    }
+    m_success = ok;
+    m_finished.store(true, std::memory_order_release);
+}
+
+bool ProgressiveLoader::take(ArterialTree &outTree)
+{
+    if (!isActive())
+        return false;
+    m_thread.join();
+    bool ok = m_success;
+    if (ok)
+        outTree = std::move(m_tree);
+    reset();
+    return ok;
+}
@@ -0,0 +1,415 @@
+/*
+ * Universidade Federal de Ouro Preto - UFOP
+ * Departamento de Computação - DECOM
+ * Disciplina: BCC327 - Computação Gráfica (2025.2)
+ * Professor: Rafael Bonfim
+ * Trabalho Prático: Visualizador de Árvores Arteriais (CCO)
+ * Arquivo: SegmentBVH.cpp
+ * Autor: Mateus Honorato
+ * Data: Outubro/2026
+ * Descrição:
+ * Implementa a construção da BVH de cápsulas por SAH em caixas (binning),
+ * o reajuste das caixas entre frames e a busca do segmento mais próximo
+ * atingido por um raio.
+ *
+ * Créditos:
+ * Construção por SAH em caixas baseada em Wald, "On fast Construction of
+ * SAH-based Bounding Volume Hierarchies" (IEEE RT 2007).
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+
+#include "SegmentBVH.hpp"
+#include "ClippingUtils.hpp"
+#include "ParallelUtils.hpp"
+#include "PickingUtils.hpp"
+
+namespace
+{
+    const uint32_t NO_PARENT = 0xFFFFFFFFu;
+    // Segmentos mínimos por thread no cálculo das caixas
+    const size_t MIN_SEGMENTS_PER_TASK = 65536;
+
+    // Metade da área da superfície da caixa (a constante não altera a SAH)
+    inline float halfArea(const glm::vec3 &lo, const glm::vec3 &hi)
+    {
+        glm::vec3 d = glm::max(hi - lo, glm::vec3(0.0f));
+        return d.x * d.y + d.y * d.z + d.z * d.x;
+    }
+
+    struct Bin
+    {
+        glm::vec3 lo = glm::vec3(std::numeric_limits<float>::max());
+        glm::vec3 hi = glm::vec3(-std::numeric_limits<float>::max());
+        uint32_t count = 0;
+    };
+
+    // Caixa da cápsula (eixo + raio base) de um segmento; reordenada junto
+    // com os índices para que a partição percorra a memória em sequência
+    struct BuildPrimitive
+    {
+        glm::vec3 lo;
+        glm::vec3 hi;
+        uint32_t segment;
+
+        glm::vec3 centroid() const { return (lo + hi) * 0.5f; }
+    };
+
+    // Partição por SAH em SAH_BINS caixas de mesma largura sobre os
+    // centróides, no eixo mais longo. Retorna o início da metade direita.
+    uint32_t splitRange(BuildPrimitive *items, uint32_t begin, uint32_t end)
+    {
+        const int BINS = SegmentBVH::SAH_BINS;
+        glm::vec3 centroidMin(std::numeric_limits<float>::max());
+        glm::vec3 centroidMax(-std::numeric_limits<float>::max());
+        for (uint32_t k = begin; k < end; ++k)
+        {
+            const glm::vec3 c = items[k].centroid();
+            centroidMin = glm::min(centroidMin, c);
+            centroidMax = glm::max(centroidMax, c);
+        }
+        const glm::vec3 extent = centroidMax - centroidMin;
+        const int axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : (extent.y >= extent.z ? 1 : 2);
+        const float origin = centroidMin[axis];
+        const float binScale = extent[axis] > 0.0f ? BINS * (1.0f - 1e-5f) / extent[axis] : 0.0f;
+        auto binOf = [&](const BuildPrimitive &item)
+        { return std::min(static_cast<int>((item.centroid()[axis] - origin) * binScale), BINS - 1); };
+
+        Bin bins[SegmentBVH::SAH_BINS];
+        for (uint32_t k = begin; k < end && binScale > 0.0f; ++k)
+        {
+            Bin &bin = bins[binOf(items[k])];
+            bin.lo = glm::min(bin.lo, items[k].lo);
+            bin.hi = glm::max(bin.hi, items[k].hi);
+            ++bin.count;
+        }
+
+        // Custo de cada plano entre caixas: área(E) * n(E) + área(D) * n(D)
+        float rightArea[SegmentBVH::SAH_BINS];
+        uint32_t rightCount[SegmentBVH::SAH_BINS];
+        Bin accumulated;
+        for (int b = BINS - 1; b > 0; --b)
+        {
+            accumulated.lo = glm::min(accumulated.lo, bins[b].lo);
+            accumulated.hi = glm::max(accumulated.hi, bins[b].hi);
+            accumulated.count += bins[b].count;
+            rightArea[b] = halfArea(accumulated.lo, accumulated.hi);
+            rightCount[b] = accumulated.count;
+        }
+        int bestSplit = 0;
+        float bestCost = std::numeric_limits<float>::max();
+        accumulated = Bin();
+        for (int b = 1; b < BINS; ++b)
+        {
+            accumulated.lo = glm::min(accumulated.lo, bins[b - 1].lo);
+            accumulated.hi = glm::max(accumulated.hi, bins[b - 1].hi);
+            accumulated.count += bins[b - 1].count;
+            if (accumulated.count == 0 || rightCount[b] == 0)
+                continue;
+            const float cost = halfArea(accumulated.lo, accumulated.hi) * accumulated.count +
+                               rightArea[b] * rightCount[b];
+            if (cost < bestCost)
+            {
+                bestCost = cost;
+                bestSplit = b;
+            }
+        }
+
+        BuildPrimitive *first = items + begin;
+        BuildPrimitive *last = items + end;
+        BuildPrimitive *middle = first;
+        if (bestSplit > 0)
+            middle = std::partition(first, last, [&](const BuildPrimitive &item) { return binOf(item) < bestSplit; });
+        // Centróides coincidentes: divide ao meio
+        if (middle == first || middle == last)
+            middle = first + (end - begin) / 2;
+        return static_cast<uint32_t>(middle - items);
+    }
+
+    // Subintervalo de primitivos a transformar em nó; `parent` é o nó cujo
+    // filho direito ele será (o esquerdo vem sempre logo após o pai)
+    struct BuildTask
+    {
+        uint32_t begin;
+        uint32_t end;
+        uint32_t parent;
+    };
+
+    // Subárvore de [begin, end) em profundidade, com índices de nós locais a `out`
+    void buildSubtree(BuildPrimitive *items, uint32_t begin, uint32_t end, std::vector<BVHNode> &out)
+    {
+        std::vector<BuildTask> stack;
+        stack.push_back(BuildTask{begin, end, NO_PARENT});
+        while (!stack.empty())
+        {
+            const BuildTask task = stack.back();
+            stack.pop_back();
+            const uint32_t index = static_cast<uint32_t>(out.size());
+            out.emplace_back();
+            if (task.parent != NO_PARENT)
+                out[task.parent].offset = index;
+            const uint32_t count = task.end - task.begin;
+            if (count <= SegmentBVH::MAX_LEAF_SIZE)
+            {
+                out[index].offset = task.begin;
+                out[index].count = count;
+                continue;
+            }
+            out[index].count = 0;
+            const uint32_t mid = splitRange(items, task.begin, task.end);
+            stack.push_back(BuildTask{mid, task.end, index});
+            stack.push_back(BuildTask{task.begin, mid, NO_PARENT});
+        }
+    }
+
+    // Níveis de cima da árvore, divididos em série; as folhas são as
+    // subárvores construídas em paralelo
+    struct TopNode
+    {
+        uint32_t begin;
+        uint32_t end;
+        int left = -1;
+        int right = -1;
+    };
+
+    // Grava o nó `i` da parte de cima e, nas folhas, a subárvore realocada
+    void emitTop(const std::vector<TopNode> &top, std::vector<std::vector<BVHNode>> &subtrees, size_t i,
+                 std::vector<BVHNode> &nodes)
+    {
+        if (top[i].left < 0)
+        {
+            const uint32_t base = static_cast<uint32_t>(nodes.size());
+            for (BVHNode node : subtrees[i])
+            {
+                if (node.count == 0)
+                    node.offset += base;
+                nodes.push_back(node);
+            }
+            std::vector<BVHNode>().swap(subtrees[i]);
+            return;
+        }
+        const size_t index = nodes.size();
+        nodes.emplace_back();
+        nodes[index].count = 0;
+        emitTop(top, subtrees, top[i].left, nodes);
+        nodes[index].offset = static_cast<uint32_t>(nodes.size());
+        emitTop(top, subtrees, top[i].right, nodes);
+    }
+}
+
+void SegmentBVH::fitLeaf(const ArterialTree &tree, BVHNode &node) const
+{
+    node.boundsMin = glm::vec3(std::numeric_limits<float>::max());
+    node.boundsMax = glm::vec3(-std::numeric_limits<float>::max());
+    node.maxRadius = 0.0f;
+    for (uint32_t k = node.offset; k < node.offset + node.count; ++k)
+    {
+        const ArterialSegment &seg = tree.segments[primitives[k]];
+        const glm::vec3 &a = tree.nodes[seg.indexA].position;
+        const glm::vec3 &b = tree.nodes[seg.indexB].position;
+        node.boundsMin = glm::min(node.boundsMin, glm::min(a, b));
+        node.boundsMax = glm::max(node.boundsMax, glm::max(a, b));
+        node.maxRadius = std::max(node.maxRadius, seg.radius);
+    }
+}
+
+void SegmentBVH::build(const ArterialTree &tree)
+{
+    segmentCount = tree.segments.size();
+    nodes.clear();
+    primitives.resize(segmentCount);
+    if (segmentCount == 0)
+        return;
+
+    std::vector<BuildPrimitive> items(segmentCount);
+    ParallelUtils::parallelFor(segmentCount, MIN_SEGMENTS_PER_TASK,
+                               [&](size_t begin, size_t end)
+                               {
+                                   for (size_t i = begin; i < end; ++i)
+                                   {
+                                       const ArterialSegment &seg = tree.segments[i];
+                                       const glm::vec3 &a = tree.nodes[seg.indexA].position;
+                                       const glm::vec3 &b = tree.nodes[seg.indexB].position;
+                                       items[i].lo = glm::min(a, b) - glm::vec3(seg.radius);
+                                       items[i].hi = glm::max(a, b) + glm::vec3(seg.radius);
+                                       items[i].segment = static_cast<uint32_t>(i);
+                                   }
+                               });
+
+    // Divide os níveis de cima até haver algumas subárvores por thread
+    const unsigned threads = ParallelUtils::threadCount();
+    const size_t subtreeSize = std::max(MIN_SEGMENTS_PER_TASK, segmentCount / (threads * 4));
+    std::vector<TopNode> top;
+    top.push_back(TopNode{0, static_cast<uint32_t>(segmentCount)});
+    std::vector<size_t> jobs;
+    for (size_t i = 0; i < top.size(); ++i)
+    {
+        const uint32_t begin = top[i].begin;
+        const uint32_t end = top[i].end;
+        if (end - begin <= subtreeSize)
+        {
+            jobs.push_back(i);
+            continue;
+        }
+        const uint32_t mid = splitRange(items.data(), begin, end);
+        top[i].left = static_cast<int>(top.size());
+        top[i].right = static_cast<int>(top.size() + 1);
+        top.push_back(TopNode{begin, mid});
+        top.push_back(TopNode{mid, end});
+    }
+    std::vector<std::vector<BVHNode>> subtrees(top.size());
+    std::atomic<size_t> nextJob{0};
+    ParallelUtils::runTasks(std::min<size_t>(threads, jobs.size()),
+                            [&](size_t)
+                            {
+                                for (size_t j = nextJob++; j < jobs.size(); j = nextJob++)
+                                {
+                                    const TopNode &job = top[jobs[j]];
+                                    buildSubtree(items.data(), job.begin, job.end, subtrees[jobs[j]]);
+                                }
+                            });
+    nodes.reserve(2 * segmentCount / MAX_LEAF_SIZE + 1);
+    emitTop(top, subtrees, 0, nodes);
+    ParallelUtils::parallelFor(segmentCount, MIN_SEGMENTS_PER_TASK,
+                               [&](size_t begin, size_t end)
+                               {
+                                   for (size_t k = begin; k < end; ++k)
+                                       primitives[k] = items[k].segment;
+                               });
+
+    // Caixas dos eixos (sem raio) e raios máximos, das folhas para a raiz
+    refit(tree);
+}
+
+void SegmentBVH::update(const ArterialTree &tree)
+{
+    if (tree.segments.size() != segmentCount || nodes.empty())
+    {
+        build(tree);
+        return;
+    }
+    refit(tree);
+}
+
+void SegmentBVH::refit(const ArterialTree &tree)
+{
+    // Filhos vêm depois dos pais: de trás para frente cada nó já tem os filhos prontos
+    for (size_t i = nodes.size(); i-- > 0;)
+    {
+        BVHNode &node = nodes[i];
+        if (node.count > 0)
+        {
+            fitLeaf(tree, node);
+            continue;
+        }
+        const BVHNode &left = nodes[i + 1];
+        const BVHNode &right = nodes[node.offset];
+        node.boundsMin = glm::min(left.boundsMin, right.boundsMin);
+        node.boundsMax = glm::max(left.boundsMax, right.boundsMax);
+        node.maxRadius = std::max(left.maxRadius, right.maxRadius);
+    }
+}
+
+int SegmentBVH::pick(const ArterialTree &tree, const PickQuery &query, float &outDist) const
+{
+    if (nodes.empty() || tree.segments.size() != segmentCount)
+        return -1;
+
+    glm::vec3 invDir;
+    for (int c = 0; c < 3; ++c)
+    {
+        const float d = query.rayDir[c];
+        invDir[c] = 1.0f / (std::abs(d) > 1e-12f ? d : std::copysign(1e-12f, d));
+    }
+
+    int bestIndex = -1;
+    float bestDist = std::numeric_limits<float>::max();
+    // Entrada do raio na caixa do nó alargada pelo maior raio de acerto; o
+    // ponto de acerto fica a até esse raio do eixo, logo dentro da caixa
+    auto entry = [&](const BVHNode &node, float &tEntry)
+    {
+        if (query.clipEnabled)
+        {
+            for (int c = 0; c < 3; ++c)
+            {
+                if (node.boundsMax[c] < query.clipMin[c] || node.boundsMin[c] > query.clipMax[c])
+                    return false;
+            }
+        }
+        const glm::vec3 margin(std::max(node.maxRadius * query.radiusFactor, query.minRadius));
+        const glm::vec3 t0 = (node.boundsMin - margin - query.rayOrigin) * invDir;
+        const glm::vec3 t1 = (node.boundsMax + margin - query.rayOrigin) * invDir;
+        const glm::vec3 tMin = glm::min(t0, t1);
+        const glm::vec3 tMax = glm::max(t0, t1);
+        const float tNear = std::max({tMin.x, tMin.y, tMin.z, 0.0f});
+        const float tFar = std::min({tMax.x, tMax.y, tMax.z});
+        tEntry = tNear;
+        return tNear <= tFar && tNear <= bestDist;
+    };
+
+    // Pilha de (nó, entrada); o filho mais próximo é visitado primeiro
+    std::vector<std::pair<uint32_t, float>> stack;
+    stack.reserve(64);
+    float rootEntry;
+    if (entry(nodes[0], rootEntry))
+        stack.emplace_back(0u, rootEntry);
+    while (!stack.empty())
+    {
+        const auto [index, tEntry] = stack.back();
+        stack.pop_back();
+        if (tEntry > bestDist)
+            continue;
+        const BVHNode &node = nodes[index];
+        if (node.count > 0)
+        {
+            for (uint32_t k = node.offset; k < node.offset + node.count; ++k)
+            {
+                const uint32_t s = primitives[k];
+                const ArterialSegment &seg = tree.segments[s];
+                const glm::vec3 &a = tree.nodes[seg.indexA].position;
+                const glm::vec3 &b = tree.nodes[seg.indexB].position;
+                if (query.clipEnabled)
+                {
+                    glm::vec3 tempA = a, tempB = b;
+                    if (!ClippingUtils::clipSegment(tempA, tempB, query.clipMin, query.clipMax))
+                        continue;
+                }
+                const float hitRadius = std::max(seg.radius * query.radiusFactor, query.minRadius);
+                float dist;
+                if (!PickingUtils::rayIntersectsSegment(query.rayOrigin, query.rayDir, a, b, hitRadius, dist))
+                    continue;
+                // Empate: o menor índice, como na varredura linear
+                if (dist < bestDist || (dist == bestDist && static_cast<int>(s) < bestIndex))
+                {
+                    bestDist = dist;
+                    bestIndex = static_cast<int>(s);
+                }
+            }
+            continue;
+        }
+        const uint32_t leftIndex = index + 1;
+        const uint32_t rightIndex = node.offset;
+        float leftEntry, rightEntry;
+        const bool hitLeft = entry(nodes[leftIndex], leftEntry);
+        const bool hitRight = entry(nodes[rightIndex], rightEntry);
+        if (hitLeft && hitRight)
+        {
+            const bool leftFirst = leftEntry <= rightEntry;
+            stack.emplace_back(leftFirst ? rightIndex : leftIndex, leftFirst ? rightEntry : leftEntry);
+            stack.emplace_back(leftFirst ? leftIndex : rightIndex, leftFirst ? leftEntry : rightEntry);
+        }
+        else if (hitLeft)
+        {
+            stack.emplace_back(leftIndex, leftEntry);
+        }
+        else if (hitRight)
+        {
+            stack.emplace_back(rightIndex, rightEntry);
+        }
+    }
+    outDist = bestDist;
+    return bestIndex;
+}
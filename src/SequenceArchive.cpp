@@ -0,0 +1,594 @@
+/*
+ * Universidade Federal de Ouro Preto - UFOP
+ * Departamento de Computação - DECOM
+ * Disciplina: BCC327 - Computação Gráfica (2025.2)
+ * Professor: Rafael Bonfim
+ * Trabalho Prático: Visualizador de Árvores Arteriais (CCO)
+ * Arquivo: SequenceArchive.cpp
+ * Autor: Mateus Honorato
+ * Data: Outubro/2026
+ * Descrição:
+ * Implementa o empacotamento e a leitura do arquivo de sequência (.ats).
+ *
+ * Layout do arquivo (ordem de bytes nativa, verificada por `byteOrder`):
+ *   AtsHeader | registros dos frames | índice (IndexEntry[frames]) |
+ *   nomes (uint32 tamanho + bytes, por frame)
+ * Registro de quadro-chave:
+ *   float[3 * nós] posições | int32[2 * segmentos] índices | float[segmentos] raios
+ * Registro de diferença (em relação ao frame anterior):
+ *   AtsDelta | uint32[moved] índices e float[3 * moved] posições dos nós
+ *   movidos | float[3 * (nós - nós anteriores)] nós acrescentados |
+ *   AtsRun[runs] | int32[2 * literals] segmentos novos | raios
+ * Os segmentos são refeitos pelas execuções: {início, n} copia n segmentos
+ * consecutivos do frame anterior (com seus raios); início = LITERAL_RUN toma
+ * os próximos n segmentos novos. Os raios que diferem dos copiados vêm em
+ * seguida, esparsos (uint32[raios] índices e float[raios] valores) ou,
+ * quando a maioria mudou, densos (float[segmentos]).
+ * Todos os valores são os brutos do VTK; a normalização é feita na leitura.
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <unordered_map>
+#include "SequenceArchive.hpp"
+#include "VtkReader.hpp"
+
+namespace
+{
+    const char ATS_MAGIC[4] = {'A', 'T', 'S', '1'};
+    const uint32_t ATS_VERSION = 1;
+    const uint32_t ATS_BYTE_ORDER = 0x01020304u;
+    const uint32_t LITERAL_RUN = 0xFFFFFFFFu;
+
+    struct AtsHeader
+    {
+        char magic[4];
+        uint32_t version;
+        uint32_t byteOrder;
+        uint32_t headerSize;
+        uint64_t frameCount;
+        uint64_t indexOffset;
+        uint64_t namesOffset;
+        uint32_t keyframeInterval;
+        uint32_t reserved;
+    };
+    static_assert(sizeof(AtsHeader) == 48, "AtsHeader deve ter layout fixo");
+
+    struct AtsDelta
+    {
+        uint64_t movedNodes;
+        uint64_t runCount;
+        uint64_t literalCount;
+        uint64_t radiusCount; // raios esparsos (ignorado se denseRadii)
+        uint32_t denseRadii;
+        uint32_t reserved;
+    };
+    static_assert(sizeof(AtsDelta) == 40, "AtsDelta deve ter layout fixo");
+
+    struct AtsRun
+    {
+        uint32_t start;
+        uint32_t length;
+    };
+
+    template <typename T>
+    void put(std::vector<char> &out, const T *values, size_t count)
+    {
+        const char *bytes = reinterpret_cast<const char *>(values);
+        out.insert(out.end(), bytes, bytes + count * sizeof(T));
+    }
+
+    // Leitura sequencial e com limite de um registro mapeado
+    struct RecordReader
+    {
+        const char *p;
+        const char *end;
+
+        template <typename T>
+        bool get(T *values, size_t count)
+        {
+            if (count > static_cast<size_t>(end - p) / sizeof(T))
+                return false;
+            if (count == 0)
+                return true;
+            std::memcpy(values, p, count * sizeof(T));
+            p += count * sizeof(T);
+            return true;
+        }
+    };
+
+    inline bool sameBits(const void *a, const void *b, size_t bytes)
+    {
+        return std::memcmp(a, b, bytes) == 0;
+    }
+
+    inline uint64_t pairKey(int a, int b)
+    {
+        return (uint64_t(uint32_t(a)) << 32) | uint32_t(b);
+    }
+
+    // Monta a árvore com os valores brutos do arquivo (sem normalização)
+    class RawTreeBuilder : public VtkVisitor
+    {
+    public:
+        explicit RawTreeBuilder(ArterialTree &tree) : m_tree(tree) {}
+
+        bool onBegin(size_t numPoints, size_t numSegments) override
+        {
+            m_tree.nodes.resize(numPoints);
+            m_tree.segments.resize(numSegments);
+            return true;
+        }
+        bool onNodes(size_t first, const glm::vec3 *positions, size_t count) override
+        {
+            for (size_t i = 0; i < count; ++i)
+                m_tree.nodes[first + i].position = positions[i];
+            return true;
+        }
+        bool onSegments(size_t first, const int *indexPairs, size_t count) override
+        {
+            for (size_t i = 0; i < count; ++i)
+            {
+                m_tree.segments[first + i].indexA = indexPairs[2 * i];
+                m_tree.segments[first + i].indexB = indexPairs[2 * i + 1];
+            }
+            return true;
+        }
+        bool onRadii(size_t first, const float *radii, size_t count) override
+        {
+            for (size_t i = 0; i < count; ++i)
+                m_tree.segments[first + i].radius = radii[i];
+            return true;
+        }
+
+    private:
+        ArterialTree &m_tree;
+    };
+
+    void encodeKeyframe(const ArterialTree &tree, std::vector<char> &out)
+    {
+        out.clear();
+        put(out, tree.nodes.data(), tree.nodes.size());
+        for (const ArterialSegment &seg : tree.segments)
+        {
+            int32_t pair[2] = {seg.indexA, seg.indexB};
+            put(out, pair, 2);
+        }
+        for (const ArterialSegment &seg : tree.segments)
+            put(out, &seg.radius, 1);
+    }
+
+    void encodeDelta(const ArterialTree &prev, const ArterialTree &cur, std::vector<char> &out)
+    {
+        AtsDelta delta = {};
+        std::vector<uint32_t> movedIndex;
+        std::vector<glm::vec3> movedPos;
+        const size_t keptNodes = std::min(prev.nodes.size(), cur.nodes.size());
+        for (size_t i = 0; i < keptNodes; ++i)
+        {
+            if (!sameBits(&prev.nodes[i], &cur.nodes[i], sizeof(ArterialNode)))
+            {
+                movedIndex.push_back(static_cast<uint32_t>(i));
+                movedPos.push_back(cur.nodes[i].position);
+            }
+        }
+        delta.movedNodes = movedIndex.size();
+
+        // Segmentos: execuções copiadas do frame anterior ou literais novos
+        std::unordered_map<uint64_t, uint32_t> prevIndex;
+        prevIndex.reserve(prev.segments.size());
+        for (size_t i = 0; i < prev.segments.size(); ++i)
+            prevIndex.emplace(pairKey(prev.segments[i].indexA, prev.segments[i].indexB), static_cast<uint32_t>(i));
+        std::vector<AtsRun> runs;
+        std::vector<int32_t> literals;
+        std::vector<float> rebuiltRadius(cur.segments.size());
+        for (size_t j = 0; j < cur.segments.size(); ++j)
+        {
+            const ArterialSegment &seg = cur.segments[j];
+            // Continua a execução atual se o próximo segmento anterior coincide
+            if (!runs.empty() && runs.back().start != LITERAL_RUN)
+            {
+                size_t next = size_t(runs.back().start) + runs.back().length;
+                if (next < prev.segments.size() && prev.segments[next].indexA == seg.indexA &&
+                    prev.segments[next].indexB == seg.indexB)
+                {
+                    runs.back().length++;
+                    rebuiltRadius[j] = prev.segments[next].radius;
+                    continue;
+                }
+            }
+            auto it = prevIndex.find(pairKey(seg.indexA, seg.indexB));
+            if (it != prevIndex.end())
+            {
+                runs.push_back({it->second, 1});
+                rebuiltRadius[j] = prev.segments[it->second].radius;
+                continue;
+            }
+            if (runs.empty() || runs.back().start != LITERAL_RUN)
+                runs.push_back({LITERAL_RUN, 0});
+            runs.back().length++;
+            literals.push_back(seg.indexA);
+            literals.push_back(seg.indexB);
+            rebuiltRadius[j] = 0.0f;
+        }
+        delta.runCount = runs.size();
+        delta.literalCount = literals.size() / 2;
+
+        std::vector<uint32_t> radiusIndex;
+        std::vector<float> radiusValue;
+        for (size_t j = 0; j < cur.segments.size(); ++j)
+        {
+            if (!sameBits(&rebuiltRadius[j], &cur.segments[j].radius, sizeof(float)))
+            {
+                radiusIndex.push_back(static_cast<uint32_t>(j));
+                radiusValue.push_back(cur.segments[j].radius);
+            }
+        }
+        // Cada raio esparso custa o dobro de um denso
+        delta.denseRadii = radiusIndex.size() * 2 > cur.segments.size() ? 1u : 0u;
+        delta.radiusCount = delta.denseRadii ? 0 : radiusIndex.size();
+
+        out.clear();
+        put(out, &delta, 1);
+        put(out, movedIndex.data(), movedIndex.size());
+        put(out, movedPos.data(), movedPos.size());
+        if (cur.nodes.size() > prev.nodes.size())
+            put(out, cur.nodes.data() + prev.nodes.size(), cur.nodes.size() - prev.nodes.size());
+        put(out, runs.data(), runs.size());
+        put(out, literals.data(), literals.size());
+        if (delta.denseRadii)
+        {
+            for (const ArterialSegment &seg : cur.segments)
+                put(out, &seg.radius, 1);
+        }
+        else
+        {
+            put(out, radiusIndex.data(), radiusIndex.size());
+            put(out, radiusValue.data(), radiusValue.size());
+        }
+    }
+}
+
+std::string SequenceArchive::defaultPath(const std::string &folderPath)
+{
+    std::filesystem::path folder(folderPath);
+    if (!folder.has_filename())
+        folder = folder.parent_path();
+    return folder.string() + ".ats";
+}
+
+bool SequenceArchive::pack(const std::string &folderPath, const std::string &outputPath,
+                           unsigned keyframeInterval)
+{
+    std::vector<std::string> frames;
+    std::error_code ec;
+    for (const auto &entry : std::filesystem::directory_iterator(folderPath, ec))
+    {
+        const std::filesystem::path &path = entry.path();
+        bool isFrame = path.extension() == ".vtk" ||
+                       (path.extension() == ".gz" && path.stem().extension() == ".vtk");
+        if (entry.is_regular_file() && isFrame)
+            frames.push_back(path.string());
+    }
+    if (ec || frames.empty())
+    {
+        std::cerr << "[SequenceArchive] Nenhum frame VTK encontrado em: " << folderPath << std::endl;
+        return false;
+    }
+    std::sort(frames.begin(), frames.end());
+    keyframeInterval = std::max(keyframeInterval, 1u);
+
+    std::ofstream out(outputPath, std::ios::binary | std::ios::trunc);
+    if (!out.is_open())
+    {
+        std::cerr << "[SequenceArchive] Falha ao criar arquivo: " << outputPath << std::endl;
+        return false;
+    }
+    AtsHeader header = {};
+    std::memcpy(header.magic, ATS_MAGIC, 4);
+    header.version = ATS_VERSION;
+    header.byteOrder = ATS_BYTE_ORDER;
+    header.headerSize = sizeof(AtsHeader);
+    header.frameCount = frames.size();
+    header.keyframeInterval = keyframeInterval;
+    out.write(reinterpret_cast<const char *>(&header), sizeof(AtsHeader));
+
+    std::vector<IndexEntry> index(frames.size());
+    ArterialTree prev, cur;
+    std::vector<char> keyRecord, deltaRecord;
+    uint64_t offset = sizeof(AtsHeader);
+    uint64_t keyBytes = 0, totalBytes = 0;
+    uint32_t keyframe = 0;
+    for (size_t f = 0; f < frames.size(); ++f)
+    {
+        RawTreeBuilder builder(cur);
+        if (!VtkReader::stream(frames[f], builder))
+        {
+            std::cerr << "[SequenceArchive] Falha ao ler frame: " << frames[f] << std::endl;
+            return false;
+        }
+        encodeKeyframe(cur, keyRecord);
+        const std::vector<char> *record = &keyRecord;
+        if (f % keyframeInterval != 0)
+        {
+            encodeDelta(prev, cur, deltaRecord);
+            if (deltaRecord.size() < keyRecord.size())
+                record = &deltaRecord;
+        }
+        if (record == &keyRecord)
+            keyframe = static_cast<uint32_t>(f);
+        keyBytes += keyRecord.size();
+        totalBytes += record->size();
+
+        IndexEntry &entry = index[f];
+        entry = {};
+        entry.offset = offset;
+        entry.size = record->size();
+        entry.nodeCount = cur.nodes.size();
+        entry.segmentCount = cur.segments.size();
+        entry.keyframe = keyframe;
+        out.write(record->data(), static_cast<std::streamsize>(record->size()));
+        offset += record->size();
+        std::swap(prev, cur);
+    }
+
+    header.indexOffset = offset;
+    out.write(reinterpret_cast<const char *>(index.data()), static_cast<std::streamsize>(index.size() * sizeof(IndexEntry)));
+    header.namesOffset = offset + index.size() * sizeof(IndexEntry);
+    for (const std::string &frame : frames)
+    {
+        std::string name = std::filesystem::path(frame).filename().string();
+        uint32_t length = static_cast<uint32_t>(name.size());
+        out.write(reinterpret_cast<const char *>(&length), sizeof(length));
+        out.write(name.data(), length);
+    }
+    out.seekp(0);
+    out.write(reinterpret_cast<const char *>(&header), sizeof(AtsHeader));
+    if (!out.good())
+    {
+        std::cerr << "[SequenceArchive] Falha ao gravar arquivo: " << outputPath << std::endl;
+        return false;
+    }
+    std::cout << "[SequenceArchive] " << frames.size() << " frames empacotados em " << outputPath
+              << " (" << totalBytes << " de " << keyBytes << " bytes em frames completos)" << std::endl;
+    return true;
+}
+
+bool SequenceArchive::open(const std::string &path)
+{
+    close();
+    if (!m_file.open(path))
+    {
+        std::cerr << "[SequenceArchive] Falha ao abrir arquivo: " << path << std::endl;
+        return false;
+    }
+    const uint64_t fileSize = m_file.size();
+    AtsHeader header;
+    bool valid = fileSize >= sizeof(AtsHeader);
+    if (valid)
+    {
+        std::memcpy(&header, m_file.data(), sizeof(AtsHeader));
+        valid = std::memcmp(header.magic, ATS_MAGIC, 4) == 0 && header.version == ATS_VERSION &&
+                header.byteOrder == ATS_BYTE_ORDER && header.headerSize == sizeof(AtsHeader) &&
+                header.frameCount > 0 && header.indexOffset <= fileSize &&
+                header.frameCount <= (fileSize - header.indexOffset) / sizeof(IndexEntry) &&
+                header.namesOffset == header.indexOffset + header.frameCount * sizeof(IndexEntry);
+    }
+    if (valid)
+    {
+        m_index.resize(static_cast<size_t>(header.frameCount));
+        std::memcpy(m_index.data(), m_file.data() + header.indexOffset, m_index.size() * sizeof(IndexEntry));
+        for (size_t f = 0; f < m_index.size() && valid; ++f)
+        {
+            const IndexEntry &e = m_index[f];
+            valid = e.offset >= sizeof(AtsHeader) && e.offset <= header.indexOffset &&
+                    e.size <= header.indexOffset - e.offset && e.keyframe <= f &&
+                    m_index[e.keyframe].keyframe == e.keyframe;
+        }
+        RecordReader names{m_file.data() + header.namesOffset, m_file.data() + fileSize};
+        for (size_t f = 0; f < m_index.size() && valid; ++f)
+        {
+            uint32_t length = 0;
+            valid = names.get(&length, 1) && length <= static_cast<size_t>(names.end - names.p);
+            if (valid)
+            {
+                m_names.emplace_back(names.p, length);
+                names.p += length;
+            }
+        }
+    }
+    if (!valid)
+    {
+        std::cerr << "[SequenceArchive] Arquivo de sequência inválido: " << path << std::endl;
+        close();
+        return false;
+    }
+    m_path = path;
+    return true;
+}
+
+void SequenceArchive::close()
+{
+    m_file.close();
+    m_path.clear();
+    m_index.clear();
+    m_names.clear();
+    m_raw.nodes.clear();
+    m_raw.segments.clear();
+    m_rawFrame = -1;
+}
+
+bool SequenceArchive::decodeKeyframe(size_t frame)
+{
+    const IndexEntry &e = m_index[frame];
+    m_rawFrame = -1;
+    if (e.nodeCount == 0 || e.nodeCount > e.size / 12 || e.segmentCount > e.size / 12 ||
+        e.size != e.nodeCount * 12 + e.segmentCount * 12)
+    {
+        std::cerr << "[SequenceArchive] Quadro-chave corrompido (frame " << frame << "): " << m_path << std::endl;
+        return false;
+    }
+    const size_t nodeCount = static_cast<size_t>(e.nodeCount);
+    const size_t segmentCount = static_cast<size_t>(e.segmentCount);
+    RecordReader in{m_file.data() + e.offset, m_file.data() + e.offset + e.size};
+    m_raw.nodes.resize(nodeCount);
+    in.get(m_raw.nodes.data(), nodeCount);
+    m_raw.segments.resize(segmentCount);
+    const char *indices = in.p;
+    const char *radii = in.p + segmentCount * 8;
+    for (size_t i = 0; i < segmentCount; ++i)
+    {
+        int32_t pair[2];
+        std::memcpy(pair, indices + i * 8, 8);
+        ArterialSegment &seg = m_raw.segments[i];
+        seg.indexA = pair[0];
+        seg.indexB = pair[1];
+        std::memcpy(&seg.radius, radii + i * 4, 4);
+    }
+    if (!m_raw.hasValidIndices())
+    {
+        std::cerr << "[SequenceArchive] Índice de nó fora do intervalo (frame " << frame << "): " << m_path << std::endl;
+        return false;
+    }
+    m_rawFrame = static_cast<long long>(frame);
+    return true;
+}
+
+bool SequenceArchive::applyDelta(size_t frame)
+{
+    const IndexEntry &e = m_index[frame];
+    if (e.keyframe == frame)
+        return decodeKeyframe(frame);
+
+    const long long previous = m_rawFrame;
+    m_rawFrame = -1;
+    auto corrupted = [&]()
+    {
+        std::cerr << "[SequenceArchive] Diferença corrompida (frame " << frame << "): " << m_path << std::endl;
+        return false;
+    };
+    RecordReader in{m_file.data() + e.offset, m_file.data() + e.offset + e.size};
+    AtsDelta delta;
+    if (previous != static_cast<long long>(frame) - 1 || e.nodeCount == 0 || !in.get(&delta, 1))
+        return corrupted();
+
+    // Nós: os que se moveram, depois os acrescentados ao fim
+    const size_t prevNodes = m_raw.nodes.size();
+    const size_t nodeCount = static_cast<size_t>(e.nodeCount);
+    const size_t keptNodes = std::min(prevNodes, nodeCount);
+    if (delta.movedNodes > keptNodes)
+        return corrupted();
+    std::vector<uint32_t> movedIndex(static_cast<size_t>(delta.movedNodes));
+    std::vector<glm::vec3> movedPos(movedIndex.size());
+    if (!in.get(movedIndex.data(), movedIndex.size()) || !in.get(movedPos.data(), movedPos.size()))
+        return corrupted();
+    m_raw.nodes.resize(nodeCount);
+    for (size_t i = 0; i < movedIndex.size(); ++i)
+    {
+        if (movedIndex[i] >= keptNodes)
+            return corrupted();
+        m_raw.nodes[movedIndex[i]].position = movedPos[i];
+    }
+    if (nodeCount > prevNodes && !in.get(m_raw.nodes.data() + prevNodes, nodeCount - prevNodes))
+        return corrupted();
+
+    // Segmentos: execuções copiadas do frame anterior intercaladas com os novos
+    const size_t segmentCount = static_cast<size_t>(e.segmentCount);
+    if (delta.runCount > segmentCount || delta.literalCount > segmentCount)
+        return corrupted();
+    std::vector<AtsRun> runs(static_cast<size_t>(delta.runCount));
+    std::vector<int32_t> literals(static_cast<size_t>(delta.literalCount) * 2);
+    if (!in.get(runs.data(), runs.size()) || !in.get(literals.data(), literals.size()))
+        return corrupted();
+    std::vector<ArterialSegment> segments(segmentCount);
+    size_t out = 0, literal = 0;
+    for (const AtsRun &run : runs)
+    {
+        if (run.length > segmentCount - out)
+            return corrupted();
+        if (run.start == LITERAL_RUN)
+        {
+            if (run.length > delta.literalCount - literal)
+                return corrupted();
+            for (uint32_t k = 0; k < run.length; ++k, ++literal, ++out)
+            {
+                segments[out].indexA = literals[2 * literal];
+                segments[out].indexB = literals[2 * literal + 1];
+                segments[out].radius = 0.0f;
+                if (segments[out].indexA < 0 || segments[out].indexB < 0 ||
+                    size_t(segments[out].indexA) >= nodeCount || size_t(segments[out].indexB) >= nodeCount)
+                    return corrupted();
+            }
+        }
+        else
+        {
+            if (run.start > m_raw.segments.size() || run.length > m_raw.segments.size() - run.start)
+                return corrupted();
+            std::copy_n(m_raw.segments.begin() + run.start, run.length, segments.begin() + out);
+            out += run.length;
+        }
+    }
+    if (out != segmentCount || literal != delta.literalCount)
+        return corrupted();
+
+    // Raios que mudaram em relação aos copiados
+    if (delta.denseRadii)
+    {
+        std::vector<float> radii(segmentCount);
+        if (!in.get(radii.data(), radii.size()))
+            return corrupted();
+        for (size_t i = 0; i < segmentCount; ++i)
+            segments[i].radius = radii[i];
+    }
+    else
+    {
+        if (delta.radiusCount > segmentCount)
+            return corrupted();
+        std::vector<uint32_t> radiusIndex(static_cast<size_t>(delta.radiusCount));
+        std::vector<float> radiusValue(radiusIndex.size());
+        if (!in.get(radiusIndex.data(), radiusIndex.size()) || !in.get(radiusValue.data(), radiusValue.size()))
+            return corrupted();
+        for (size_t i = 0; i < radiusIndex.size(); ++i)
+        {
+            if (radiusIndex[i] >= segmentCount)
+                return corrupted();
+            segments[radiusIndex[i]].radius = radiusValue[i];
+        }
+    }
+    m_raw.segments.swap(segments);
+    // Segmentos copiados só podem apontar para fora se nós foram removidos
+    if (nodeCount < prevNodes && !m_raw.hasValidIndices())
+        return corrupted();
+    m_rawFrame = static_cast<long long>(frame);
+    return true;
+}
+
+bool SequenceArchive::readFrame(size_t frame, ArterialTree &outTree)
+{
+    if (frame >= m_index.size())
+    {
+        std::cerr << "[SequenceArchive] Frame fora do intervalo: " << frame << std::endl;
+        return false;
+    }
+    // Avança a partir do último frame reconstruído quando ele está entre o
+    // quadro-chave e o frame pedido; senão recomeça do quadro-chave
+    const IndexEntry &e = m_index[frame];
+    if (m_rawFrame < static_cast<long long>(e.keyframe) || m_rawFrame > static_cast<long long>(frame))
+    {
+        if (!decodeKeyframe(e.keyframe))
+            return false;
+    }
+    for (size_t f = static_cast<size_t>(m_rawFrame) + 1; f <= frame; ++f)
+    {
+        if (!applyDelta(f))
+            return false;
+    }
+    outTree.nodes = m_raw.nodes;
+    outTree.segments = m_raw.segments;
+    outTree.normalize();
+    outTree.updateMidpoints();
+    return true;
+}
@@ -0,0 +1,277 @@
+/*
+ * Universidade Federal de Ouro Preto - UFOP
+ * Departamento de Computação - DECOM
+ * Disciplina: BCC327 - Computação Gráfica (2025.2)
+ * Professor: Rafael Bonfim
+ * Trabalho Prático: Visualizador de Árvores Arteriais (CCO)
+ * Arquivo: TreeCache.cpp
+ * Autor: Mateus Honorato
+ * Data: Outubro/2026
+ * Descrição:
+ * Implementa leitura e gravação do cache binário de frames (.atb).
+ *
+ * Layout do arquivo (ordem de bytes nativa, verificada por `byteOrder`):
+ *   AtbHeader | float[3 * nós] posições | int32[2 * segmentos] índices |
+ *   float[segmentos] raios
+ * As posições e os raios são os brutos (os do arquivo de origem); a
+ * normalização do cabeçalho é reaplicada na carga, com o mesmo resultado de
+ * ArterialTree::normalize(), e os pontos médios são recalculados.
+ */
+
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <vector>
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+#include "TreeCache.hpp"
+#include "MappedFile.hpp"
+
+namespace
+{
+    const char ATB_MAGIC[4] = {'A', 'T', 'B', '1'};
+    const uint32_t ATB_VERSION = 2;
+    const uint32_t ATB_BYTE_ORDER = 0x01020304u;
+
+    struct AtbHeader
+    {
+        char magic[4];
+        uint32_t version;
+        uint32_t byteOrder;
+        uint32_t headerSize;
+        uint64_t sourceSize;
+        int64_t sourceMtime;
+        uint64_t sourceHash;
+        uint64_t nodeCount;
+        uint64_t segmentCount;
+        float center[3];
+        float scale;
+        float radiusFix;
+        uint32_t reserved;
+        uint64_t positionsOffset;
+        uint64_t indicesOffset;
+        uint64_t radiiOffset;
+    };
+    static_assert(sizeof(AtbHeader) == 104, "AtbHeader deve ter layout fixo");
+
+    uint64_t align8(uint64_t v)
+    {
+        return (v + 7u) & ~uint64_t(7u);
+    }
+
+    // Seção [offset, offset + bytes) dentro do arquivo, sem somar o offset
+    // lido do disco (um valor corrompido daria a volta em 64 bits)
+    bool sectionFits(uint64_t offset, uint64_t bytes, uint64_t fileSize)
+    {
+        return offset <= fileSize && bytes <= fileSize - offset;
+    }
+
+    // Nome temporário único por gravação (processo, thread e contador): dois
+    // escritores do mesmo frame não truncam o arquivo um do outro
+    std::string uniqueTempPath(const std::string &cachePath)
+    {
+        static std::atomic<uint64_t> counter(0);
+#ifdef _WIN32
+        const long long pid = _getpid();
+#else
+        const long long pid = getpid();
+#endif
+        std::ostringstream oss;
+        oss << cachePath << ".tmp." << pid << '.' << std::hash<std::thread::id>()(std::this_thread::get_id()) << '.'
+            << counter.fetch_add(1);
+        return oss.str();
+    }
+
+    inline uint64_t mix(uint64_t h, uint64_t v)
+    {
+        h ^= v;
+        h *= 0x9E3779B97F4A7C15ull;
+        h ^= h >> 32;
+        return h;
+    }
+
+    uint64_t hashBlock(uint64_t h, const char *data, size_t len)
+    {
+        size_t i = 0;
+        for (; i + 8 <= len; i += 8)
+        {
+            uint64_t word;
+            std::memcpy(&word, data + i, 8);
+            h = mix(h, word);
+        }
+        uint64_t tail = 0;
+        if (len > i)
+            std::memcpy(&tail, data + i, len - i);
+        return mix(h, tail ^ (uint64_t(len - i) << 56));
+    }
+
+    bool sameStamp(const AtbHeader &h, const SourceStamp &s)
+    {
+        return h.sourceSize == s.size && h.sourceMtime == s.mtime && h.sourceHash == s.hash;
+    }
+}
+
+std::string TreeCache::sidecarPath(const std::string &sourcePath)
+{
+    return sourcePath + ".atb";
+}
+
+SourceStamp TreeCache::stamp(const std::string &sourcePath, const char *data, size_t size)
+{
+    SourceStamp s;
+    s.size = size;
+    std::error_code ec;
+    auto mtime = std::filesystem::last_write_time(sourcePath, ec);
+    s.mtime = ec ? 0 : static_cast<int64_t>(mtime.time_since_epoch().count());
+
+    // Impressão digital amostrada: arquivos pequenos são lidos por inteiro;
+    // nos grandes, início, fim e 16 blocos espaçados bastam (junto com
+    // tamanho e mtime) sem precisar ler o arquivo todo a cada verificação.
+    const size_t EDGE = 64 * 1024;
+    const size_t BLOCK = 4 * 1024;
+    const size_t SAMPLES = 16;
+    uint64_t h = mix(0xCBF29CE484222325ull, size);
+    if (size <= 4 * EDGE)
+    {
+        h = hashBlock(h, data, size);
+    }
+    else
+    {
+        h = hashBlock(h, data, EDGE);
+        size_t span = size - 2 * EDGE - BLOCK;
+        for (size_t i = 0; i < SAMPLES; ++i)
+            h = hashBlock(h, data + EDGE + span * i / (SAMPLES - 1), BLOCK);
+        h = hashBlock(h, data + size - EDGE, EDGE);
+    }
+    s.hash = h;
+    return s;
+}
+
+bool TreeCache::load(const std::string &cachePath, const SourceStamp &expected, ArterialTree &outTree)
+{
+    MappedFile file;
+    if (!file.open(cachePath) || file.size() < sizeof(AtbHeader))
+        return false;
+
+    AtbHeader header;
+    std::memcpy(&header, file.data(), sizeof(AtbHeader));
+    if (std::memcmp(header.magic, ATB_MAGIC, 4) != 0 || header.version != ATB_VERSION ||
+        header.byteOrder != ATB_BYTE_ORDER || header.headerSize != sizeof(AtbHeader))
+        return false;
+    if (!sameStamp(header, expected))
+        return false;
+
+    // Cada seção precisa caber no arquivo (contagens limitadas pelo tamanho,
+    // logo os produtos não estouram)
+    const uint64_t fileSize = file.size();
+    if (header.nodeCount == 0 || header.segmentCount == 0 ||
+        header.nodeCount > fileSize / 12 || header.segmentCount > fileSize / 12 ||
+        !sectionFits(header.positionsOffset, header.nodeCount * 12, fileSize) ||
+        !sectionFits(header.indicesOffset, header.segmentCount * 8, fileSize) ||
+        !sectionFits(header.radiiOffset, header.segmentCount * 4, fileSize))
+    {
+        std::cerr << "[TreeCache] Cache corrompido, será regenerado: " << cachePath << std::endl;
+        return false;
+    }
+
+    const size_t nodeCount = static_cast<size_t>(header.nodeCount);
+    const size_t segmentCount = static_cast<size_t>(header.segmentCount);
+    outTree.nodes.resize(nodeCount);
+    std::memcpy(outTree.nodes.data(), file.data() + header.positionsOffset, nodeCount * sizeof(ArterialNode));
+
+    const char *indices = file.data() + header.indicesOffset;
+    const char *radii = file.data() + header.radiiOffset;
+    outTree.segments.resize(segmentCount);
+    for (size_t i = 0; i < segmentCount; ++i)
+    {
+        int32_t pair[2];
+        std::memcpy(pair, indices + i * 8, 8);
+        if (pair[0] < 0 || pair[1] < 0 || static_cast<size_t>(pair[0]) >= nodeCount || static_cast<size_t>(pair[1]) >= nodeCount)
+        {
+            std::cerr << "[TreeCache] Cache corrompido, será regenerado: " << cachePath << std::endl;
+            outTree.nodes.clear();
+            outTree.segments.clear();
+            return false;
+        }
+        ArterialSegment &seg = outTree.segments[i];
+        seg.indexA = pair[0];
+        seg.indexB = pair[1];
+        std::memcpy(&seg.radius, radii + i * 4, 4);
+    }
+    outTree.applyNormalization(glm::vec3(header.center[0], header.center[1], header.center[2]), header.scale,
+                               header.radiusFix);
+    outTree.updateMidpoints();
+    return true;
+}
+
+bool TreeCache::save(const std::string &cachePath, const SourceStamp &stamp, const ArterialTree &tree)
+{
+    AtbHeader header = {};
+    std::memcpy(header.magic, ATB_MAGIC, 4);
+    header.version = ATB_VERSION;
+    header.byteOrder = ATB_BYTE_ORDER;
+    header.headerSize = sizeof(AtbHeader);
+    header.sourceSize = stamp.size;
+    header.sourceMtime = stamp.mtime;
+    header.sourceHash = stamp.hash;
+    header.nodeCount = tree.nodes.size();
+    header.segmentCount = tree.segments.size();
+    header.center[0] = tree.normCenter.x;
+    header.center[1] = tree.normCenter.y;
+    header.center[2] = tree.normCenter.z;
+    header.scale = tree.normScale;
+    header.radiusFix = tree.normRadiusFix;
+    header.positionsOffset = sizeof(AtbHeader);
+    header.indicesOffset = align8(header.positionsOffset + header.nodeCount * 12);
+    header.radiiOffset = header.indicesOffset + header.segmentCount * 8;
+
+    std::vector<int32_t> indices(tree.segments.size() * 2);
+    std::vector<float> radii(tree.segments.size());
+    std::vector<glm::vec3> positions(tree.nodes.size());
+    for (size_t i = 0; i < tree.segments.size(); ++i)
+    {
+        indices[2 * i] = tree.segments[i].indexA;
+        indices[2 * i + 1] = tree.segments[i].indexB;
+        radii[i] = tree.rawRadius(i);
+    }
+    for (size_t i = 0; i < tree.nodes.size(); ++i)
+        positions[i] = tree.rawPosition(i);
+
+    // Grava em arquivo temporário próprio e renomeia (substituição atômica):
+    // um leitor concorrente nunca enxerga um cache pela metade
+    std::string tmpPath = uniqueTempPath(cachePath);
+    {
+        std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+        if (out.is_open())
+        {
+            const char padding[8] = {};
+            out.write(reinterpret_cast<const char *>(&header), sizeof(AtbHeader));
+            out.write(reinterpret_cast<const char *>(positions.data()), positions.size() * sizeof(glm::vec3));
+            out.write(padding, header.indicesOffset - (header.positionsOffset + header.nodeCount * 12));
+            out.write(reinterpret_cast<const char *>(indices.data()), indices.size() * sizeof(int32_t));
+            out.write(reinterpret_cast<const char *>(radii.data()), radii.size() * sizeof(float));
+        }
+        if (out.good())
+        {
+            out.close();
+            std::error_code ec;
+            std::filesystem::rename(tmpPath, cachePath, ec);
+            if (!ec)
+                return true;
+        }
+    }
+    std::error_code ec;
+    std::filesystem::remove(tmpPath, ec);
+    // Diretórios somente-leitura falhariam a cada frame: avisa uma única vez
+    static std::atomic<bool> warned(false);
+    if (!warned.exchange(true))
+        std::cerr << "[TreeCache] Não foi possível gravar cache: " << cachePath << " (aviso exibido uma vez)" << std::endl;
+    return false;
+}
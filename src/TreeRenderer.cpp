@@ -19,20 +19,23 @@
 #include <vector>
 #include <cmath>
 #include <algorithm>
+#include <cstring>
+#include <iostream>
 #include <limits>
 #include <map>
 #include <glm/glm.hpp>
 
 #include "TreeRenderer.hpp"
-#include "ClippingUtils.hpp"
 #include "Shader.hpp"
+#include "ParallelUtils.hpp"
+#include "VertexCacheUtils.hpp"
 
 // Pipeline programável (OpenGL moderno). Implementa modelos de iluminação
 // Phong e Gouraud via GLSL.
 
-void TreeRenderer::initWireframe(const std::vector<ArterialNode> &nodes, const std::vector<ArterialSegment> &segments,
-                                 bool clipEnabled, glm::vec3 clipMin, glm::vec3 clipMax)
+void TreeRenderer::initWireframe(const ArterialTree &tree)
 {
+    const std::vector<ArterialSegment> &segments = tree.segments;
     // Liberar buffers anteriores se necessário
     if (wireframeBuf.vbo)
         glDeleteBuffers(1, &wireframeBuf.vbo);
@@ -42,42 +45,43 @@ void TreeRenderer::initWireframe(const std::vector<ArterialNode> &nodes, const s
     wireframeBuf.vao = 0;
     wireframeBuf.vertexCount = 0;
 
-    // 1. Encontrar raio mínimo/máximo
+    // 1. Encontrar raio mínimo/máximo (brutos, como as posições do buffer)
     float minRadius = std::numeric_limits<float>::max();
     float maxRadius = -std::numeric_limits<float>::max();
-    for (const auto &seg : segments)
+    for (size_t i = 0; i < segments.size(); ++i)
     {
-        minRadius = std::min(minRadius, seg.radius);
-        maxRadius = std::max(maxRadius, seg.radius);
+        minRadius = std::min(minRadius, tree.rawRadius(i));
+        maxRadius = std::max(maxRadius, tree.rawRadius(i));
     }
 
-    // 2. Buffer intercalado: posição (vec3), cor (vec3), segmentID (int)
+    // 2. Buffer intercalado: posição bruta (vec3), segmentID (int). A
+    // normalização entra na matriz do shader; a cor vem do raio do segmento,
+    // lido no shader pelo segmentID
     struct WireframeVertex
     {
         glm::vec3 pos;
-        glm::vec3 color;
         int segmentID;
     };
     std::vector<WireframeVertex> data;
+    std::vector<glm::vec2> scalars(segments.size());
     data.reserve(segments.size() * 2);
     for (size_t i = 0; i < segments.size(); ++i)
     {
         const auto &seg = segments[i];
-        glm::vec3 tempA = nodes[seg.indexA].position;
-        glm::vec3 tempB = nodes[seg.indexB].position;
-        bool keep = true;
-        if (clipEnabled)
-        {
-            keep = ClippingUtils::clipSegment(tempA, tempB, clipMin, clipMax);
-        }
-        if (!keep)
-            continue;
-        glm::vec3 colorA = getHeatMapColor(seg.radius, minRadius, maxRadius);
-        glm::vec3 colorB = getHeatMapColor(seg.radius, minRadius, maxRadius);
-        data.push_back(WireframeVertex{tempA, colorA, static_cast<int>(i)});
-        data.push_back(WireframeVertex{tempB, colorB, static_cast<int>(i)});
+        // O recorte pela caixa é feito no vertex shader (gl_ClipDistance)
+        data.push_back(WireframeVertex{tree.rawPosition(seg.indexA), static_cast<int>(i)});
+        data.push_back(WireframeVertex{tree.rawPosition(seg.indexB), static_cast<int>(i)});
+        scalars[i] = glm::vec2(tree.rawRadius(i));
     }
+    normCenter = tree.normCenter;
+    normScale = tree.normScale;
+    normRadiusFix = tree.normRadiusFix;
+    lodChecked = false;
     wireframeBuf.vertexCount = data.size();
+    scalarMin = segments.empty() ? 0.0f : minRadius;
+    scalarMax = segments.empty() ? 1.0f : maxRadius;
+    nodeScalarOffset = static_cast<int>(segments.size());
+    uploadScalars(scalars, 0);
 
     glGenVertexArrays(1, &wireframeBuf.vao);
     glGenBuffers(1, &wireframeBuf.vbo);
@@ -87,9 +91,6 @@ void TreeRenderer::initWireframe(const std::vector<ArterialNode> &nodes, const s
     // Attribute 0: position (x, y, z)
     glEnableVertexAttribArray(0);
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(WireframeVertex), (void *)offsetof(WireframeVertex, pos));
-    // Attribute 2: color (r, g, b)
-    glEnableVertexAttribArray(2);
-    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(WireframeVertex), (void *)offsetof(WireframeVertex, color));
     // Attribute 3: segmentID (int)
     glEnableVertexAttribArray(3);
     glVertexAttribIPointer(3, 1, GL_INT, sizeof(WireframeVertex), (void *)offsetof(WireframeVertex, segmentID));
@@ -99,74 +100,982 @@ void TreeRenderer::initWireframe(const std::vector<ArterialNode> &nodes, const s
 void TreeRenderer::drawWireframe(Shader &shader, const glm::mat4 &view, const glm::mat4 &projection, const glm::mat4 &model, float width, int selectedSegmentID)
 {
     shader.use();
-    shader.setMat4("model", model);
+    applyNormalization(shader, model);
     shader.setMat4("view", view);
     shader.setMat4("projection", projection);
     shader.setInt("selectedSegmentID", selectedSegmentID);
+    applyClipBox(shader, true);
+    applyColormap(shader);
     glLineWidth(width);
     glBindVertexArray(wireframeBuf.vao);
     glDrawArrays(GL_LINES, 0, static_cast<GLsizei>(wireframeBuf.vertexCount));
     glBindVertexArray(0);
+    releaseClipBox();
+}
+
+void TreeRenderer::setClipBox(bool enabled, const glm::vec3 &boxMin, const glm::vec3 &boxMax, bool caps)
+{
+    clipEnabled = enabled;
+    clipMin = boxMin;
+    clipMax = boxMax;
+    clipCaps = caps;
+}
+
+void TreeRenderer::applyClipBox(Shader &shader, bool clipPlanes) const
+{
+    // Os shaders recortam as posições brutas: a caixa volta para essas coordenadas
+    shader.setBool("clipEnabled", clipEnabled);
+    shader.setBool("clipCaps", clipEnabled && clipCaps);
+    shader.setVec3("clipMin", clipMin / normScale + normCenter);
+    shader.setVec3("clipMax", clipMax / normScale + normCenter);
+    // Um plano por face da caixa, na ordem de gl_ClipDistance dos shaders
+    for (int i = 0; i < 6; ++i)
+    {
+        if (clipEnabled && clipPlanes)
+            glEnable(GL_CLIP_DISTANCE0 + i);
+        else
+            glDisable(GL_CLIP_DISTANCE0 + i);
+    }
+}
+
+void TreeRenderer::releaseClipBox() const
+{
+    for (int i = 0; i < 6; ++i)
+        glDisable(GL_CLIP_DISTANCE0 + i);
+}
+
+void TreeRenderer::setColormap(Colormap map)
+{
+    if (map != colormap)
+        colormapDirty = true;
+    colormap = map;
+}
+
+void TreeRenderer::uploadScalars(const std::vector<glm::vec2> &values, size_t first)
+{
+    // Trecho [lo, hi) que difere da cópia atual (posições novas sempre diferem)
+    const size_t oldSize = scalarData.size();
+    size_t lo = values.size();
+    size_t hi = 0;
+    for (size_t k = 0; k < values.size(); ++k)
+    {
+        const size_t i = first + k;
+        if (i >= oldSize || std::memcmp(&scalarData[i], &values[k], sizeof(glm::vec2)) != 0)
+        {
+            lo = std::min(lo, k);
+            hi = k + 1;
+        }
+    }
+    if (lo >= hi)
+        return;
+    if (scalarData.size() < first + values.size())
+        scalarData.resize(first + values.size());
+    std::copy(values.begin() + lo, values.begin() + hi, scalarData.begin() + first + lo);
+
+    const size_t texel = sizeof(glm::vec2);
+    GLuint previous = scalarBuffer;
+    scalarBuffer = growBuffer(scalarBuffer, oldSize * texel, scalarCapacity, scalarData.size() * texel);
+    if (scalarBuffer != previous)
+    {
+        // O texture buffer aponta para o buffer da época em que foi associado
+        if (!scalarTexture)
+            glGenTextures(1, &scalarTexture);
+        glBindTexture(GL_TEXTURE_BUFFER, scalarTexture);
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_RG32F, scalarBuffer);
+        glBindTexture(GL_TEXTURE_BUFFER, 0);
+    }
+    glBindBuffer(GL_TEXTURE_BUFFER, scalarBuffer);
+    glBufferSubData(GL_TEXTURE_BUFFER, (first + lo) * texel, (hi - lo) * texel, &scalarData[first + lo]);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+void TreeRenderer::applyColormap(Shader &shader)
+{
+    if (colormapDirty || !colormapTexture)
+    {
+        unsigned char lut[ColormapUtils::LUT_SIZE * 3];
+        ColormapUtils::buildLut(colormap, lut);
+        glActiveTexture(GL_TEXTURE0);
+        if (!colormapTexture)
+        {
+            glGenTextures(1, &colormapTexture);
+            glBindTexture(GL_TEXTURE_1D, colormapTexture);
+            glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+            glTexImage1D(GL_TEXTURE_1D, 0, GL_RGB8, ColormapUtils::LUT_SIZE, 0, GL_RGB, GL_UNSIGNED_BYTE, lut);
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        }
+        else
+        {
+            glBindTexture(GL_TEXTURE_1D, colormapTexture);
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+            glTexSubImage1D(GL_TEXTURE_1D, 0, 0, ColormapUtils::LUT_SIZE, GL_RGB, GL_UNSIGNED_BYTE, lut);
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        }
+        colormapDirty = false;
+    }
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_BUFFER, scalarTexture);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_1D, colormapTexture);
+    shader.setInt("colormap", 0);
+    shader.setInt("scalarBuffer", 1);
+    shader.setInt("nodeScalarOffset", nodeScalarOffset);
+    shader.setFloat("scalarMin", scalarMin);
+    shader.setFloat("scalarMax", scalarMax);
 }
 
 #ifndef M_PI
 #define M_PI 3.14159265358979323846f
 #endif
 
+namespace
+{
+    // Resolução das malhas: fixa, para que cada cilindro e cada esfera
+    // ocupem sempre o mesmo número de vértices e índices (um slot)
+    const int CYLINDER_SIDES = 32;
+    const int SPHERE_SEGMENTS = 32;
+    const size_t CYLINDER_SIGNATURE = 27; // a, b, raioA, raioB, segmentID, anéis A e B
+    const size_t RING_FLOATS = 9;         // tangente, side, miter
+    const size_t SPHERE_SIGNATURE = 5;   // centro, raio, segmentID
+    const uint64_t FREE_SLOT = ~uint64_t(0);
+    const uint64_t ANONYMOUS_SLOT = ~uint64_t(0) - 1; // segmento repetido, sem chave
+    // Divisões de cada nível de detalhe e raio projetado mínimo (pixels) para
+    // usá-lo; trocas de nível exigem passar o limiar com folga de LOD_HYSTERESIS
+    const int LOD_RESOLUTIONS[TreeRenderer::LOD_LEVELS] = {4, 8, 16, 32};
+    const float LOD_MIN_PIXELS[TreeRenderer::LOD_LEVELS] = {0.0f, 1.5f, 4.0f, 10.0f};
+    const float LOD_HYSTERESIS = 1.25f;
+    const uint8_t LOD_UNSET = 0xFF; // item sem nível anterior: sem histerese
+    // Raio mínimo desenhado na árvore normalizada (os vertex shaders recebem
+    // o equivalente bruto, MIN_DRAWN_RADIUS / normScale)
+    const float MIN_DRAWN_RADIUS = 0.002f;
+    // Geração paralela dos slots: área de preparo por lote e trabalho mínimo por thread
+    const size_t STAGING_MAX_BYTES = size_t(64) << 20;
+    const size_t MIN_VERTICES_PER_TASK = 16384;
+
+    // segmentID das esferas: negativo e diferente de -1 (sem seleção)
+    inline int sphereID(size_t node)
+    {
+        return -2 - static_cast<int>(node);
+    }
+
+    inline uint64_t pairKey(int a, int b)
+    {
+        return (uint64_t(uint32_t(a)) << 32) | uint32_t(b);
+    }
+
+    inline float intBits(int v)
+    {
+        float f;
+        std::memcpy(&f, &v, sizeof(float));
+        return f;
+    }
+
+    inline int bitsInt(float f)
+    {
+        int v;
+        std::memcpy(&v, &f, sizeof(int));
+        return v;
+    }
+
+    // Assinatura de cilindro: os anéis vão depois dos 9 campos de posição/raio/ID
+    inline void fillCylinderSignature(float *signature, const glm::vec3 &a, const glm::vec3 &b, float radiusA,
+                                      float radiusB, int segmentID, const TubeRing &ringA, const TubeRing &ringB)
+    {
+        const float head[9] = {a.x, a.y, a.z, b.x, b.y, b.z, radiusA, radiusB, intBits(segmentID)};
+        std::memcpy(signature, head, sizeof(head));
+        float *ring = signature + 9;
+        for (const TubeRing *r : {&ringA, &ringB})
+        {
+            const float fields[RING_FLOATS] = {r->tangent.x, r->tangent.y, r->tangent.z, r->side.x, r->side.y,
+                                               r->side.z, r->miter.x, r->miter.y, r->miter.z};
+            std::memcpy(ring, fields, sizeof(fields));
+            ring += RING_FLOATS;
+        }
+    }
+
+    inline TubeRing readRing(const float *f)
+    {
+        return TubeRing{glm::vec3(f[0], f[1], f[2]), glm::vec3(f[3], f[4], f[5]), glm::vec3(f[6], f[7], f[8])};
+    }
+
+    // Espalha os 10 bits de `v` a cada 3 posições (código de Morton)
+    inline uint32_t spreadBits(uint32_t v)
+    {
+        v &= 0x3FF;
+        v = (v | (v << 16)) & 0x030000FF;
+        v = (v | (v << 8)) & 0x0300F00F;
+        v = (v | (v << 4)) & 0x030C30C3;
+        v = (v | (v << 2)) & 0x09249249;
+        return v;
+    }
+
+    // Código de Morton da célula de `p` (1024 células de lado `cellSize` por
+    // eixo, centradas em `origin`)
+    inline uint32_t chunkKey(const glm::vec3 &p, const glm::vec3 &origin, float cellSize)
+    {
+        uint32_t cell[3];
+        for (int c = 0; c < 3; ++c)
+        {
+            float index = std::floor((p[c] - origin[c]) / cellSize) + 512.0f;
+            cell[c] = static_cast<uint32_t>(std::clamp(index, 0.0f, 1023.0f));
+        }
+        return spreadBits(cell[0]) | (spreadBits(cell[1]) << 1) | (spreadBits(cell[2]) << 2);
+    }
+
+    // Planos do frustum em coordenadas do modelo (Gribb e Hartmann): dentro
+    // quando dot(plano.xyz, p) + plano.w >= 0
+    void extractFrustumPlanes(const glm::mat4 &mvp, glm::vec4 planes[6])
+    {
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            for (int side = 0; side < 2; ++side)
+            {
+                glm::vec4 &plane = planes[axis * 2 + side];
+                for (int c = 0; c < 4; ++c)
+                    plane[c] = mvp[c][3] + (side == 0 ? mvp[c][axis] : -mvp[c][axis]);
+            }
+        }
+    }
+
+    // Caixa fora do frustum: o canto mais à frente de algum plano está atrás dele
+    bool boxOutsideFrustum(const glm::vec3 &lo, const glm::vec3 &hi, const glm::vec4 planes[6])
+    {
+        for (int p = 0; p < 6; ++p)
+        {
+            const glm::vec4 &plane = planes[p];
+            glm::vec3 corner(plane.x >= 0.0f ? hi.x : lo.x, plane.y >= 0.0f ? hi.y : lo.y,
+                             plane.z >= 0.0f ? hi.z : lo.z);
+            if (plane.x * corner.x + plane.y * corner.y + plane.z * corner.z + plane.w < 0.0f)
+                return true;
+        }
+        return false;
+    }
+}
+
+glm::mat4 TreeRenderer::normalization() const
+{
+    glm::mat4 m(normScale);
+    m[3] = glm::vec4(-normCenter * normScale, 1.0f);
+    return m;
+}
+
+float TreeRenderer::drawnRadius(float radius) const
+{
+    // O mínimo de MIN_DRAWN_RADIUS vale na árvore normalizada
+    return std::max(radius * normRadiusFix * radiusScale, MIN_DRAWN_RADIUS / normScale);
+}
+
+void TreeRenderer::applyNormalization(Shader &shader, const glm::mat4 &model) const
+{
+    shader.setMat4("model", model * normalization());
+    shader.setFloat("radiusFactor", normRadiusFix * radiusScale);
+    shader.setFloat("minRadius", MIN_DRAWN_RADIUS / normScale);
+}
+
 TreeRenderer::~TreeRenderer()
 {
-    if (EBO)
-        glDeleteBuffers(1, &EBO);
-    if (VBO)
-        glDeleteBuffers(1, &VBO);
-    if (VAO)
-        glDeleteVertexArrays(1, &VAO);
+    deleteChunks();
+    deleteInstanceBuffers(cylinderInstances);
+    deleteInstanceBuffers(sphereInstances);
+    if (scalarTexture)
+        glDeleteTextures(1, &scalarTexture);
+    if (scalarBuffer)
+        glDeleteBuffers(1, &scalarBuffer);
+    if (colormapTexture)
+        glDeleteTextures(1, &colormapTexture);
+}
+
+void TreeRenderer::deletePool(MeshPool &pool)
+{
+    if (pool.ebo)
+        glDeleteBuffers(1, &pool.ebo);
+    if (pool.vbo)
+        glDeleteBuffers(1, &pool.vbo);
+    if (pool.vao)
+        glDeleteVertexArrays(1, &pool.vao);
+    pool.vao = pool.vbo = pool.ebo = 0;
+    pool.vertexCapacity = 0;
+    pool.indexCapacity = 0;
+    resetPool(pool);
+}
+
+void TreeRenderer::resetPool(MeshPool &pool)
+{
+    pool.slotCount = 0;
+    pool.liveCount = 0;
+    pool.owner.clear();
+    pool.generation.clear();
+    pool.signatures.clear();
+    pool.freeSlots.clear();
+    pool.dirty.clear();
+    pool.slotOf.clear();
+}
+
+TreeRenderer::MeshChunk &TreeRenderer::chunkAt(const glm::vec3 &p)
+{
+    if (chunks.empty())
+    {
+        chunkOrigin = normCenter;
+        chunkCellSize = CHUNK_SIZE / normScale;
+    }
+    auto inserted = chunks.try_emplace(chunkKey(p, chunkOrigin, chunkCellSize));
+    MeshChunk &chunk = inserted.first->second;
+    if (inserted.second)
+    {
+        for (int level = 0; level < LOD_LEVELS; ++level)
+        {
+            const int n = LOD_RESOLUTIONS[level];
+            MeshPool &cylinders = chunk.cylinderPools[level];
+            cylinders.level = level;
+            cylinders.resolution = n;
+            cylinders.vertsPerSlot = 2 * (n + 1);
+            cylinders.indicesPerSlot = 6 * n;
+            cylinders.signatureSize = CYLINDER_SIGNATURE;
+            MeshPool &spheres = chunk.spherePools[level];
+            spheres.sphere = true;
+            spheres.level = level;
+            spheres.resolution = n;
+            spheres.vertsPerSlot = (n + 1) * (n + 1);
+            spheres.indicesPerSlot = 6 * n * n;
+            spheres.signatureSize = SPHERE_SIGNATURE;
+        }
+    }
+    return chunk;
+}
+
+void TreeRenderer::deleteChunks()
+{
+    for (auto &entry : chunks)
+    {
+        for (int level = 0; level < LOD_LEVELS; ++level)
+        {
+            deletePool(entry.second.cylinderPools[level]);
+            deletePool(entry.second.spherePools[level]);
+        }
+    }
+    chunks.clear();
+}
+
+void TreeRenderer::init(const ArterialTree &tree, bool showSpheres)
+{
+    normCenter = tree.normCenter;
+    normScale = tree.normScale;
+    normRadiusFix = tree.normRadiusFix;
+    lodChecked = false;
+    if (renderPath == RenderPath::Mesh)
+        buildMeshes(tree, showSpheres);
+    else
+        buildInstances(tree, showSpheres);
+}
+
+void TreeRenderer::setRenderPath(RenderPath path)
+{
+    if (path == renderPath)
+        return;
+    // Instanciado e impostor compartilham as instâncias, mas não a malha unitária
+    if (renderPath == RenderPath::Mesh)
+    {
+        deleteChunks();
+        cylinderLod.clear();
+        sphereLod.clear();
+    }
+    else
+    {
+        deleteInstanceBuffers(cylinderInstances);
+        deleteInstanceBuffers(sphereInstances);
+    }
+    renderPath = path;
+}
+
+// Malha unitária: cilindro de raio 1 ao longo de z em [0, 1], com cada vértice
+// em (cos θ, sin θ, t), ou esfera de raio 1 (posição = normal). O vertex
+// shader posiciona, orienta e escala cada instância. No impostor a malha é a
+// caixa envolvente: [-1, 1]² x [0, 1] (cilindro) ou [-1, 1]³ (esfera).
+void TreeRenderer::createUnitMesh(InstanceBuffers &buffers, bool sphere)
+{
+    std::vector<Vertex> vertices;
+    std::vector<unsigned int> indices;
+    if (renderPath == RenderPath::Impostor)
+    {
+        // Vértice i = (x, y, z) com x = bit 0, y = bit 1, z = bit 2; faces em
+        // sentido anti-horário vistas de fora
+        static const unsigned int BOX_INDICES[36] = {4, 6, 2, 4, 2, 0, 1, 3, 7, 1, 7, 5,
+                                                     0, 1, 5, 0, 5, 4, 6, 7, 3, 6, 3, 2,
+                                                     2, 3, 1, 2, 1, 0, 4, 5, 7, 4, 7, 6};
+        const float zMin = sphere ? -1.0f : 0.0f;
+        for (unsigned int i = 0; i < 8; ++i)
+        {
+            glm::vec3 corner((i & 1) ? 1.0f : -1.0f, (i & 2) ? 1.0f : -1.0f, (i & 4) ? 1.0f : zMin);
+            vertices.push_back(Vertex{corner, glm::vec3(0.0f), -1, 0.0f});
+        }
+        indices.assign(BOX_INDICES, BOX_INDICES + 36);
+    }
+    else if (sphere)
+    {
+        vertices.resize((SPHERE_SEGMENTS + 1) * (SPHERE_SEGMENTS + 1));
+        indices.resize(6 * SPHERE_SEGMENTS * SPHERE_SEGMENTS);
+        generateSphere(glm::vec3(0.0f), 1.0f, -1, SPHERE_SEGMENTS, vertices.data(), indices.data(), 0);
+        // A malha unitária é lida só pela posição: ponto da superfície
+        for (Vertex &v : vertices)
+            v.pos = v.normal;
+    }
+    else
+    {
+        for (int i = 0; i <= CYLINDER_SIDES; ++i)
+        {
+            float theta = (float)i / (float)CYLINDER_SIDES * 2.0f * (float)M_PI;
+            glm::vec3 ring(cosf(theta), sinf(theta), 0.0f);
+            vertices.push_back(Vertex{ring, ring, -1, 0.0f});
+            vertices.push_back(Vertex{ring + glm::vec3(0.0f, 0.0f, 1.0f), ring, -1, 0.0f});
+        }
+        // Mesma ordem de índices de generateCylinder
+        for (int i = 0; i < CYLINDER_SIDES; ++i)
+        {
+            unsigned int current = i * 2;
+            unsigned int next = (i + 1) * 2;
+            indices.push_back(current);
+            indices.push_back(current + 1);
+            indices.push_back(next);
+            indices.push_back(current + 1);
+            indices.push_back(next + 1);
+            indices.push_back(next);
+        }
+    }
+
+    glGenVertexArrays(1, &buffers.vao);
+    glGenBuffers(1, &buffers.meshVbo);
+    glGenBuffers(1, &buffers.meshEbo);
+    glBindVertexArray(buffers.vao);
+    glBindBuffer(GL_ARRAY_BUFFER, buffers.meshVbo);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), vertices.data(), GL_STATIC_DRAW);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void *)offsetof(Vertex, pos));
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffers.meshEbo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+    glBindVertexArray(0);
+    buffers.indexCount = indices.size();
+}
+
+void TreeRenderer::deleteInstanceBuffers(InstanceBuffers &buffers)
+{
+    if (buffers.instanceVbo)
+        glDeleteBuffers(1, &buffers.instanceVbo);
+    if (buffers.meshEbo)
+        glDeleteBuffers(1, &buffers.meshEbo);
+    if (buffers.meshVbo)
+        glDeleteBuffers(1, &buffers.meshVbo);
+    if (buffers.vao)
+        glDeleteVertexArrays(1, &buffers.vao);
+    buffers = InstanceBuffers();
+}
+
+void TreeRenderer::uploadInstances(InstanceBuffers &buffers, const std::vector<VesselInstance> &instances, size_t first)
+{
+    buffers.instanceCount = first + instances.size();
+    if (instances.empty())
+        return;
+    if (!buffers.vao)
+        createUnitMesh(buffers, &buffers == &sphereInstances);
+
+    const size_t stride = sizeof(VesselInstance);
+    glBindVertexArray(buffers.vao);
+    GLuint previous = buffers.instanceVbo;
+    buffers.instanceVbo = growBuffer(buffers.instanceVbo, first * stride, buffers.instanceCapacity,
+                                     buffers.instanceCount * stride);
+    glBindBuffer(GL_ARRAY_BUFFER, buffers.instanceVbo);
+    if (buffers.instanceVbo != previous)
+    {
+        // Atributos por instância (divisor 1), locations 4 a 6
+        glEnableVertexAttribArray(4);
+        glVertexAttribPointer(4, 4, GL_FLOAT, GL_FALSE, stride, (void *)offsetof(VesselInstance, a));
+        glVertexAttribDivisor(4, 1);
+        glEnableVertexAttribArray(5);
+        glVertexAttribPointer(5, 4, GL_FLOAT, GL_FALSE, stride, (void *)offsetof(VesselInstance, b));
+        glVertexAttribDivisor(5, 1);
+        glEnableVertexAttribArray(6);
+        glVertexAttribIPointer(6, 1, GL_INT, stride, (void *)offsetof(VesselInstance, segmentID));
+        glVertexAttribDivisor(6, 1);
+    }
+    glBufferSubData(GL_ARRAY_BUFFER, first * stride, instances.size() * stride, instances.data());
+    glBindVertexArray(0);
+}
+
+// Atributos do Vertex (ou PackedVertex) a partir do VBO atual (o VAO deve estar vinculado)
+void TreeRenderer::setupMeshAttributes()
+{
+    if (vertexLayout == VertexLayout::Packed)
+    {
+        // Normalizados para [0, 1] / [-1, 1]; escala e sinal do ID no shader
+        GLsizei stride = sizeof(PackedVertex);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_TRUE, stride, (void *)offsetof(PackedVertex, pos));
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 2, GL_SHORT, GL_TRUE, stride, (void *)offsetof(PackedVertex, normal));
+        glEnableVertexAttribArray(3);
+        glVertexAttribIPointer(3, 1, GL_INT, stride, (void *)offsetof(PackedVertex, segmentID));
+        glEnableVertexAttribArray(4);
+        glVertexAttribPointer(4, 1, GL_UNSIGNED_SHORT, GL_TRUE, stride, (void *)offsetof(PackedVertex, radius));
+        return;
+    }
+    GLsizei stride = sizeof(Vertex);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void *)offsetof(Vertex, pos));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (void *)offsetof(Vertex, normal));
+    glEnableVertexAttribArray(3);
+    glVertexAttribIPointer(3, 1, GL_INT, stride, (void *)offsetof(Vertex, segmentID));
+    glEnableVertexAttribArray(4);
+    glVertexAttribPointer(4, 1, GL_FLOAT, GL_FALSE, stride, (void *)offsetof(Vertex, radius));
+}
+
+size_t TreeRenderer::vertexSize() const
+{
+    return vertexLayout == VertexLayout::Packed ? sizeof(PackedVertex) : sizeof(Vertex);
+}
+
+void TreeRenderer::setVertexLayout(VertexLayout layout)
+{
+    if (layout == vertexLayout)
+        return;
+    deleteChunks();
+    cylinderLod.clear();
+    sphereLod.clear();
+    quantValid = false;
+    vertexLayout = layout;
+}
+
+void TreeRenderer::setOptimizeIndexOrder(bool enabled)
+{
+    if (enabled == optimizeIndexOrder)
+        return;
+    deleteChunks();
+    for (int level = 0; level < LOD_LEVELS; ++level)
+    {
+        cylinderOrders[level].indices.clear();
+        sphereOrders[level].indices.clear();
+    }
+    cylinderLod.clear();
+    sphereLod.clear();
+    optimizeIndexOrder = enabled;
+}
+
+void TreeRenderer::buildIndexOrder(IndexOrder &order, bool sphere, int resolution) const
+{
+    // Primitiva unitária; a ordem vale para qualquer slot, pois só a posição
+    // dos vértices muda de um para outro
+    const size_t vertexCount = sphere ? (resolution + 1) * (resolution + 1) : 2 * (resolution + 1);
+    std::vector<Vertex> vertices(vertexCount);
+    std::vector<unsigned int> indices(sphere ? 6 * resolution * resolution : 6 * resolution);
+    if (sphere)
+    {
+        generateSphere(glm::vec3(0.0f), 1.0f, 0, resolution, vertices.data(), indices.data(), 0);
+    }
+    else
+    {
+        const TubeRing ring = TubeUtils::plainRing(glm::vec3(0.0f, 0.0f, 1.0f));
+        generateCylinder(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, 1.0f), 1.0f, 1.0f, 0, ring, ring, resolution,
+                         vertices.data(), indices.data(), 0);
+    }
+    order.acmrGenerated = VertexCacheUtils::acmr(indices, vertices.size());
+    order.indices = indices;
+    order.acmrUsed = order.acmrGenerated;
+    if (!optimizeIndexOrder)
+        return;
+
+    std::vector<glm::vec3> positions(vertices.size());
+    for (size_t v = 0; v < vertices.size(); ++v)
+        positions[v] = vertices[v].pos + vertices[v].normal * vertices[v].radius;
+    std::vector<size_t> clusters;
+    std::vector<unsigned int> reordered = VertexCacheUtils::tipsify(indices, vertices.size(), clusters);
+    reordered = VertexCacheUtils::sortClustersForOverdraw(reordered, clusters, positions);
+    // O tubo aberto já sai em faixa (ACMR ~1): só troca se melhorar
+    const float acmrReordered = VertexCacheUtils::acmr(reordered, vertices.size());
+    if (acmrReordered < order.acmrGenerated)
+    {
+        order.indices.swap(reordered);
+        order.acmrUsed = acmrReordered;
+    }
+}
+
+const IndexOrder &TreeRenderer::indexOrderFor(const MeshPool &pool) const
+{
+    return pool.sphere ? sphereOrders[pool.level] : cylinderOrders[pool.level];
+}
+
+IndexOrderStats TreeRenderer::getIndexOrderStats() const
+{
+    IndexOrderStats stats;
+    double before = 0.0;
+    double after = 0.0;
+    for (const auto &entry : chunks)
+    {
+        for (int level = 0; level < LOD_LEVELS; ++level)
+        {
+            for (const MeshPool *pool : {&entry.second.cylinderPools[level], &entry.second.spherePools[level]})
+            {
+                const IndexOrder &order = indexOrderFor(*pool);
+                if (order.indices.empty())
+                    continue;
+                const size_t triangles = pool->liveCount * pool->indicesPerSlot / 3;
+                before += order.acmrGenerated * triangles;
+                after += order.acmrUsed * triangles;
+                stats.triangles += triangles;
+            }
+        }
+    }
+    if (stats.triangles > 0)
+    {
+        stats.acmrBefore = static_cast<float>(before / stats.triangles);
+        stats.acmrAfter = static_cast<float>(after / stats.triangles);
+    }
+    return stats;
+}
+
+void TreeRenderer::growQuantization(const glm::vec3 &lo, const glm::vec3 &hi, float maxRadius)
+{
+    if (vertexLayout != VertexLayout::Packed)
+        return;
+    bool inside = quantValid && maxRadius <= quantRadiusMax;
+    for (int c = 0; c < 3 && inside; ++c)
+        inside = lo[c] >= quantMin[c] && hi[c] <= quantMax[c];
+    if (inside)
+        return;
+    // Folga de 25% para que pequenas variações entre frames não requantizem tudo
+    glm::vec3 newMin = quantValid ? glm::min(lo, quantMin) : lo;
+    glm::vec3 newMax = quantValid ? glm::max(hi, quantMax) : hi;
+    glm::vec3 margin = glm::max(newMax - newMin, glm::vec3(1e-3f)) * 0.25f;
+    quantMin = newMin - margin;
+    quantMax = newMax + margin;
+    quantRadiusMax = std::max(maxRadius * 1.25f, quantValid ? quantRadiusMax : 1e-6f);
+    quantValid = true;
+    for (auto &entry : chunks)
+    {
+        for (int level = 0; level < LOD_LEVELS; ++level)
+        {
+            for (MeshPool *pool : {&entry.second.cylinderPools[level], &entry.second.spherePools[level]})
+            {
+                for (uint32_t slot = 0; slot < pool->slotCount; ++slot)
+                {
+                    if (pool->owner[slot] != FREE_SLOT)
+                        pool->dirty.push_back(slot);
+                }
+            }
+        }
+    }
+}
+
+PackedVertex TreeRenderer::packVertex(const Vertex &v) const
+{
+    PackedVertex packed;
+    const glm::vec3 unit = glm::clamp((v.pos - quantMin) / (quantMax - quantMin), 0.0f, 1.0f);
+    for (int c = 0; c < 3; ++c)
+        packed.pos[c] = static_cast<uint16_t>(std::lround(unit[c] * 65535.0f));
+    packed.radius = static_cast<uint16_t>(std::lround(std::clamp(v.radius / quantRadiusMax, 0.0f, 1.0f) * 65535.0f));
+    // Octaedro: projeta na norma L1 e dobra o hemisfério inferior
+    glm::vec3 n = v.normal / std::max(std::abs(v.normal.x) + std::abs(v.normal.y) + std::abs(v.normal.z), 1e-20f);
+    glm::vec2 oct(n.x, n.y);
+    if (n.z < 0.0f)
+    {
+        oct = glm::vec2((1.0f - std::abs(n.y)) * (n.x >= 0.0f ? 1.0f : -1.0f),
+                        (1.0f - std::abs(n.x)) * (n.y >= 0.0f ? 1.0f : -1.0f));
+    }
+    packed.normal[0] = static_cast<int16_t>(std::lround(std::clamp(oct.x, -1.0f, 1.0f) * 32767.0f));
+    packed.normal[1] = static_cast<int16_t>(std::lround(std::clamp(oct.y, -1.0f, 1.0f) * 32767.0f));
+    packed.segmentID = static_cast<uint32_t>(v.segmentID) & 0xFFFFFFu;
+    return packed;
 }
 
-// Helper: Gradiente de Cor (Mapa de Calor)
-glm::vec3 TreeRenderer::getHeatMapColor(float value, float minVal, float maxVal)
+void TreeRenderer::beginProgressive()
 {
-    if (maxVal - minVal < 0.00001f)
-        return glm::vec3(0.0f, 1.0f, 0.0f);
+    // Os buffers são mantidos; apenas nenhum slot é desenhado até o primeiro lote
+    ++meshGeneration;
+    for (auto &entry : chunks)
+    {
+        for (int level = 0; level < LOD_LEVELS; ++level)
+        {
+            resetPool(entry.second.cylinderPools[level]);
+            resetPool(entry.second.spherePools[level]);
+        }
+        entry.second.hasBounds = false;
+    }
+    cylinderInstances.instanceCount = 0;
+    sphereInstances.instanceCount = 0;
+}
 
-    float t = (value - minVal) / (maxVal - minVal);
-    t = std::clamp(t, 0.0f, 1.0f);
+void TreeRenderer::useSlot(MeshPool &pool, uint64_t key, const float *signature)
+{
+    const size_t sigSize = pool.signatureSize;
+    auto it = pool.slotOf.find(key);
+    if (it != pool.slotOf.end() && pool.generation[it->second] != meshGeneration)
+    {
+        // Mesmo dono da atualização anterior: regrava só se a assinatura mudou
+        const uint32_t slot = it->second;
+        pool.generation[slot] = meshGeneration;
+        float *stored = &pool.signatures[slot * sigSize];
+        if (std::memcmp(stored, signature, sigSize * sizeof(float)) != 0)
+        {
+            std::memcpy(stored, signature, sigSize * sizeof(float));
+            pool.dirty.push_back(slot);
+        }
+        return;
+    }
 
-    // Gradiente: Azul (Fino) -> Verde -> Vermelho (Grosso)
-    if (t < 0.5f)
+    uint32_t slot;
+    if (!pool.freeSlots.empty())
     {
-        return glm::mix(glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 1.0f, 0.0f), t * 2.0f);
+        slot = pool.freeSlots.back();
+        pool.freeSlots.pop_back();
     }
     else
     {
-        return glm::mix(glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(1.0f, 0.0f, 0.0f), (t - 0.5f) * 2.0f);
+        slot = static_cast<uint32_t>(pool.slotCount++);
+        pool.owner.push_back(FREE_SLOT);
+        pool.generation.push_back(0);
+        pool.signatures.resize(pool.slotCount * sigSize);
+    }
+    const bool keyed = it == pool.slotOf.end();
+    pool.owner[slot] = keyed ? key : ANONYMOUS_SLOT;
+    if (keyed)
+        pool.slotOf.emplace(key, slot);
+    pool.generation[slot] = meshGeneration;
+    std::memcpy(&pool.signatures[slot * sigSize], signature, sigSize * sizeof(float));
+    pool.dirty.push_back(slot);
+    ++pool.liveCount;
+}
+
+void TreeRenderer::releaseStaleSlots(MeshPool &pool)
+{
+    for (uint32_t slot = 0; slot < pool.slotCount; ++slot)
+    {
+        const uint64_t key = pool.owner[slot];
+        if (key == FREE_SLOT || pool.generation[slot] == meshGeneration)
+            continue;
+        if (key != ANONYMOUS_SLOT)
+            pool.slotOf.erase(key);
+        pool.owner[slot] = FREE_SLOT;
+        pool.freeSlots.push_back(slot);
+        pool.dirty.push_back(slot);
+        --pool.liveCount;
+    }
+}
+
+// Gera a geometria de um slot a partir da sua assinatura. Slots livres viram
+// triângulos degenerados (todos os índices no primeiro vértice do slot).
+void TreeRenderer::generateSlot(const MeshPool &pool, uint32_t slot, Vertex *vertices, unsigned int *indices) const
+{
+    const float *sig = &pool.signatures[slot * pool.signatureSize];
+    const unsigned int base = static_cast<unsigned int>(slot * pool.vertsPerSlot);
+    if (pool.owner[slot] == FREE_SLOT)
+    {
+        std::fill(vertices, vertices + pool.vertsPerSlot, Vertex{glm::vec3(0.0f), glm::vec3(0.0f), -1, 0.0f});
+        std::fill(indices, indices + pool.indicesPerSlot, base);
+    }
+    else if (!pool.sphere)
+    {
+        generateCylinder(glm::vec3(sig[0], sig[1], sig[2]), glm::vec3(sig[3], sig[4], sig[5]), sig[6], sig[7],
+                         bitsInt(sig[8]), readRing(sig + 9), readRing(sig + 9 + RING_FLOATS), pool.resolution,
+                         vertices, indices, base);
+    }
+    else
+    {
+        generateSphere(glm::vec3(sig[0], sig[1], sig[2]), sig[3], bitsInt(sig[4]),
+                       pool.resolution, vertices, indices, base);
+    }
+    if (pool.owner[slot] != FREE_SLOT)
+    {
+        const std::vector<unsigned int> &order = indexOrderFor(pool).indices;
+        for (size_t k = 0; k < pool.indicesPerSlot; ++k)
+            indices[k] = base + order[k];
+    }
+}
+
+void TreeRenderer::uploadDirtySlots(MeshPool &pool)
+{
+    if (pool.dirty.empty())
+        return;
+    IndexOrder &order = pool.sphere ? sphereOrders[pool.level] : cylinderOrders[pool.level];
+    if (order.indices.empty())
+        buildIndexOrder(order, pool.sphere, pool.resolution);
+    if (!pool.vao)
+    {
+        glGenVertexArrays(1, &pool.vao);
+        glGenBuffers(1, &pool.vbo);
+        glGenBuffers(1, &pool.ebo);
+    }
+    const size_t slotVertexBytes = pool.vertsPerSlot * vertexSize();
+    const size_t slotIndexBytes = pool.indicesPerSlot * sizeof(unsigned int);
+
+    // Buffers com folga (crescem ao menos 2x): novos slots não recriam a malha
+    glBindVertexArray(pool.vao);
+    GLuint previousVBO = pool.vbo;
+    pool.vbo = growBuffer(pool.vbo, pool.vertexCapacity, pool.vertexCapacity, pool.slotCount * slotVertexBytes);
+    glBindBuffer(GL_ARRAY_BUFFER, pool.vbo);
+    // Os ponteiros de atributo guardam o VBO da época em que foram definidos
+    if (pool.vbo != previousVBO || previousVBO == 0)
+        setupMeshAttributes();
+    pool.ebo = growBuffer(pool.ebo, pool.indexCapacity, pool.indexCapacity, pool.slotCount * slotIndexBytes);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, pool.ebo);
+
+    std::sort(pool.dirty.begin(), pool.dirty.end());
+    pool.dirty.erase(std::unique(pool.dirty.begin(), pool.dirty.end()), pool.dirty.end());
+
+    // Todo slot tem o mesmo tamanho: o k-ésimo slot sujo ocupa a posição k da
+    // área de preparo, e a geometria é gerada em paralelo direto nela. Lotes de
+    // até STAGING_MAX_BYTES limitam a memória em reconstruções completas.
+    const size_t slotBytes = slotVertexBytes + slotIndexBytes;
+    const size_t batchSlots = std::max<size_t>(1, STAGING_MAX_BYTES / slotBytes);
+    std::vector<Vertex> vertices(std::min(batchSlots, pool.dirty.size()) * pool.vertsPerSlot);
+    std::vector<unsigned int> indices(std::min(batchSlots, pool.dirty.size()) * pool.indicesPerSlot);
+    // Formato compactado: cada tarefa quantiza os próprios slots logo após gerá-los
+    const bool packed = vertexLayout == VertexLayout::Packed;
+    std::vector<PackedVertex> packedVertices(packed ? vertices.size() : 0);
+    for (size_t batchStart = 0; batchStart < pool.dirty.size(); batchStart += batchSlots)
+    {
+        const size_t batchEnd = std::min(batchStart + batchSlots, pool.dirty.size());
+        ParallelUtils::parallelFor(batchEnd - batchStart, std::max<size_t>(1, MIN_VERTICES_PER_TASK / pool.vertsPerSlot),
+                                   [&](size_t begin, size_t end)
+                                   {
+                                       for (size_t k = begin; k < end; ++k)
+                                           generateSlot(pool, pool.dirty[batchStart + k],
+                                                        &vertices[k * pool.vertsPerSlot],
+                                                        &indices[k * pool.indicesPerSlot]);
+                                       if (packed)
+                                       {
+                                           for (size_t v = begin * pool.vertsPerSlot; v < end * pool.vertsPerSlot; ++v)
+                                               packedVertices[v] = packVertex(vertices[v]);
+                                       }
+                                   });
+
+        // Slots consecutivos são enviados juntos, em um único glBufferSubData
+        size_t runStart = batchStart;
+        while (runStart < batchEnd)
+        {
+            size_t runEnd = runStart + 1;
+            while (runEnd < batchEnd && pool.dirty[runEnd] == pool.dirty[runEnd - 1] + 1)
+                ++runEnd;
+            const uint32_t firstSlot = pool.dirty[runStart];
+            const size_t runSlots = runEnd - runStart;
+            const size_t staged = runStart - batchStart;
+            const void *runVertices = packed ? static_cast<const void *>(&packedVertices[staged * pool.vertsPerSlot])
+                                             : static_cast<const void *>(&vertices[staged * pool.vertsPerSlot]);
+            glBufferSubData(GL_ARRAY_BUFFER, firstSlot * slotVertexBytes, runSlots * slotVertexBytes, runVertices);
+            glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, firstSlot * slotIndexBytes, runSlots * slotIndexBytes,
+                            &indices[staged * pool.indicesPerSlot]);
+            runStart = runEnd;
+        }
     }
+    pool.dirty.clear();
+    glBindVertexArray(0);
 }
 
-void TreeRenderer::init(const ArterialTree &tree, float radiusMultiplier, bool showSpheres,
-                        bool clipEnabled, glm::vec3 clipMin, glm::vec3 clipMax)
+bool TreeRenderer::appendProgressive(const ArterialTree &partial, size_t first, size_t count, const PreviewTransform &transform)
 {
-    if (VAO)
-        glDeleteVertexArrays(1, &VAO);
-    if (VBO)
-        glDeleteBuffers(1, &VBO);
-    if (EBO)
-        glDeleteBuffers(1, &EBO);
+    // Limite de memória de vértices da pré-visualização; a malha completa vem no init()
+    const size_t PREVIEW_MAX_BYTES = size_t(256) << 20;
+    // Pré-visualização sempre na resolução completa, contada em todos os blocos
+    const size_t slotVertexBytes = 2 * (LOD_RESOLUTIONS[LOD_LEVELS - 1] + 1) * vertexSize();
+    size_t previewSlots = 0;
+    for (const auto &entry : chunks)
+        previewSlots += entry.second.cylinderPools[LOD_LEVELS - 1].slotCount;
 
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
-    glGenBuffers(1, &EBO);
+    // Cor pelo raio bruto do segmento nos dois extremos, na faixa vista até agora
+    std::vector<glm::vec2> scalars(count);
+    for (size_t i = first; i < first + count; ++i)
+        scalars[i - first] = glm::vec2(partial.segments[i].radius);
+    scalarMin = transform.minRadius;
+    scalarMax = transform.maxRadius;
+    nodeScalarOffset = static_cast<int>(first + count);
+    uploadScalars(scalars, first);
+    // Os segmentos vão brutos aos buffers, como os da malha definitiva: a
+    // normalização provisória (que muda a cada lote) é só a dos shaders
+    normCenter = transform.center;
+    normScale = transform.scale;
+    normRadiusFix = transform.radiusFix;
+    lodChecked = false;
 
-    buildMeshes(tree, radiusMultiplier, showSpheres, clipEnabled, clipMin, clipMax);
+    std::vector<VesselInstance> instances;
+    if (renderPath == RenderPath::Mesh && count > 0)
+    {
+        glm::vec3 boundsMin(std::numeric_limits<float>::max());
+        glm::vec3 boundsMax(-std::numeric_limits<float>::max());
+        float boundsRadius = 0.0f;
+        for (size_t i = first; i < first + count; ++i)
+        {
+            const auto &seg = partial.segments[i];
+            for (int node : {seg.indexA, seg.indexB})
+            {
+                boundsMin = glm::min(boundsMin, partial.nodes[node].position);
+                boundsMax = glm::max(boundsMax, partial.nodes[node].position);
+            }
+            boundsRadius = std::max(boundsRadius, seg.radius);
+        }
+        growQuantization(boundsMin, boundsMax, boundsRadius);
+    }
+    for (size_t i = first; i < first + count; ++i)
+    {
+        const auto &seg = partial.segments[i];
+        const glm::vec3 &tempA = partial.nodes[seg.indexA].position;
+        const glm::vec3 &tempB = partial.nodes[seg.indexB].position;
+        // Sem o raio máximo por nó (depende de todos os segmentos): raio do próprio segmento
+        float radius = seg.radius;
+        if (renderPath != RenderPath::Mesh)
+        {
+            instances.push_back(VesselInstance{glm::vec4(tempA, radius), glm::vec4(tempB, radius),
+                                               static_cast<int>(i)});
+            continue;
+        }
+        if ((previewSlots + 1) * slotVertexBytes > PREVIEW_MAX_BYTES)
+        {
+            uploadDirtyChunks();
+            return false;
+        }
+        const TubeRing ring = TubeUtils::plainRing(glm::normalize(tempB - tempA));
+        float signature[CYLINDER_SIGNATURE];
+        fillCylinderSignature(signature, tempA, tempB, radius, radius, static_cast<int>(i), ring, ring);
+        MeshChunk &chunk = chunkAt((tempA + tempB) * 0.5f);
+        MeshPool &cylinderPool = chunk.cylinderPools[LOD_LEVELS - 1];
+        const size_t slotsBefore = cylinderPool.slotCount;
+        useSlot(cylinderPool, pairKey(seg.indexA, seg.indexB), signature);
+        previewSlots += cylinderPool.slotCount - slotsBefore;
+        chunk.expand(tempA, radius);
+        chunk.expand(tempB, radius);
+    }
+    if (renderPath != RenderPath::Mesh)
+        uploadInstances(cylinderInstances, instances, cylinderInstances.instanceCount);
+    else
+        uploadDirtyChunks();
+    return true;
 }
 
-void TreeRenderer::generateSphere(const glm::vec3 &center, float radius, const glm::vec3 &color, int segmentID, std::vector<Vertex> &vertices, std::vector<unsigned int> &indices)
+// Garante `neededBytes` de capacidade: cria um buffer ao menos duas vezes
+// maior, copia os `usedBytes` atuais na GPU e libera o antigo
+GLuint TreeRenderer::growBuffer(GLuint buffer, size_t usedBytes, size_t &capacity, size_t neededBytes)
 {
-    // Alta resolução (32) para minimizar quinas visíveis
-    const int X_SEGMENTS = 32;
-    const int Y_SEGMENTS = 32;
+    if (neededBytes <= capacity)
+        return buffer;
+    size_t newCapacity = std::max(neededBytes, capacity * 2);
+    GLuint grown = 0;
+    glGenBuffers(1, &grown);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, grown);
+    glBufferData(GL_COPY_WRITE_BUFFER, newCapacity, nullptr, GL_STATIC_DRAW);
+    if (usedBytes > 0)
+    {
+        glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, usedBytes);
+    }
+    glDeleteBuffers(1, &buffer);
+    capacity = newCapacity;
+    return grown;
+}
 
-    unsigned int baseIdx = static_cast<unsigned int>(vertices.size());
+void TreeRenderer::generateSphere(const glm::vec3 &center, float radius, int segmentID, int segments, Vertex *vertices, unsigned int *indices, unsigned int baseIdx)
+{
+    // Até 32 segmentos (nível completo) para minimizar quinas visíveis
+    const int X_SEGMENTS = segments;
+    const int Y_SEGMENTS = segments;
 
     for (int y = 0; y <= Y_SEGMENTS; ++y)
     {
@@ -177,15 +1086,13 @@ void TreeRenderer::generateSphere(const glm::vec3 &center, float radius, const g
 
             // Parametrização esférica: mapeia (xSegment,ySegment) em ângulos
             // longitudinais e polares para produzir uma normal unitária na
-            // esfera. Multiplicando pela `radius` obtemos a posição na superfície.
+            // esfera. O vertex shader a multiplica pelo raio escalado e soma ao centro.
             float xPos = std::cos(xSegment * 2.0f * (float)M_PI) * std::sin(ySegment * (float)M_PI);
             float yPos = std::cos(ySegment * (float)M_PI);
             float zPos = std::sin(xSegment * 2.0f * (float)M_PI) * std::sin(ySegment * (float)M_PI);
 
             glm::vec3 normal = glm::vec3(xPos, yPos, zPos);
-            glm::vec3 pos = center + (normal * radius);
-
-            vertices.push_back(Vertex{pos, normal, color, segmentID});
+            *vertices++ = Vertex{center, normal, segmentID, radius};
         }
     }
 
@@ -198,36 +1105,23 @@ void TreeRenderer::generateSphere(const glm::vec3 &center, float radius, const g
             unsigned int k3 = baseIdx + (y + 1) * (X_SEGMENTS + 1) + x;
             unsigned int k4 = baseIdx + (y + 1) * (X_SEGMENTS + 1) + x + 1;
 
-            indices.push_back(k1);
-            indices.push_back(k3);
-            indices.push_back(k2);
+            *indices++ = k1;
+            *indices++ = k3;
+            *indices++ = k2;
 
-            indices.push_back(k2);
-            indices.push_back(k3);
-            indices.push_back(k4);
+            *indices++ = k2;
+            *indices++ = k3;
+            *indices++ = k4;
         }
     }
 }
 
-void TreeRenderer::generateCylinder(const glm::vec3 &a, const glm::vec3 &b, float radiusA, float radiusB, const glm::vec3 &colorA, const glm::vec3 &colorB, int segmentID, std::vector<Vertex> &vertices, std::vector<unsigned int> &indices)
+void TreeRenderer::generateCylinder(const glm::vec3 &a, const glm::vec3 &b, float radiusA, float radiusB, int segmentID,
+                                    const TubeRing &ringA, const TubeRing &ringB, int sides, Vertex *vertices,
+                                    unsigned int *indices, unsigned int baseIdx)
 {
-    // Alta resolução (32) para casar perfeitamente com a esfera
-    const int segments = 32;
-
-    glm::vec3 axis = glm::normalize(b - a);
-    // Constroi uma base ortonormal ao longo do eixo do cilindro.
-    // `axis` é o vetor diretor do cilindro; escolhemos um vetor `up`
-    // provisório e usamos produto vetorial para obter vetores
-    // perpendiculares (`side` e `ortho`) que definem o plano da
-    // seção transversal do cilindro.
-    glm::vec3 up = glm::vec3(0.0f, 1.0f, 0.0f);
-    if (glm::abs(glm::dot(axis, up)) > 0.99f)
-        up = glm::vec3(1.0f, 0.0f, 0.0f);
-
-    glm::vec3 side = glm::normalize(glm::cross(axis, up));
-    glm::vec3 ortho = glm::normalize(glm::cross(axis, side));
-
-    unsigned int baseIdx = static_cast<unsigned int>(vertices.size());
+    // No nível completo (32 lados) casa perfeitamente com a esfera
+    const int segments = sides;
 
     for (int i = 0; i <= segments; ++i)
     {
@@ -235,121 +1129,425 @@ void TreeRenderer::generateCylinder(const glm::vec3 &a, const glm::vec3 &b, floa
         float x = cosf(theta);
         float y = sinf(theta);
 
-        glm::vec3 dirVec = side * x + ortho * y;
-        // `dirVec` descreve um vetor radial no plano ortogonal ao eixo.
-        // Normalizamos para obter a normal da superfície do cilindro
-        // naquele ponto, usada para iluminação (shading).
-        glm::vec3 normal = glm::normalize(dirVec);
+        // Deslocamento radial de cada extremo no plano do seu anel: unitário
+        // no anel reto (base side/ortho perpendicular ao eixo) e alongado na
+        // direção da dobra no anel de junta. A normal de iluminação é a sua
+        // direção e o comprimento entra no raio do vértice.
+        glm::vec3 offsetA = TubeUtils::ringOffset(ringA, x, y);
+        glm::vec3 offsetB = TubeUtils::ringOffset(ringB, x, y);
+        float stretchA = glm::length(offsetA);
+        float stretchB = glm::length(offsetB);
 
-        // Base (Ponto A)
-        glm::vec3 p1 = a + (dirVec * radiusA);
-        vertices.push_back(Vertex{p1, normal, colorA, segmentID});
-        glm::vec3 p2 = b + (dirVec * radiusB);
-        vertices.push_back(Vertex{p2, normal, colorB, segmentID});
+        // Anéis em A e B: o deslocamento radial é aplicado no vertex shader.
+        // Índice par = extremo A, ímpar = B (o shader escolhe o escalar assim).
+        *vertices++ = Vertex{a, offsetA / stretchA, segmentID, radiusA * stretchA};
+        *vertices++ = Vertex{b, offsetB / stretchB, segmentID, radiusB * stretchB};
     }
 
     for (int i = 0; i < segments; ++i)
     {
         unsigned int current = baseIdx + i * 2;
         unsigned int next = baseIdx + (i + 1) * 2;
-        indices.push_back(current);
-        indices.push_back(current + 1);
-        indices.push_back(next);
-        indices.push_back(current + 1);
-        indices.push_back(next + 1);
-        indices.push_back(next);
+        *indices++ = current;
+        *indices++ = current + 1;
+        *indices++ = next;
+        *indices++ = current + 1;
+        *indices++ = next + 1;
+        *indices++ = next;
     }
 }
 
-void TreeRenderer::buildMeshes(const ArterialTree &tree, float radiusMultiplier, bool showSpheres,
-                               bool clipEnabled, glm::vec3 clipMin, glm::vec3 clipMax)
+template <typename CylinderFn, typename SphereFn>
+void TreeRenderer::forEachVesselPart(const ArterialTree &tree, bool showSpheres,
+                                     const CylinderFn &onCylinder, const SphereFn &onSphere)
 {
-    std::vector<Vertex> vertices;
-    std::vector<unsigned int> indices;
-
     std::vector<float> nodeMaxRadii(tree.nodes.size(), 0.0f);
     std::vector<int> nodeCounts(tree.nodes.size(), 0);
 
     float minRadius = std::numeric_limits<float>::max();
     float maxRadius = std::numeric_limits<float>::lowest();
 
-    // 1. Estatística: Raio Máximo por Nó
-    for (const auto &seg : tree.segments)
+    // 1. Estatística: Raio Máximo por Nó (raios brutos; a normalização fica nos shaders)
+    for (size_t i = 0; i < tree.segments.size(); ++i)
     {
-        if (seg.radius < minRadius)
-            minRadius = seg.radius;
-        if (seg.radius > maxRadius)
-            maxRadius = seg.radius;
+        const auto &seg = tree.segments[i];
+        const float radius = tree.rawRadius(i);
+        if (radius < minRadius)
+            minRadius = radius;
+        if (radius > maxRadius)
+            maxRadius = radius;
 
-        nodeMaxRadii[seg.indexA] = std::max(nodeMaxRadii[seg.indexA], seg.radius);
+        nodeMaxRadii[seg.indexA] = std::max(nodeMaxRadii[seg.indexA], radius);
         nodeCounts[seg.indexA]++;
-        nodeMaxRadii[seg.indexB] = std::max(nodeMaxRadii[seg.indexB], seg.radius);
+        nodeMaxRadii[seg.indexB] = std::max(nodeMaxRadii[seg.indexB], radius);
         nodeCounts[seg.indexB]++;
     }
 
+    // Escalares do mapa de cores: raio máximo nos extremos de cada segmento
+    // e em cada nó (as esferas usam o segmentID -2 - nó)
+    std::vector<glm::vec2> scalars(tree.segments.size() + tree.nodes.size());
+    for (size_t i = 0; i < tree.segments.size(); ++i)
+        scalars[i] = glm::vec2(nodeMaxRadii[tree.segments[i].indexA], nodeMaxRadii[tree.segments[i].indexB]);
+    for (size_t i = 0; i < tree.nodes.size(); ++i)
+        scalars[tree.segments.size() + i] = glm::vec2(nodeMaxRadii[i]);
+    scalarMin = tree.segments.empty() ? 0.0f : minRadius;
+    scalarMax = tree.segments.empty() ? 1.0f : maxRadius;
+    nodeScalarOffset = static_cast<int>(tree.segments.size());
+    uploadScalars(scalars, 0);
+
     // 2. Geometria: CILINDROS (Ramos)
     for (size_t i = 0; i < tree.segments.size(); ++i)
     {
         const auto &seg = tree.segments[i];
-        glm::vec3 tempA = tree.nodes[seg.indexA].position;
-        glm::vec3 tempB = tree.nodes[seg.indexB].position;
-        bool keep = true;
-        if (clipEnabled)
-        {
-            keep = ClippingUtils::clipSegment(tempA, tempB, clipMin, clipMax);
-        }
-        if (!keep)
-            continue;
-        float radiusA = glm::max(nodeMaxRadii[seg.indexA] * radiusMultiplier, 0.002f);
-        float radiusB = glm::max(nodeMaxRadii[seg.indexB] * radiusMultiplier, 0.002f);
-        glm::vec3 colorA = getHeatMapColor(nodeMaxRadii[seg.indexA], minRadius, maxRadius);
-        glm::vec3 colorB = getHeatMapColor(nodeMaxRadii[seg.indexB], minRadius, maxRadius);
-        generateCylinder(tempA, tempB, radiusA, radiusB, colorA, colorB, static_cast<int>(i), vertices, indices);
+        float radiusA = nodeMaxRadii[seg.indexA];
+        float radiusB = nodeMaxRadii[seg.indexB];
+        onCylinder(i, tree.rawPosition(seg.indexA), tree.rawPosition(seg.indexB), radiusA, radiusB);
     }
 
     // 3. Geometria: ESFERAS (Juntas)
-    // Loop separado para evitar overdraw
+    // Desenhadas à parte para evitar overdraw
     if (showSpheres)
     {
         for (size_t i = 0; i < tree.nodes.size(); ++i)
         {
             if (nodeCounts[i] > 1)
             {
-                glm::vec3 center = tree.nodes[i].position;
-                if (clipEnabled)
-                {
-                    if (center.x < clipMin.x || center.x > clipMax.x ||
-                        center.y < clipMin.y || center.y > clipMax.y ||
-                        center.z < clipMin.z || center.z > clipMax.z)
-                    {
-                        continue;
-                    }
-                }
-                float radius = glm::max(nodeMaxRadii[i] * radiusMultiplier, 0.002f);
-                glm::vec3 color = getHeatMapColor(nodeMaxRadii[i], minRadius, maxRadius);
-                generateSphere(center, radius, color, -1, vertices, indices);
+                onSphere(i, tree.rawPosition(i), nodeMaxRadii[i]);
             }
         }
     }
+}
 
-    glBindVertexArray(VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), vertices.data(), GL_STATIC_DRAW);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+void TreeRenderer::buildMeshes(const ArterialTree &tree, bool showSpheres)
+{
+    // O segmentID compactado tem 24 bits com sinal (esferas usam -2 - nó)
+    const size_t PACKED_ID_LIMIT = size_t(1) << 23;
+    if (vertexLayout == VertexLayout::Packed &&
+        (tree.segments.size() > PACKED_ID_LIMIT || tree.nodes.size() + 2 > PACKED_ID_LIMIT))
+    {
+        std::cerr << "[TreeRenderer] IDs excedem 24 bits; usando o formato de vértices completo." << std::endl;
+        setVertexLayout(VertexLayout::Full);
+    }
 
-    GLsizei stride = sizeof(Vertex);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void *)offsetof(Vertex, pos));
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (void *)offsetof(Vertex, normal));
-    glEnableVertexAttribArray(2);
-    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, stride, (void *)offsetof(Vertex, color));
-    glEnableVertexAttribArray(3);
-    glVertexAttribIPointer(3, 1, GL_INT, stride, (void *)offsetof(Vertex, segmentID));
+    // Árvore em escala muito diferente da grade (outro arquivo, ou a caixa
+    // cresceu mais de 2x na animação): a grade é refeita do zero
+    const float cellRatio = chunkCellSize * normScale / CHUNK_SIZE;
+    if (!chunks.empty() && (cellRatio > 2.0f || cellRatio < 0.5f))
+        deleteChunks();
 
-    glBindVertexArray(0);
-    indexCount = indices.size();
+    // Pools muito fragmentados (árvore encolheu) são reconstruídos do zero; a
+    // caixa de cada bloco é refeita com as primitivas desta atualização
+    ++meshGeneration;
+    for (auto &entry : chunks)
+    {
+        for (int level = 0; level < LOD_LEVELS; ++level)
+        {
+            for (MeshPool *pool : {&entry.second.cylinderPools[level], &entry.second.spherePools[level]})
+            {
+                if (pool->slotCount > 1024 && pool->liveCount * 2 < pool->slotCount)
+                    resetPool(*pool);
+            }
+        }
+        entry.second.hasBounds = false;
+    }
+
+    // 1. Assinaturas e esferas envolventes dos cilindros/esferas visíveis. O
+    // nível anterior de cada item é mantido para a histerese.
+    std::vector<LodItem> cylinderItems(tree.segments.size());
+    std::vector<LodItem> sphereItems(tree.nodes.size());
+    for (size_t i = 0; i < cylinderItems.size(); ++i)
+        cylinderItems[i].level = (i < cylinderLod.size()) ? cylinderLod[i].level : LOD_UNSET;
+    for (size_t i = 0; i < sphereItems.size(); ++i)
+        sphereItems[i].level = (i < sphereLod.size()) ? sphereLod[i].level : LOD_UNSET;
+    std::vector<float> cylinderSignatures;
+    std::vector<float> sphereSignatures;
+    std::vector<uint32_t> cylinderOrder;
+    std::vector<uint32_t> sphereOrder;
+    cylinderSignatures.reserve(tree.segments.size() * CYLINDER_SIGNATURE);
+    cylinderOrder.reserve(tree.segments.size());
+    // Tubos contínuos: anéis dos extremos de cada segmento e nós cuja junção
+    // já é fechada pelo anel compartilhado (sem esfera)
+    std::vector<TubeRing> ringsA;
+    std::vector<TubeRing> ringsB;
+    std::vector<uint8_t> joinedNodes;
+    if (sweptTubes)
+        TubeUtils::sweep(tree, ringsA, ringsB, joinedNodes);
+    // Caixa dos eixos (posições dos vértices antes do raio) para a quantização
+    glm::vec3 boundsMin(std::numeric_limits<float>::max());
+    glm::vec3 boundsMax(-std::numeric_limits<float>::max());
+    float boundsRadius = 0.0f;
+    forEachVesselPart(
+        tree, showSpheres,
+        [&](size_t i, const glm::vec3 &a, const glm::vec3 &b, float radiusA, float radiusB)
+        {
+            TubeRing ringA;
+            TubeRing ringB;
+            if (sweptTubes)
+            {
+                ringA = ringsA[i];
+                ringB = ringsB[i];
+            }
+            else
+            {
+                ringA = ringB = TubeUtils::plainRing(glm::normalize(b - a));
+            }
+            float signature[CYLINDER_SIGNATURE];
+            fillCylinderSignature(signature, a, b, radiusA, radiusB, static_cast<int>(i), ringA, ringB);
+            cylinderSignatures.insert(cylinderSignatures.end(), signature, signature + CYLINDER_SIGNATURE);
+            cylinderOrder.push_back(static_cast<uint32_t>(i));
+            LodItem &item = cylinderItems[i];
+            item.center = (a + b) * 0.5f;
+            item.radius = std::max(radiusA, radiusB);
+            item.halfLength = glm::length(b - a) * 0.5f;
+            boundsMin = glm::min(boundsMin, glm::min(a, b));
+            boundsMax = glm::max(boundsMax, glm::max(a, b));
+            // O anel de junta alonga o raio do vértice em até 1 / cos φ
+            boundsRadius = std::max({boundsRadius, radiusA * (1.0f + glm::length(ringA.miter)),
+                                     radiusB * (1.0f + glm::length(ringB.miter))});
+        },
+        [&](size_t i, const glm::vec3 &center, float radius)
+        {
+            if (sweptTubes && joinedNodes[i])
+                return;
+            const float signature[SPHERE_SIGNATURE] = {center.x, center.y, center.z, radius,
+                                                       intBits(sphereID(i))};
+            sphereSignatures.insert(sphereSignatures.end(), signature, signature + SPHERE_SIGNATURE);
+            sphereOrder.push_back(static_cast<uint32_t>(i));
+            LodItem &item = sphereItems[i];
+            item.center = center;
+            item.radius = radius;
+            item.halfLength = 0.0f;
+            boundsMin = glm::min(boundsMin, center);
+            boundsMax = glm::max(boundsMax, center);
+            boundsRadius = std::max(boundsRadius, radius);
+        });
+    if (boundsMin.x <= boundsMax.x)
+        growQuantization(boundsMin, boundsMax, boundsRadius);
+    cylinderLod.swap(cylinderItems);
+    sphereLod.swap(sphereItems);
+
+    // 2. Nível de cada item e um slot por par de nós (cilindro) e por nó
+    // (esfera) no pool do nível, no bloco da célula do centro do item. Trocar
+    // de nível ou de bloco libera o slot do pool antigo.
+    std::vector<uint8_t> cylinderLevels;
+    std::vector<uint8_t> sphereLevels;
+    selectAllLodLevels(cylinderLevels, sphereLevels);
+    for (size_t k = 0; k < cylinderOrder.size(); ++k)
+    {
+        const uint32_t i = cylinderOrder[k];
+        const ArterialSegment &seg = tree.segments[i];
+        cylinderLod[i].level = cylinderLevels[i];
+        const float *signature = &cylinderSignatures[k * CYLINDER_SIGNATURE];
+        MeshChunk &chunk = chunkAt(cylinderLod[i].center);
+        useSlot(chunk.cylinderPools[cylinderLevels[i]], pairKey(seg.indexA, seg.indexB), signature);
+        // Raio do vértice com o alongamento dos anéis de junta
+        const glm::vec3 a(signature[0], signature[1], signature[2]);
+        const glm::vec3 b(signature[3], signature[4], signature[5]);
+        chunk.expand(a, signature[6] * (1.0f + glm::length(readRing(signature + 9).miter)));
+        chunk.expand(b, signature[7] * (1.0f + glm::length(readRing(signature + 9 + RING_FLOATS).miter)));
+    }
+    for (size_t k = 0; k < sphereOrder.size(); ++k)
+    {
+        const uint32_t i = sphereOrder[k];
+        sphereLod[i].level = sphereLevels[i];
+        MeshChunk &chunk = chunkAt(sphereLod[i].center);
+        useSlot(chunk.spherePools[sphereLevels[i]], static_cast<uint64_t>(i), &sphereSignatures[k * SPHERE_SIGNATURE]);
+        chunk.expand(sphereLod[i].center, sphereLod[i].radius);
+    }
+
+    // 3. Slots de segmentos/nós que sumiram; envio apenas dos blocos que
+    // mudaram. Blocos sem nenhuma primitiva viva são apagados.
+    for (auto it = chunks.begin(); it != chunks.end();)
+    {
+        MeshChunk &chunk = it->second;
+        size_t live = 0;
+        for (int level = 0; level < LOD_LEVELS; ++level)
+        {
+            releaseStaleSlots(chunk.cylinderPools[level]);
+            releaseStaleSlots(chunk.spherePools[level]);
+            live += chunk.cylinderPools[level].liveCount + chunk.spherePools[level].liveCount;
+        }
+        if (live > 0)
+        {
+            ++it;
+            continue;
+        }
+        for (int level = 0; level < LOD_LEVELS; ++level)
+        {
+            deletePool(chunk.cylinderPools[level]);
+            deletePool(chunk.spherePools[level]);
+        }
+        it = chunks.erase(it);
+    }
+    uploadDirtyChunks();
+}
+
+void TreeRenderer::uploadDirtyChunks()
+{
+    for (auto &entry : chunks)
+    {
+        for (int level = 0; level < LOD_LEVELS; ++level)
+        {
+            uploadDirtySlots(entry.second.cylinderPools[level]);
+            uploadDirtySlots(entry.second.spherePools[level]);
+        }
+    }
+}
+
+void TreeRenderer::setLodOptions(bool enabled, size_t triangleBudget)
+{
+    if (enabled == lodEnabled && triangleBudget == lodTriangleBudget)
+        return;
+    lodEnabled = enabled;
+    lodTriangleBudget = triangleBudget;
+    lodChecked = false;
+}
+
+void TreeRenderer::setRadiusScale(float scale)
+{
+    if (scale == radiusScale)
+        return;
+    radiusScale = scale;
+    lodChecked = false;
+}
+
+bool TreeRenderer::updateLod(const glm::mat4 &view, const glm::mat4 &proj, const glm::mat4 &model, int viewportHeight)
+{
+    const glm::mat4 modelView = view * model;
+    // Projeção ortográfica: w = 1 (sem divisão pela profundidade)
+    const bool orthographic = proj[3][3] == 1.0f;
+    const float pixelScale = proj[1][1] * 0.5f * static_cast<float>(std::max(viewportHeight, 1));
+    const bool cameraMoved = !lodHasCamera || modelView != lodModelView ||
+                             orthographic != lodOrthographic || pixelScale != lodPixelScale;
+    lodModelView = modelView;
+    lodOrthographic = orthographic;
+    lodPixelScale = pixelScale;
+    lodHasCamera = true;
+    if (renderPath != RenderPath::Mesh)
+        return false;
+    // Nada mudou desde a última verificação sem troca de nível (desligado, a
+    // câmera não importa: tudo já está no nível mais alto)
+    if (lodChecked && (!cameraMoved || !lodEnabled))
+        return false;
+
+    std::vector<uint8_t> cylinderLevels;
+    std::vector<uint8_t> sphereLevels;
+    selectAllLodLevels(cylinderLevels, sphereLevels);
+    for (size_t i = 0; i < cylinderLod.size(); ++i)
+    {
+        if (cylinderLod[i].radius >= 0.0f && cylinderLevels[i] != cylinderLod[i].level)
+            return true;
+    }
+    for (size_t i = 0; i < sphereLod.size(); ++i)
+    {
+        if (sphereLod[i].radius >= 0.0f && sphereLevels[i] != sphereLod[i].level)
+            return true;
+    }
+    lodChecked = true;
+    return false;
+}
+
+size_t TreeRenderer::selectLodLevels(const std::vector<LodItem> &items, bool sphere, float bias, std::vector<uint8_t> &levels) const
+{
+    const int top = LOD_LEVELS - 1;
+    const bool active = lodEnabled && lodHasCamera;
+    levels.resize(items.size());
+    size_t triangles = 0;
+    for (size_t i = 0; i < items.size(); ++i)
+    {
+        const LodItem &item = items[i];
+        if (item.radius < 0.0f)
+        {
+            levels[i] = item.level;
+            continue;
+        }
+        int level = top;
+        if (active)
+        {
+            // Raio projetado em pixels (raio desenhado, como no vertex shader,
+            // levado à árvore normalizada); na perspectiva, pelo ponto mais
+            // próximo da esfera envolvente
+            const float radius = drawnRadius(item.radius) * normScale;
+            float pixels = radius * lodPixelScale * bias;
+            if (!lodOrthographic)
+            {
+                const glm::vec3 c = (item.center - normCenter) * normScale;
+                float depth = -(lodModelView[0][2] * c.x + lodModelView[1][2] * c.y + lodModelView[2][2] * c.z + lodModelView[3][2]);
+                pixels /= std::max(depth - item.halfLength * normScale - radius, 1e-3f);
+            }
+            if (item.level == LOD_UNSET)
+            {
+                level = 0;
+                while (level < top && pixels >= LOD_MIN_PIXELS[level + 1])
+                    ++level;
+            }
+            else
+            {
+                level = item.level;
+                while (level < top && pixels >= LOD_MIN_PIXELS[level + 1] * LOD_HYSTERESIS)
+                    ++level;
+                while (level > 0 && pixels < LOD_MIN_PIXELS[level] / LOD_HYSTERESIS)
+                    --level;
+            }
+        }
+        levels[i] = static_cast<uint8_t>(level);
+        const size_t n = static_cast<size_t>(LOD_RESOLUTIONS[level]);
+        triangles += sphere ? 2 * n * n : 2 * n;
+    }
+    return triangles;
+}
+
+void TreeRenderer::selectAllLodLevels(std::vector<uint8_t> &cylinderLevels, std::vector<uint8_t> &sphereLevels) const
+{
+    // Orçamento: reduz o raio projetado pela metade até caber (ou tudo no nível 0)
+    float bias = 1.0f;
+    for (int attempt = 0; attempt < 16; ++attempt)
+    {
+        size_t triangles = selectLodLevels(cylinderLod, false, bias, cylinderLevels) +
+                           selectLodLevels(sphereLod, true, bias, sphereLevels);
+        if (lodTriangleBudget == 0 || triangles <= lodTriangleBudget || !lodEnabled || !lodHasCamera)
+            break;
+        bias *= 0.5f;
+    }
+}
+
+void TreeRenderer::buildInstances(const ArterialTree &tree, bool showSpheres)
+{
+    std::vector<VesselInstance> cylinders;
+    std::vector<VesselInstance> spheres;
+    cylinders.reserve(tree.segments.size());
+    forEachVesselPart(
+        tree, showSpheres,
+        [&](size_t i, const glm::vec3 &a, const glm::vec3 &b, float radiusA, float radiusB)
+        {
+            cylinders.push_back(VesselInstance{glm::vec4(a, radiusA), glm::vec4(b, radiusB),
+                                               static_cast<int>(i)});
+        },
+        [&](size_t i, const glm::vec3 &center, float radius)
+        {
+            spheres.push_back(VesselInstance{glm::vec4(center, radius), glm::vec4(center, radius),
+                                             sphereID(i)});
+        });
+    // Só os buffers de instâncias são regravados; as malhas unitárias ficam
+    uploadInstances(cylinderInstances, cylinders, 0);
+    uploadInstances(sphereInstances, spheres, 0);
+}
+
+void TreeRenderer::drawPool(const MeshPool &pool)
+{
+    if (!pool.vao || pool.slotCount == 0)
+        return;
+    glBindVertexArray(pool.vao);
+    glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(pool.slotCount * pool.indicesPerSlot), GL_UNSIGNED_INT, 0);
+}
+
+void TreeRenderer::drawInstances(const InstanceBuffers &buffers)
+{
+    if (!buffers.vao || buffers.instanceCount == 0)
+        return;
+    glBindVertexArray(buffers.vao);
+    glDrawElementsInstanced(GL_TRIANGLES, static_cast<GLsizei>(buffers.indexCount), GL_UNSIGNED_INT, 0,
+                            static_cast<GLsizei>(buffers.instanceCount));
 }
 
 void TreeRenderer::draw(Shader &shader, const glm::mat4 &view, const glm::mat4 &proj, const glm::mat4 &model, int selectedSegmentID)
@@ -357,12 +1555,93 @@ void TreeRenderer::draw(Shader &shader, const glm::mat4 &view, const glm::mat4 &
     shader.use();
     shader.setMat4("view", view);
     shader.setMat4("projection", proj);
-    shader.setMat4("model", model);
     shader.setInt("selectedSegmentID", selectedSegmentID);
-    glBindVertexArray(VAO);
+    // Buffers em valores brutos: a normalização e a escala de raio são uniforms
+    applyNormalization(shader, model);
+    const glm::mat4 treeModel = model * normalization();
+    // Os impostores recortam o ponto atingido no fragment shader: recortar a
+    // caixa envolvente cortaria também pixels da superfície dentro do corte
+    applyClipBox(shader, renderPath != RenderPath::Impostor);
+    applyColormap(shader);
     glEnable(GL_POLYGON_OFFSET_FILL);
     glPolygonOffset(1.0f, 1.0f);
-    glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(indexCount), GL_UNSIGNED_INT, 0);
+    if (renderPath == RenderPath::Impostor)
+    {
+        // O raio de cada pixel é reconstruído desprojetando o fragmento.
+        // Só as faces de trás das caixas são rasterizadas: cada pixel é
+        // traçado uma vez e a câmera pode estar dentro de uma caixa.
+        shader.setMat4("inverseMVP", glm::inverse(proj * view * treeModel));
+        glEnable(GL_CULL_FACE);
+        glCullFace(GL_FRONT);
+        shader.setInt("instanceShape", 0);
+        drawInstances(cylinderInstances);
+        shader.setInt("instanceShape", 1);
+        drawInstances(sphereInstances);
+        glCullFace(GL_BACK);
+        glDisable(GL_CULL_FACE);
+    }
+    else if (renderPath == RenderPath::Instanced)
+    {
+        shader.setInt("instanceShape", 0);
+        drawInstances(cylinderInstances);
+        shader.setInt("instanceShape", 1);
+        drawInstances(sphereInstances);
+    }
+    else
+    {
+        // Decodificação do PackedVertex (faixa fixa até a próxima requantização)
+        const bool packed = vertexLayout == VertexLayout::Packed && quantValid;
+        shader.setBool("packedVertices", packed);
+        if (packed)
+        {
+            shader.setVec3("quantMin", quantMin);
+            shader.setVec3("quantExtent", quantMax - quantMin);
+            shader.setFloat("quantRadiusMax", quantRadiusMax);
+        }
+        // Blocos fora do frustum ou da caixa de corte não são desenhados. A
+        // caixa de cada bloco cresce pelo maior raio desenhado (com a escala);
+        // planos e caixa de corte nas coordenadas brutas dos blocos.
+        glm::vec4 planes[6];
+        extractFrustumPlanes(proj * view * treeModel, planes);
+        const glm::vec3 rawClipMin = clipMin / normScale + normCenter;
+        const glm::vec3 rawClipMax = clipMax / normScale + normCenter;
+        std::vector<const MeshChunk *> visible;
+        visible.reserve(chunks.size());
+        for (const auto &entry : chunks)
+        {
+            const MeshChunk &chunk = entry.second;
+            if (!chunk.hasBounds)
+                continue;
+            const glm::vec3 margin(drawnRadius(chunk.maxRadius));
+            const glm::vec3 lo = chunk.boundsMin - margin;
+            const glm::vec3 hi = chunk.boundsMax + margin;
+            if (boxOutsideFrustum(lo, hi, planes))
+                continue;
+            bool clipped = false;
+            for (int c = 0; c < 3 && clipEnabled; ++c)
+                clipped = clipped || hi[c] < rawClipMin[c] || lo[c] > rawClipMax[c];
+            if (!clipped)
+                visible.push_back(&chunk);
+        }
+        chunksDrawn = visible.size();
+        // Com a ordem otimizada, os cilindros vêm antes: as esferas ficam
+        // quase inteiras dentro deles e são rejeitadas pelo teste de profundidade
+        for (const MeshChunk *chunk : visible)
+        {
+            for (int level = 0; level < LOD_LEVELS; ++level)
+            {
+                drawPool(chunk->cylinderPools[level]);
+                if (!optimizeIndexOrder)
+                    drawPool(chunk->spherePools[level]);
+            }
+        }
+        for (const MeshChunk *chunk : visible)
+        {
+            for (int level = 0; optimizeIndexOrder && level < LOD_LEVELS; ++level)
+                drawPool(chunk->spherePools[level]);
+        }
+    }
     glDisable(GL_POLYGON_OFFSET_FILL);
+    releaseClipBox();
     glBindVertexArray(0);
 }
\ No newline at end of file
@@ -0,0 +1,167 @@
+/*
+ * Universidade Federal de Ouro Preto - UFOP
+ * Departamento de Computação - DECOM
+ * Disciplina: BCC327 - Computação Gráfica (2025.2)
+ * Professor: Rafael Bonfim
+ * Trabalho Prático: Visualizador de Árvores Arteriais (CCO)
+ * Arquivo: TubeUtils.cpp
+ * Autor: Mateus Honorato
+ * Data: Outubro/2026
+ * Descrição:
+ * Implementa a varredura de tubos contínuos ao longo dos ramos da árvore:
+ * anéis de junta no plano bissetor (alongados para manter a espessura na
+ * dobra) e transporte da base do anel de segmento em segmento.
+ *
+ * Créditos:
+ * Junta em esquadria e transporte de referencial baseados em Bloomenthal,
+ * "Calculation of Reference Frames Along a Space Curve" (Graphics Gems, 1990).
+ */
+
+#include <algorithm>
+#include <cmath>
+
+#include "TubeUtils.hpp"
+
+namespace
+{
+    // Projeta a referência no plano do novo anel; se ela ficar paralela à
+    // tangente, recomeça com a base padrão
+    glm::vec3 transportSide(const glm::vec3 &side, const glm::vec3 &tangent)
+    {
+        glm::vec3 projected = side - glm::dot(side, tangent) * tangent;
+        float length = glm::length(projected);
+        if (length < 1e-4f)
+            return TubeUtils::plainRing(tangent).side;
+        return projected / length;
+    }
+}
+
+TubeRing TubeUtils::plainRing(const glm::vec3 &axis)
+{
+    glm::vec3 up = glm::vec3(0.0f, 1.0f, 0.0f);
+    if (glm::abs(glm::dot(axis, up)) > 0.99f)
+        up = glm::vec3(1.0f, 0.0f, 0.0f);
+    return TubeRing{axis, glm::normalize(glm::cross(axis, up)), glm::vec3(0.0f)};
+}
+
+glm::vec3 TubeUtils::ringOffset(const TubeRing &ring, float cosTheta, float sinTheta)
+{
+    // Mesma base de generateCylinder: (side, tangent x side, tangent) é destra
+    glm::vec3 dir = ring.side * cosTheta + glm::cross(ring.tangent, ring.side) * sinTheta;
+    float stretch = glm::length(ring.miter);
+    if (stretch > 0.0f)
+    {
+        // Elipse do plano bissetor: semieixo 1 / cos φ na direção da dobra
+        dir += ring.miter * (glm::dot(dir, ring.miter) / stretch);
+    }
+    return dir;
+}
+
+void TubeUtils::sweep(const ArterialTree &tree, std::vector<TubeRing> &ringsA, std::vector<TubeRing> &ringsB,
+                      std::vector<uint8_t> &joinedNodes)
+{
+    const size_t segmentCount = tree.segments.size();
+    const size_t nodeCount = tree.nodes.size();
+
+    std::vector<glm::vec3> directions(segmentCount);
+    std::vector<int> incoming(nodeCount, 0);
+    std::vector<size_t> childStart(nodeCount + 1, 0);
+    for (size_t i = 0; i < segmentCount; ++i)
+    {
+        const ArterialSegment &seg = tree.segments[i];
+        glm::vec3 axis = tree.nodes[seg.indexB].position - tree.nodes[seg.indexA].position;
+        float length = glm::length(axis);
+        directions[i] = length > 1e-12f ? axis / length : glm::vec3(0.0f, 1.0f, 0.0f);
+        ++incoming[seg.indexB];
+        ++childStart[seg.indexA + 1];
+    }
+    // Filhos de cada nó em CSR: children[childStart[n] .. childStart[n + 1])
+    for (size_t n = 0; n < nodeCount; ++n)
+        childStart[n + 1] += childStart[n];
+    std::vector<uint32_t> children(segmentCount);
+    std::vector<size_t> fill(childStart.begin(), childStart.end() - 1);
+    for (size_t i = 0; i < segmentCount; ++i)
+        children[fill[tree.segments[i].indexA]++] = static_cast<uint32_t>(i);
+
+    ringsA.resize(segmentCount);
+    ringsB.resize(segmentCount);
+    for (size_t i = 0; i < segmentCount; ++i)
+        ringsA[i] = ringsB[i] = plainRing(directions[i]);
+    joinedNodes.assign(nodeCount, 0);
+
+    // Continuação aceita se a bissetriz alonga o anel até MAX_MITER_STRETCH:
+    // cos φ >= 1 / MAX_MITER_STRETCH, e dot(dA, dB) = cos 2φ
+    const float minCosPhi = 1.0f / MAX_MITER_STRETCH;
+    const float minDot = 2.0f * minCosPhi * minCosPhi - 1.0f;
+
+    // Busca em profundidade a partir dos segmentos que saem de raízes; os que
+    // sobrarem (ciclos, nós com várias entradas) começam um ramo novo
+    std::vector<uint8_t> visited(segmentCount, 0);
+    std::vector<uint32_t> stack;
+    auto visit = [&](uint32_t root)
+    {
+        visited[root] = 1;
+        stack.push_back(root);
+        while (!stack.empty())
+        {
+            const uint32_t s = stack.back();
+            stack.pop_back();
+            const int node = tree.segments[s].indexB;
+            const glm::vec3 &dir = directions[s];
+
+            int continuation = -1;
+            if (incoming[node] == 1)
+            {
+                for (size_t k = childStart[node]; k < childStart[node + 1]; ++k)
+                {
+                    const uint32_t c = children[k];
+                    if (glm::dot(dir, directions[c]) < minDot)
+                        continue;
+                    if (continuation < 0 || tree.segments[c].radius > tree.segments[continuation].radius)
+                        continuation = static_cast<int>(c);
+                }
+            }
+
+            if (continuation >= 0)
+            {
+                const glm::vec3 &next = directions[continuation];
+                TubeRing joint;
+                glm::vec3 bisector = dir + next;
+                joint.tangent = glm::normalize(bisector);
+                joint.side = transportSide(ringsA[s].side, joint.tangent);
+                glm::vec3 bend = next - dir; // perpendicular à bissetriz
+                float bendLength = glm::length(bend);
+                float cosPhi = glm::dot(dir, joint.tangent);
+                joint.miter = bendLength > 1e-6f ? bend / bendLength * (1.0f / cosPhi - 1.0f) : glm::vec3(0.0f);
+                ringsB[s] = joint;
+                ringsA[continuation] = joint;
+                joinedNodes[node] = 1;
+            }
+            else
+            {
+                ringsB[s] = TubeRing{dir, transportSide(ringsA[s].side, dir), glm::vec3(0.0f)};
+            }
+
+            for (size_t k = childStart[node]; k < childStart[node + 1]; ++k)
+            {
+                const uint32_t c = children[k];
+                if (visited[c])
+                    continue;
+                if (static_cast<int>(c) != continuation)
+                    ringsA[c] = TubeRing{directions[c], transportSide(ringsB[s].side, directions[c]), glm::vec3(0.0f)};
+                visited[c] = 1;
+                stack.push_back(c);
+            }
+        }
+    };
+    for (size_t i = 0; i < segmentCount; ++i)
+    {
+        if (!visited[i] && incoming[tree.segments[i].indexA] == 0)
+            visit(static_cast<uint32_t>(i));
+    }
+    for (size_t i = 0; i < segmentCount; ++i)
+    {
+        if (!visited[i])
+            visit(static_cast<uint32_t>(i));
+    }
+}
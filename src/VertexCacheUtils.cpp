@@ -0,0 +1,194 @@
+/*
+ * Universidade Federal de Ouro Preto - UFOP
+ * Departamento de Computação - DECOM
+ * Disciplina: BCC327 - Computação Gráfica (2025.2)
+ * Professor: Rafael Bonfim
+ * Trabalho Prático: Visualizador de Árvores Arteriais (CCO)
+ * Arquivo: VertexCacheUtils.cpp
+ * Autor: Mateus Honorato
+ * Data: Outubro/2026
+ * Descrição:
+ * Implementa a simulação do cache de vértices (ACMR), o Tipsify e a
+ * ordenação de agrupamentos contra overdraw.
+ *
+ * Créditos:
+ * Sander, Nehab e Barczak, "Fast Triangle Reordering for Vertex Locality
+ * and Reduced Overdraw" (SIGGRAPH 2007).
+ */
+
+#include <algorithm>
+#include <numeric>
+
+#include "VertexCacheUtils.hpp"
+
+float VertexCacheUtils::acmr(const std::vector<unsigned int> &indices, size_t vertexCount, int cacheSize)
+{
+    const size_t triangles = indices.size() / 3;
+    if (triangles == 0)
+        return 0.0f;
+    // Cache FIFO: o vértice está no cache se entrou há menos de cacheSize faltas
+    std::vector<size_t> entered(vertexCount, 0);
+    size_t misses = 0;
+    for (unsigned int v : indices)
+    {
+        if (entered[v] == 0 || misses - entered[v] + 1 > static_cast<size_t>(cacheSize))
+        {
+            ++misses;
+            entered[v] = misses;
+        }
+    }
+    return static_cast<float>(misses) / static_cast<float>(triangles);
+}
+
+std::vector<unsigned int> VertexCacheUtils::tipsify(const std::vector<unsigned int> &indices, size_t vertexCount,
+                                                    std::vector<size_t> &clusterStarts, int cacheSize)
+{
+    const size_t triangles = indices.size() / 3;
+    // Triângulos de cada vértice em CSR
+    std::vector<size_t> adjacencyStart(vertexCount + 1, 0);
+    for (unsigned int v : indices)
+        ++adjacencyStart[v + 1];
+    for (size_t v = 0; v < vertexCount; ++v)
+        adjacencyStart[v + 1] += adjacencyStart[v];
+    std::vector<size_t> adjacency(indices.size());
+    std::vector<size_t> fill(adjacencyStart.begin(), adjacencyStart.end() - 1);
+    for (size_t i = 0; i < indices.size(); ++i)
+        adjacency[fill[indices[i]]++] = i / 3;
+
+    std::vector<int> liveTriangles(vertexCount);
+    for (size_t v = 0; v < vertexCount; ++v)
+        liveTriangles[v] = static_cast<int>(adjacencyStart[v + 1] - adjacencyStart[v]);
+    std::vector<int> cacheTime(vertexCount, 0);
+    std::vector<char> emitted(triangles, 0);
+    std::vector<unsigned int> deadEnd;
+    std::vector<unsigned int> candidates;
+    std::vector<unsigned int> output;
+    output.reserve(indices.size());
+    clusterStarts.clear();
+
+    int time = cacheSize + 1;
+    size_t cursor = 0;
+    long fanning = vertexCount > 0 ? 0 : -1;
+    bool jumped = true;
+    while (fanning >= 0)
+    {
+        if (jumped)
+            clusterStarts.push_back(output.size() / 3);
+        candidates.clear();
+        for (size_t k = adjacencyStart[fanning]; k < adjacencyStart[fanning + 1]; ++k)
+        {
+            const size_t t = adjacency[k];
+            if (emitted[t])
+                continue;
+            for (int c = 0; c < 3; ++c)
+            {
+                const unsigned int v = indices[t * 3 + c];
+                output.push_back(v);
+                deadEnd.push_back(v);
+                candidates.push_back(v);
+                --liveTriangles[v];
+                if (time - cacheTime[v] > cacheSize)
+                    cacheTime[v] = time++;
+            }
+            emitted[t] = 1;
+        }
+
+        // Próximo leque: candidato que ainda estará no cache depois de emitir
+        // os seus triângulos, preferindo o mais antigo
+        long next = -1;
+        int best = -1;
+        for (unsigned int v : candidates)
+        {
+            if (liveTriangles[v] <= 0)
+                continue;
+            int priority = 0;
+            if (time - cacheTime[v] + 2 * liveTriangles[v] <= cacheSize)
+                priority = time - cacheTime[v];
+            if (priority > best)
+            {
+                best = priority;
+                next = v;
+            }
+        }
+        jumped = next < 0;
+        if (jumped)
+        {
+            // Beco sem saída: vértice recente ainda vivo ou o próximo na ordem
+            while (next < 0 && !deadEnd.empty())
+            {
+                const unsigned int v = deadEnd.back();
+                deadEnd.pop_back();
+                if (liveTriangles[v] > 0)
+                    next = v;
+            }
+            while (next < 0 && cursor < vertexCount)
+            {
+                if (liveTriangles[cursor] > 0)
+                    next = static_cast<long>(cursor);
+                ++cursor;
+            }
+        }
+        fanning = next;
+    }
+    if (!clusterStarts.empty() && clusterStarts.back() == output.size() / 3)
+        clusterStarts.pop_back();
+    return output;
+}
+
+std::vector<unsigned int> VertexCacheUtils::sortClustersForOverdraw(const std::vector<unsigned int> &indices,
+                                                                    const std::vector<size_t> &clusterStarts,
+                                                                    const std::vector<glm::vec3> &positions)
+{
+    const size_t triangles = indices.size() / 3;
+    const size_t clusters = clusterStarts.size();
+    if (clusters < 2)
+        return indices;
+
+    // Centro do objeto: média das áreas dos triângulos
+    glm::vec3 center(0.0f);
+    float totalArea = 0.0f;
+    std::vector<glm::vec3> centroids(clusters, glm::vec3(0.0f));
+    std::vector<glm::vec3> normals(clusters, glm::vec3(0.0f));
+    std::vector<float> areas(clusters, 0.0f);
+    for (size_t c = 0; c < clusters; ++c)
+    {
+        const size_t end = c + 1 < clusters ? clusterStarts[c + 1] : triangles;
+        for (size_t t = clusterStarts[c]; t < end; ++t)
+        {
+            const glm::vec3 &p0 = positions[indices[t * 3]];
+            const glm::vec3 &p1 = positions[indices[t * 3 + 1]];
+            const glm::vec3 &p2 = positions[indices[t * 3 + 2]];
+            glm::vec3 cross = glm::cross(p1 - p0, p2 - p0); // 2 * área * normal
+            float area = glm::length(cross) * 0.5f;
+            glm::vec3 centroid = (p0 + p1 + p2) / 3.0f;
+            centroids[c] += centroid * area;
+            normals[c] += cross;
+            areas[c] += area;
+            center += centroid * area;
+            totalArea += area;
+        }
+    }
+    if (totalArea <= 0.0f)
+        return indices;
+    center /= totalArea;
+
+    std::vector<float> keys(clusters, 0.0f);
+    for (size_t c = 0; c < clusters; ++c)
+    {
+        float length = glm::length(normals[c]);
+        if (areas[c] > 0.0f && length > 0.0f)
+            keys[c] = glm::dot(centroids[c] / areas[c] - center, normals[c] / length);
+    }
+    std::vector<size_t> order(clusters);
+    std::iota(order.begin(), order.end(), size_t(0));
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return keys[a] > keys[b]; });
+
+    std::vector<unsigned int> sorted;
+    sorted.reserve(indices.size());
+    for (size_t c : order)
+    {
+        const size_t end = c + 1 < clusters ? clusterStarts[c + 1] : triangles;
+        sorted.insert(sorted.end(), indices.begin() + clusterStarts[c] * 3, indices.begin() + end * 3);
+    }
+    return sorted;
+}
@@ -9,183 +9,1398 @@
  * Data: Fevereiro/2026
  * Descrição:
  * Implementa leitor simples de arquivos VTK contendo nós e segmentos arteriais.
+ * O arquivo é mapeado em memória e os valores são convertidos no lugar com
+ * std::from_chars, sem alocações por linha. Entradas comprimidas são lidas
+ * em lotes sobre uma janela deslizante do inflate incremental.
  */
 
-#include <fstream>
-#include <sstream>
-#include <iostream>
 #include <algorithm>
-#include <cmath>
+#include <cctype>
+#include <charconv>
+#include <cstring>
+#include <iostream>
 #include <limits>
+#include <optional>
+#include <string_view>
+#include <vector>
 #include "VtkReader.hpp"
 #include "ArterialTree.hpp"
+#include "MappedFile.hpp"
+#include "ByteOrder.hpp"
+#include "TreeCache.hpp"
+#include "ParallelUtils.hpp"
+#include "Decompressor.hpp"
 
-bool VtkReader::load(const std::string &filepath, ArterialTree &outTree)
+namespace
 {
-    std::ifstream file(filepath);
-    if (!file.is_open())
+    inline bool isSpace(char c)
     {
-        std::cerr << "[VTKReader] Falha ao abrir arquivo: " << filepath << std::endl;
-        return false;
+        return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\v' || c == '\f';
     }
-    std::string line;
-    size_t numPoints = 0, numLines = 0, numLineIndices = 0;
-    outTree.nodes.clear();
-    outTree.segments.clear();
-    std::vector<ArterialSegment> tempSegments;
-    enum State
-    {
-        SEEK,
-        POINTS,
-        LINES,
-        SCALARS,
-        RADII
-    } state = SEEK;
-    size_t pointsRead = 0, linesRead = 0, radiiRead = 0;
-    bool foundPoints = false, foundLines = false, foundRadii = false;
-    while (std::getline(file, line))
+
+    inline bool isBlank(char c)
     {
-        line.erase(0, line.find_first_not_of(" \t\r\n"));
-        line.erase(line.find_last_not_of(" \t\r\n") + 1);
-        if (line.empty())
-            continue;
-        std::stringstream ss(line);
-        std::string keyword;
-        ss >> keyword;
-        // Converte a palavra-chave para maiúsculas para correspondência robusta
-        std::string keyword_upper = keyword;
-        std::transform(keyword_upper.begin(), keyword_upper.end(), keyword_upper.begin(), ::toupper);
-        if (state == SEEK)
+        return c == ' ' || c == '\t' || c == '\r';
+    }
+
+    // Cursor sobre o buffer do arquivo. Todas as leituras acontecem no lugar:
+    // nenhuma std::string ou std::stringstream é criada por linha.
+    struct Cursor
+    {
+        const char *p;
+        const char *end;
+
+        bool atEnd() const { return p >= end; }
+        size_t remaining() const { return static_cast<size_t>(end - p); }
+
+        void skipSpaces()
         {
-            if (keyword_upper == "POINTS")
+            while (p < end && isSpace(*p))
+                ++p;
+        }
+
+        void skipLine()
+        {
+            const void *nl = std::memchr(p, '\n', remaining());
+            p = nl ? static_cast<const char *>(nl) + 1 : end;
+        }
+
+        // Próxima palavra da linha atual (vazia se a linha terminou)
+        std::string_view word()
+        {
+            while (p < end && isBlank(*p))
+                ++p;
+            const char *start = p;
+            while (p < end && !isSpace(*p))
+                ++p;
+            return std::string_view(start, static_cast<size_t>(p - start));
+        }
+
+        // Próximo número, atravessando quebras de linha (seções de dados)
+        template <typename T>
+        bool number(T &out)
+        {
+            skipSpaces();
+            // from_chars não aceita o '+' inicial que o stringstream lia ("+1.5e-3")
+            const char *start = p;
+            if (start + 1 < end && *start == '+' && start[1] != '-' && start[1] != '+')
+                ++start;
+            auto res = std::from_chars(start, end, out);
+            if (res.ec != std::errc())
+                return false;
+            p = res.ptr;
+            return true;
+        }
+
+        // Próximo número restrito à linha atual (cabeçalhos de seção)
+        template <typename T>
+        bool inlineNumber(T &out)
+        {
+            while (p < end && isBlank(*p))
+                ++p;
+            return number(out);
+        }
+
+        bool nextIsNumber()
+        {
+            skipSpaces();
+            return p < end && (std::isdigit(static_cast<unsigned char>(*p)) || *p == '-' || *p == '+' || *p == '.');
+        }
+    };
+
+    bool equalsNoCase(std::string_view a, std::string_view b)
+    {
+        if (a.size() != b.size())
+            return false;
+        for (size_t i = 0; i < a.size(); ++i)
+        {
+            if (std::toupper(static_cast<unsigned char>(a[i])) != std::toupper(static_cast<unsigned char>(b[i])))
+                return false;
+        }
+        return true;
+    }
+
+    // Tamanho em bytes dos tipos de dados do formato legado (0 = desconhecido)
+    size_t binaryTypeSize(std::string_view type)
+    {
+        if (equalsNoCase(type, "bit") || equalsNoCase(type, "char") || equalsNoCase(type, "unsigned_char"))
+            return 1;
+        if (equalsNoCase(type, "short") || equalsNoCase(type, "unsigned_short"))
+            return 2;
+        if (equalsNoCase(type, "int") || equalsNoCase(type, "unsigned_int") || equalsNoCase(type, "float") ||
+            equalsNoCase(type, "vtktypeint32") || equalsNoCase(type, "vtktypeuint32"))
+            return 4;
+        if (equalsNoCase(type, "long") || equalsNoCase(type, "unsigned_long") || equalsNoCase(type, "double") ||
+            equalsNoCase(type, "vtktypeint64") || equalsNoCase(type, "vtktypeuint64"))
+            return 8;
+        return 0;
+    }
+
+    bool cancelled(const VtkReadOptions &options)
+    {
+        return options.cancel && options.cancel->load(std::memory_order_relaxed);
+    }
+
+    // Seções com menos valores que isso são lidas na thread chamadora
+    const size_t PARALLEL_MIN_VALUES = 1 << 18;
+
+    enum ValueError
+    {
+        VALUE_OK = 0,
+        VALUE_MALFORMED, // número ausente ou mal formado
+        VALUE_CELL_SIZE, // célula de LINES com n != 2
+        VALUE_RANGE      // índice de nó fora do intervalo
+    };
+
+    struct SectionResult
+    {
+        ValueError error = VALUE_OK;
+        size_t index = 0;         // índice do primeiro valor com erro (modo estrito)
+        bool extraValues = false; // há números além dos esperados na seção
+    };
+
+    // Lê `count` números, entregando cada um a store(k, valor) com k a partir
+    // de `first`. `store` grava o valor e, no modo estrito, devolve o erro de
+    // validação; no modo tolerante os erros são apenas acumulados.
+    template <typename T, typename Store>
+    SectionResult scanValues(Cursor &cur, size_t first, size_t count, bool strict, const Store &store)
+    {
+        SectionResult res;
+        bool ok = true;
+        for (size_t k = first; k < first + count; ++k)
+        {
+            T value{};
+            ValueError error = cur.number(value) ? store(k, value) : VALUE_MALFORMED;
+            if (error != VALUE_OK)
             {
-                ss >> numPoints;
-                if (numPoints == 0)
+                if (strict)
                 {
-                    std::cerr << "[VTKReader] Seção POINTS não contém pontos." << std::endl;
+                    res.error = error;
+                    res.index = k;
+                    return res;
+                }
+                ok = false;
+            }
+        }
+        if (!ok)
+        {
+            res.error = VALUE_MALFORMED;
+            res.index = first;
+        }
+        return res;
+    }
+
+    // "nan"/"inf" são números válidos para from_chars, não palavras-chave
+    bool isNumericWord(std::string_view w)
+    {
+        return equalsNoCase(w, "nan") || equalsNoCase(w, "inf") || equalsNoCase(w, "infinity");
+    }
+
+    // Início da primeira linha, a partir de `p` (início de uma linha), cuja
+    // primeira palavra é uma palavra-chave, ou `end`
+    const char *findKeywordLine(const char *p, const char *end)
+    {
+        while (p < end)
+        {
+            const char *q = p;
+            while (q < end && isBlank(*q))
+                ++q;
+            if (q < end && std::isalpha(static_cast<unsigned char>(*q)))
+            {
+                Cursor c{q, end};
+                if (!isNumericWord(c.word()))
+                    return p;
+            }
+            const void *nl = std::memchr(p, '\n', static_cast<size_t>(end - p));
+            if (!nl)
+                return end;
+            p = static_cast<const char *>(nl) + 1;
+        }
+        return end;
+    }
+
+    // Início da primeira linha após a de `p` cuja primeira palavra é uma
+    // palavra-chave (fim da seção de dados atual) ou `end`
+    const char *findSectionEnd(const char *p, const char *end)
+    {
+        const void *nl = std::memchr(p, '\n', static_cast<size_t>(end - p));
+        return nl ? findKeywordLine(static_cast<const char *>(nl) + 1, end) : end;
+    }
+
+    size_t countTokens(const char *p, const char *end)
+    {
+        size_t count = 0;
+        bool inToken = false;
+        for (; p < end; ++p)
+        {
+            bool space = isSpace(*p);
+            count += (!space && !inToken);
+            inToken = !space;
+        }
+        return count;
+    }
+
+    // Lê os `total` valores de uma seção de dados. Seções grandes são divididas
+    // em blocos alinhados a quebras de linha; um primeiro passe paralelo conta
+    // os números de cada bloco e a soma de prefixos dá o índice do primeiro
+    // valor de cada um, de modo que o segundo passe converte todos os blocos
+    // em paralelo direto nos vetores já alocados.
+    template <typename T, typename Store>
+    SectionResult parseSection(Cursor &cur, size_t total, bool strict, unsigned threads, const Store &store)
+    {
+        const size_t taskCount = ParallelUtils::taskCountFor(total, PARALLEL_MIN_VALUES, threads);
+        if (taskCount <= 1)
+        {
+            SectionResult res = scanValues<T>(cur, 0, total, strict, store);
+            Cursor peek = cur;
+            res.extraValues = res.error == VALUE_OK && peek.nextIsNumber();
+            return res;
+        }
+
+        const char *begin = cur.p;
+        const char *sectionEnd = findSectionEnd(begin, cur.end);
+        std::vector<const char *> bounds(taskCount + 1, sectionEnd);
+        bounds[0] = begin;
+        for (size_t t = 1; t < taskCount; ++t)
+        {
+            const char *split = begin + static_cast<size_t>(sectionEnd - begin) * t / taskCount;
+            split = std::max(split, bounds[t - 1]);
+            const void *nl = std::memchr(split, '\n', static_cast<size_t>(sectionEnd - split));
+            bounds[t] = nl ? static_cast<const char *>(nl) + 1 : sectionEnd;
+        }
+
+        std::vector<size_t> firstValue(taskCount + 1, 0);
+        ParallelUtils::runTasks(taskCount, [&](size_t t)
+                                { firstValue[t + 1] = countTokens(bounds[t], bounds[t + 1]); });
+        for (size_t t = 0; t < taskCount; ++t)
+            firstValue[t + 1] += firstValue[t];
+
+        std::vector<SectionResult> results(taskCount);
+        ParallelUtils::runTasks(taskCount, [&](size_t t)
+                                {
+            const size_t first = std::min(firstValue[t], total);
+            const size_t last = std::min(firstValue[t + 1], total);
+            Cursor chunk{bounds[t], bounds[t + 1]};
+            results[t] = scanValues<T>(chunk, first, last - first, strict, store); });
+
+        // Blocos terminam em erro de forma independente: vale o primeiro
+        SectionResult res;
+        for (const SectionResult &r : results)
+        {
+            if (r.error != VALUE_OK)
+            {
+                res = r;
+                break;
+            }
+        }
+        if (res.error == VALUE_OK && firstValue[taskCount] < total)
+        {
+            res.error = VALUE_MALFORMED;
+            res.index = firstValue[taskCount];
+        }
+        res.extraValues = firstValue[taskCount] > total;
+        // Para na quebra de linha que antecede a próxima seção (o laço
+        // principal sempre avança uma linha após ler a seção)
+        cur.p = (sectionEnd > begin && sectionEnd[-1] == '\n') ? sectionEnd - 1 : sectionEnd;
+        return res;
+    }
+
+    // Itens por lote na leitura em lotes (VtkReader::stream)
+    const size_t STREAM_BATCH = 1 << 14;
+    // Janela inicial de texto descomprimido por cursor
+    const size_t STREAM_WINDOW = 1 << 20;
+
+    // Cursor da leitura em lotes. Sobre um arquivo mapeado a janela é o
+    // arquivo inteiro; sobre uma entrada comprimida o conteúdo é descomprimido
+    // aos poucos num buffer de tamanho fixo, que só expõe linhas completas às
+    // leituras de texto: nenhum número fica partido entre duas recargas.
+    // Copiar o cursor clona também o descompressor, e a cópia continua a
+    // leitura do mesmo ponto (seções lidas lado a lado, como LINES e raios).
+    class StreamCursor
+    {
+    public:
+        StreamCursor() = default;
+        StreamCursor(const char *data, size_t size) : m_p(data), m_text(data + size), m_end(data + size) {}
+        explicit StreamCursor(InflateStream source) : m_source(std::move(source)), m_buffer(STREAM_WINDOW)
+        {
+            m_p = m_text = m_end = m_buffer.data();
+        }
+
+        StreamCursor(const StreamCursor &other) { *this = other; }
+        StreamCursor(StreamCursor &&other) = default;
+        StreamCursor &operator=(StreamCursor &&other) = default;
+        StreamCursor &operator=(const StreamCursor &other)
+        {
+            if (this == &other)
+                return *this;
+            m_source = other.m_source;
+            m_eof = other.m_eof;
+            if (!m_source)
+            {
+                m_buffer.clear();
+                m_p = other.m_p;
+                m_text = other.m_text;
+                m_end = other.m_end;
+                return *this;
+            }
+            // Os ponteiros passam a apontar para o buffer copiado
+            m_buffer = other.m_buffer;
+            const char *base = other.m_buffer.data();
+            m_p = m_buffer.data() + (other.m_p - base);
+            m_text = m_buffer.data() + (other.m_text - base);
+            m_end = m_buffer.data() + (other.m_end - base);
+            return *this;
+        }
+
+        // Fim dos dados (válido após skipSpaces)
+        bool atEnd() const { return m_p >= m_text; }
+
+        // Limite superior dos bytes restantes, para rejeitar contagens
+        // corrompidas nos cabeçalhos antes de alocar memória para elas
+        size_t sizeBound() const
+        {
+            const size_t buffered = static_cast<size_t>(m_end - m_p);
+            if (!m_source)
+                return buffered;
+            return std::min(std::numeric_limits<size_t>::max() - buffered, m_source->sizeBound()) + buffered;
+        }
+
+        void skipSpaces()
+        {
+            while (true)
+            {
+                Cursor c = view();
+                c.skipSpaces();
+                m_p = c.p;
+                if (m_p < m_text || !refillText())
+                    return;
+            }
+        }
+
+        void skipLine()
+        {
+            if (m_p >= m_text && !refillText())
+                return;
+            Cursor c = view();
+            c.skipLine();
+            m_p = c.p;
+        }
+
+        // Próxima palavra da linha atual, válida até a próxima recarga
+        std::string_view word()
+        {
+            if (m_p >= m_text)
+                refillText();
+            Cursor c = view();
+            std::string_view w = c.word();
+            m_p = c.p;
+            return w;
+        }
+
+        template <typename T>
+        bool number(T &out)
+        {
+            skipSpaces();
+            Cursor c = view();
+            bool ok = c.number(out);
+            m_p = c.p;
+            return ok;
+        }
+
+        template <typename T>
+        bool inlineNumber(T &out)
+        {
+            if (m_p >= m_text)
+                refillText();
+            Cursor c = view();
+            bool ok = c.inlineNumber(out);
+            m_p = c.p;
+            return ok;
+        }
+
+        bool nextIsNumber()
+        {
+            skipSpaces();
+            Cursor c = view();
+            return c.nextIsNumber();
+        }
+
+        // Pula o bloco de dados que começa na linha atual até a linha da
+        // próxima palavra-chave
+        void skipSection()
+        {
+            skipLine();
+            while (true)
+            {
+                m_p = findKeywordLine(m_p, m_text);
+                if (m_p < m_text || !refillText())
+                    return;
+            }
+        }
+
+        // `n` bytes contíguos a partir da posição atual (blocos binários),
+        // válidos até a próxima leitura; nullptr se a entrada termina antes
+        const char *take(size_t n)
+        {
+            if (static_cast<size_t>(m_end - m_p) < n)
+            {
+                if (!m_source)
+                    return nullptr;
+                fill(n, false);
+                if (static_cast<size_t>(m_end - m_p) < n)
+                    return nullptr;
+            }
+            const char *data = m_p;
+            m_p += n;
+            return data;
+        }
+
+        bool skip(size_t n)
+        {
+            while (static_cast<size_t>(m_end - m_p) < n)
+            {
+                n -= static_cast<size_t>(m_end - m_p);
+                m_p = m_end;
+                if (!m_source)
+                    return false;
+                fill(1, false);
+                if (m_p == m_end)
                     return false;
+            }
+            m_p += n;
+            return true;
+        }
+
+        // Descomprime o restante da entrada só para conferir o checksum do
+        // fluxo (falso se não confere). Arquivos mapeados não têm o que conferir.
+        bool drain()
+        {
+            if (!m_source)
+                return true;
+            m_p = m_text = m_end = m_buffer.data();
+            while (m_source->read(m_buffer.data(), m_buffer.size()) > 0)
+            {
+            }
+            m_eof = true;
+            return m_source->finished();
+        }
+
+    private:
+        Cursor view() const { return Cursor{m_p, m_text}; }
+
+        // Chamado com o texto da janela esgotado: recarrega e diz se há texto novo
+        bool refillText()
+        {
+            if (!m_source)
+                return false;
+            fill(0, true);
+            return m_text > m_p;
+        }
+
+        // Move o que falta ler para o início do buffer e o completa com dados
+        // novos até haver `minBytes` bytes e, se `wholeLine`, uma quebra de
+        // linha (ou até o fim do fluxo). Linhas maiores que a janela a ampliam.
+        void fill(size_t minBytes, bool wholeLine)
+        {
+            size_t kept = static_cast<size_t>(m_end - m_p);
+            std::memmove(m_buffer.data(), m_p, kept);
+            bool hasLine = std::memchr(m_buffer.data(), '\n', kept) != nullptr;
+            while (!m_eof && (kept < minBytes || (wholeLine && !hasLine)))
+            {
+                if (kept == m_buffer.size() || m_buffer.size() < minBytes)
+                    m_buffer.resize(std::max(minBytes, m_buffer.size() * 2));
+                const size_t n = m_source->read(m_buffer.data() + kept, m_buffer.size() - kept);
+                if (n == 0)
+                {
+                    m_eof = true;
+                    break;
                 }
-                state = POINTS;
-                pointsRead = 0;
-                continue;
+                hasLine = hasLine || std::memchr(m_buffer.data() + kept, '\n', n) != nullptr;
+                kept += n;
             }
+            m_p = m_buffer.data();
+            m_end = m_p + kept;
+            // O texto visível termina na última quebra de linha (ou no fim do fluxo)
+            m_text = m_end;
+            if (!m_eof)
+            {
+                while (m_text > m_p && m_text[-1] != '\n')
+                    --m_text;
+            }
+        }
+
+        const char *m_p = nullptr;
+        const char *m_text = nullptr; // fim das linhas completas
+        const char *m_end = nullptr;  // fim dos dados disponíveis
+        std::optional<InflateStream> m_source;
+        std::vector<char> m_buffer;
+        bool m_eof = false;
+    };
+
+    // Confere de uma vez os `count` pares de índices de um lote (modo tolerante)
+    bool indicesInRange(const int *pairs, size_t count, int nodeCount)
+    {
+        int minIndex = 0, maxIndex = -1;
+        for (size_t i = 0; i < count * 2; ++i)
+        {
+            minIndex = std::min(minIndex, pairs[i]);
+            maxIndex = std::max(maxIndex, pairs[i]);
         }
-        if (state == POINTS)
+        return minIndex >= 0 && maxIndex < nodeCount;
+    }
+
+    // Blocos de dados de um VTK BINARY: um cursor posicionado no início de cada um
+    struct BinaryLayout
+    {
+        StreamCursor points;
+        size_t numPoints = 0;
+        size_t pointSize = 0; // 4 (float) ou 8 (double)
+        StreamCursor lines;
+        size_t numLines = 0;
+        StreamCursor radii;
+        size_t radiusSize = 0;
+        bool hasPoints = false, hasLines = false, hasRadii = false;
+
+        bool complete() const { return hasPoints && hasLines && hasRadii; }
+    };
+
+    // Percorre os cabeçalhos de seção de um VTK BINARY pulando os blocos de
+    // dados, até encontrar pontos, linhas e raios. Nenhum valor é convertido.
+    bool locateBinary(StreamCursor cur, const std::string &filepath, BinaryLayout &layout)
+    {
+        bool cellData = false;
+        size_t attributeCount = 0; // elementos da seção CELL_DATA/POINT_DATA atual
+
+        // Pula as três linhas do cabeçalho (versão, título e "BINARY")
+        cur.skipLine();
+        cur.skipLine();
+        cur.skipLine();
+
+        // Ao contrário do ASCII, blocos binários de seções desconhecidas não podem
+        // ser pulados linha a linha: toda seção precisa ter o tamanho conhecido.
+        // O bloco tem `count` elementos de `elementSize` bytes; a contagem é
+        // comparada antes da multiplicação, que daria a volta em size_t com
+        // cabeçalhos absurdos
+        auto skipBlock = [&](size_t count, size_t elementSize, std::string_view section) -> bool
         {
-            float x, y, z;
-            std::stringstream pointStream(line);
-            if (!(pointStream >> x >> y >> z))
+            if ((elementSize != 0 && count > cur.sizeBound() / elementSize) || !cur.skip(count * elementSize))
+            {
+                std::cerr << "[VTKReader] Seção " << section << " truncada: " << filepath << std::endl;
+                return false;
+            }
+            return true;
+        };
+        // Guarda o início de um bloco procurado e o pula se ainda faltam seções
+        auto markBlock = [&](StreamCursor &slot, size_t count, size_t elementSize, std::string_view section) -> bool
+        {
+            slot = cur;
+            return layout.complete() || skipBlock(count, elementSize, section);
+        };
+
+        while (!layout.complete())
+        {
+            cur.skipSpaces();
+            if (cur.atEnd())
+                break;
+            // Cópia: o nome é usado nas mensagens depois de recargas do cursor
+            const std::string keyword(cur.word());
+            if (equalsNoCase(keyword, "DATASET"))
+            {
+                if (!equalsNoCase(cur.word(), "POLYDATA"))
+                {
+                    std::cerr << "[VTKReader] Apenas DATASET POLYDATA é suportado: " << filepath << std::endl;
+                    return false;
+                }
+                cur.skipLine();
+            }
+            else if (equalsNoCase(keyword, "POINTS"))
+            {
+                size_t numPoints = 0;
+                if (!cur.inlineNumber(numPoints) || numPoints == 0)
+                {
+                    std::cerr << "[VTKReader] Seção POINTS não contém pontos." << std::endl;
+                    return false;
+                }
+                std::string_view type = cur.word();
+                const size_t typeSize = binaryTypeSize(type);
+                if (!equalsNoCase(type, "float") && !equalsNoCase(type, "double"))
+                {
+                    std::cerr << "[VTKReader] Tipo de POINTS não suportado: " << type << std::endl;
+                    return false;
+                }
+                cur.skipLine();
+                if (numPoints > cur.sizeBound() / (3 * typeSize))
+                {
+                    std::cerr << "[VTKReader] Seção POINTS truncada: " << filepath << std::endl;
+                    return false;
+                }
+                layout.numPoints = numPoints;
+                layout.pointSize = typeSize;
+                layout.hasPoints = true;
+                if (!markBlock(layout.points, numPoints, 3 * typeSize, keyword))
+                    return false;
+            }
+            else if (equalsNoCase(keyword, "LINES"))
+            {
+                size_t numLines = 0, numInts = 0;
+                if (!cur.inlineNumber(numLines) || !cur.inlineNumber(numInts) || numLines == 0)
+                {
+                    std::cerr << "[VTKReader] Seção LINES não contém linhas." << std::endl;
+                    return false;
+                }
+                cur.skipLine();
+                // Antes da multiplicação: numLines * 3 pode dar a volta em size_t
+                if (numLines > cur.sizeBound() / 12)
+                {
+                    std::cerr << "[VTKReader] Seção LINES truncada: " << filepath << std::endl;
+                    return false;
+                }
+                // Cada célula é [n, a, b]; o decodificador depende desse layout fixo
+                if (numInts != numLines * 3)
+                {
+                    std::cerr << "[VTKReader] Apenas segmentos (n=2) são suportados em LINES: " << filepath << std::endl;
+                    return false;
+                }
+                layout.numLines = numLines;
+                layout.hasLines = true;
+                if (!markBlock(layout.lines, numInts, 4, keyword))
+                    return false;
+            }
+            else if (equalsNoCase(keyword, "VERTICES") || equalsNoCase(keyword, "POLYGONS") ||
+                     equalsNoCase(keyword, "TRIANGLE_STRIPS"))
+            {
+                size_t numCells = 0, numInts = 0;
+                cur.inlineNumber(numCells);
+                cur.inlineNumber(numInts);
+                cur.skipLine();
+                if (!skipBlock(numInts, 4, keyword))
+                    return false;
+            }
+            else if (equalsNoCase(keyword, "CELL_DATA") || equalsNoCase(keyword, "POINT_DATA"))
+            {
+                cellData = equalsNoCase(keyword, "CELL_DATA");
+                attributeCount = 0;
+                cur.inlineNumber(attributeCount);
+                cur.skipLine();
+            }
+            // Aceitar tanto SCALARS quanto scalars, e tanto radius quanto raio
+            else if (equalsNoCase(keyword, "SCALARS"))
             {
-                std::cerr << "[VTKReader] Erro ao ler ponto no índice " << pointsRead << std::endl;
+                const std::string name(cur.word());
+                const std::string type(cur.word());
+                size_t numComp = 1;
+                if (!cur.inlineNumber(numComp))
+                    numComp = 1;
+                // O formato admite de 1 a 4 componentes
+                if (numComp == 0 || numComp > 4)
+                {
+                    std::cerr << "[VTKReader] Número de componentes inválido em SCALARS: " << numComp << std::endl;
+                    return false;
+                }
+                cur.skipLine();
+                // LOOKUP_TABLE é opcional em alguns escritores
+                StreamCursor peek = cur;
+                peek.skipSpaces();
+                if (equalsNoCase(peek.word(), "LOOKUP_TABLE"))
+                {
+                    cur = std::move(peek);
+                    cur.skipLine();
+                }
+                const size_t typeSize = binaryTypeSize(type);
+                if (typeSize == 0)
+                {
+                    std::cerr << "[VTKReader] Tipo de SCALARS não suportado: " << type << std::endl;
+                    return false;
+                }
+                bool isRadius = equalsNoCase(name, "radius") || equalsNoCase(name, "raio");
+                bool isReal = equalsNoCase(type, "float") || equalsNoCase(type, "double");
+                if (isRadius && cellData && numComp == 1 && isReal)
+                {
+                    if (attributeCount != layout.numLines)
+                    {
+                        std::cerr << "[VTKReader] Número de raios (" << attributeCount << ") difere do número de segmentos (" << layout.numLines << ")" << std::endl;
+                        return false;
+                    }
+                    if (attributeCount > cur.sizeBound() / typeSize)
+                    {
+                        std::cerr << "[VTKReader] Seção de raios truncada: " << filepath << std::endl;
+                        return false;
+                    }
+                    layout.radiusSize = typeSize;
+                    layout.hasRadii = true;
+                    if (!markBlock(layout.radii, attributeCount, typeSize, keyword))
+                        return false;
+                }
+                else if (!skipBlock(attributeCount, numComp * typeSize, keyword))
+                {
+                    return false;
+                }
+            }
+            else if (equalsNoCase(keyword, "VECTORS") || equalsNoCase(keyword, "NORMALS"))
+            {
+                cur.word();
+                const size_t typeSize = binaryTypeSize(cur.word());
+                cur.skipLine();
+                if (typeSize == 0 || !skipBlock(attributeCount, 3 * typeSize, keyword))
+                    return false;
+            }
+            else if (equalsNoCase(keyword, "LOOKUP_TABLE"))
+            {
+                // Tabela de cores independente: `size` entradas RGBA de 1 byte
+                cur.word();
+                size_t tableSize = 0;
+                cur.inlineNumber(tableSize);
+                cur.skipLine();
+                if (!skipBlock(tableSize, 4, keyword))
+                    return false;
+            }
+            else
+            {
+                // FIELD, OFFSETS/CONNECTIVITY (VTK 5.1) etc.: tamanho do bloco desconhecido
+                std::cerr << "[VTKReader] Seção " << keyword << " não suportada em VTK binário: " << filepath << std::endl;
                 return false;
             }
-            outTree.nodes.push_back({glm::vec3(x, y, z)});
-            pointsRead++;
-            if (pointsRead == numPoints)
+        }
+
+        if (!layout.complete())
+        {
+            std::cerr << "[VTKReader] Falha no parsing ou arquivo incompleto: " << filepath << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    // Decodifica `count` pontos consecutivos a partir de `src` para `out`
+    void decodeBinaryPoints(const char *src, size_t pointSize, size_t count, glm::vec3 *out)
+    {
+        if (pointSize == 4)
+        {
+            // Cópia direta com troca de bytes
+            ByteOrder::copy32(reinterpret_cast<char *>(out), src, count * 3, true);
+            return;
+        }
+        for (size_t i = 0; i < count; ++i, src += 24)
+        {
+            out[i] = glm::vec3(static_cast<float>(ByteOrder::load<double>(src, true)),
+                               static_cast<float>(ByteOrder::load<double>(src + 8, true)),
+                               static_cast<float>(ByteOrder::load<double>(src + 16, true)));
+        }
+    }
+
+    // Decodifica as células [first, first + count) de LINES, cujos bytes
+    // começam em `src`, entregando cada segmento a store(i, a, b). No modo
+    // estrito valida n=2 e os índices.
+    template <typename Store>
+    bool decodeBinaryCells(const char *src, size_t first, size_t count, int nodeCount, bool strict, const Store &store)
+    {
+        for (size_t i = first; i < first + count; ++i, src += 12)
+        {
+            int a = ByteOrder::load<int32_t>(src + 4, true);
+            int b = ByteOrder::load<int32_t>(src + 8, true);
+            if (strict)
+            {
+                int n = ByteOrder::load<int32_t>(src, true);
+                if (n != 2)
+                {
+                    std::cerr << "[VTKReader] Apenas segmentos (n=2) são suportados. Encontrado n=" << n << std::endl;
+                    return false;
+                }
+                if (a < 0 || b < 0 || a >= nodeCount || b >= nodeCount)
+                {
+                    std::cerr << "[VTKReader] Índice de nó fora do intervalo na linha " << i << std::endl;
+                    return false;
+                }
+            }
+            store(i, a, b);
+        }
+        return true;
+    }
+
+    // Decodifica `count` raios consecutivos a partir de `src` para `out`
+    void decodeBinaryRadii(const char *src, size_t radiusSize, size_t count, float *out)
+    {
+        for (size_t i = 0; i < count; ++i, src += radiusSize)
+        {
+            out[i] = (radiusSize == 4) ? ByteOrder::load<float>(src, true)
+                                       : static_cast<float>(ByteOrder::load<double>(src, true));
+        }
+    }
+
+    // Leitura em lotes de um VTK ASCII
+    bool streamAscii(StreamCursor cur, const std::string &filepath, VtkVisitor &visitor, bool strict)
+    {
+        // 1. Localiza as seções sem converter valores: o bloco de dados de cada
+        // uma é pulado até a linha da próxima palavra-chave, e um cursor fica
+        // no início de cada seção procurada. Conhecer o início dos raios
+        // permite ler LINES e raios lado a lado e entregar segmentos completos.
+        StreamCursor pc, lc, rc;
+        bool foundPoints = false, foundLines = false, foundRadii = false;
+        size_t numPoints = 0, numLines = 0, numLineIndices = 0;
+        bool radiusScalars = false;
+        while (!foundRadii)
+        {
+            cur.skipSpaces();
+            if (cur.atEnd())
+                break;
+            std::string_view keyword = cur.word();
+            if (equalsNoCase(keyword, "POINTS"))
             {
+                if (!cur.inlineNumber(numPoints) || numPoints == 0)
+                {
+                    std::cerr << "[VTKReader] Seção POINTS não contém pontos." << std::endl;
+                    return false;
+                }
+                cur.skipLine();
+                if (numPoints > cur.sizeBound() / 6)
+                {
+                    std::cerr << "[VTKReader] Seção POINTS truncada: " << filepath << std::endl;
+                    return false;
+                }
+                pc = cur;
                 foundPoints = true;
-                state = SEEK;
+                cur.skipSection();
+                continue;
             }
-            continue;
+            if (equalsNoCase(keyword, "LINES"))
+            {
+                if (!cur.inlineNumber(numLines) || !cur.inlineNumber(numLineIndices) || numLines == 0)
+                {
+                    std::cerr << "[VTKReader] Seção LINES não contém linhas." << std::endl;
+                    return false;
+                }
+                cur.skipLine();
+                if (numLines > cur.sizeBound() / 6)
+                {
+                    std::cerr << "[VTKReader] Seção LINES truncada: " << filepath << std::endl;
+                    return false;
+                }
+                lc = cur;
+                foundLines = true;
+                cur.skipSection();
+                continue;
+            }
+            if (equalsNoCase(keyword, "SCALARS"))
+            {
+                std::string_view name = cur.word();
+                radiusScalars = equalsNoCase(name, "radius") || equalsNoCase(name, "raio");
+            }
+            else if (radiusScalars && equalsNoCase(keyword, "LOOKUP_TABLE"))
+            {
+                cur.skipLine();
+                rc = std::move(cur);
+                foundRadii = true;
+                break;
+            }
+            cur.skipLine();
         }
-        if (state == SEEK && keyword_upper == "LINES")
+        if (!foundPoints || !foundLines || !foundRadii)
+        {
+            std::cerr << "[VTKReader] Falha no parsing ou arquivo incompleto: " << filepath << std::endl;
+            return false;
+        }
+        if (!visitor.onBegin(numPoints, numLines))
+            return false;
+
+        // 2. Nós, em lotes
+        std::vector<glm::vec3> nodeBatch(std::min(numPoints, STREAM_BATCH));
+        for (size_t first = 0; first < numPoints; first += STREAM_BATCH)
         {
-            ss >> numLines >> numLineIndices;
-            if (numLines == 0)
+            const size_t count = std::min(STREAM_BATCH, numPoints - first);
+            bool ok = true;
+            for (size_t i = 0; i < count; ++i)
             {
-                std::cerr << "[VTKReader] Seção LINES não contém linhas." << std::endl;
+                glm::vec3 &pos = nodeBatch[i];
+                bool read = pc.number(pos.x);
+                read &= pc.number(pos.y);
+                read &= pc.number(pos.z);
+                if (strict && !read)
+                {
+                    std::cerr << "[VTKReader] Erro ao ler ponto no índice " << first + i << std::endl;
+                    return false;
+                }
+                ok &= read;
+            }
+            if (!ok)
+            {
+                std::cerr << "[VTKReader] Erro ao ler seção POINTS: " << filepath << std::endl;
                 return false;
             }
-            tempSegments.clear();
-            linesRead = 0;
-            state = LINES;
-            continue;
+            if (!visitor.onNodes(first, nodeBatch.data(), count))
+                return false;
         }
-        if (state == LINES)
+        // Libera a janela do cursor de pontos
+        pc = StreamCursor();
+
+        // 3. Segmentos e raios lidos lado a lado
+        const int nodeCount = static_cast<int>(numPoints);
+        const size_t batch = std::min(numLines, STREAM_BATCH);
+        std::vector<int> pairBatch(batch * 2);
+        std::vector<float> radiusBatch(batch);
+        for (size_t first = 0; first < numLines; first += STREAM_BATCH)
         {
-            int n, a, b;
-            std::stringstream lineStream(line);
-            if (!(lineStream >> n >> a >> b))
+            const size_t count = std::min(STREAM_BATCH, numLines - first);
+            bool ok = true;
+            for (size_t i = 0; i < count; ++i)
+            {
+                int n = 0, a = 0, b = 0;
+                bool read = lc.number(n);
+                read &= lc.number(a);
+                read &= lc.number(b);
+                if (strict)
+                {
+                    if (!read)
+                    {
+                        std::cerr << "[VTKReader] Erro ao ler conectividade de linha na linha " << first + i << std::endl;
+                        return false;
+                    }
+                    if (n != 2)
+                    {
+                        std::cerr << "[VTKReader] Apenas segmentos (n=2) são suportados. Encontrado n=" << n << std::endl;
+                        return false;
+                    }
+                    if (a < 0 || b < 0 || a >= nodeCount || b >= nodeCount)
+                    {
+                        std::cerr << "[VTKReader] Índice de nó fora do intervalo na linha " << first + i << std::endl;
+                        return false;
+                    }
+                }
+                ok &= read;
+                pairBatch[2 * i] = a;
+                pairBatch[2 * i + 1] = b;
+            }
+            if (!ok)
             {
-                std::cerr << "[VTKReader] Erro ao ler conectividade de linha na linha " << linesRead << std::endl;
+                std::cerr << "[VTKReader] Erro ao ler seção LINES: " << filepath << std::endl;
                 return false;
             }
-            if (n != 2)
+            for (size_t i = 0; i < count; ++i)
+            {
+                bool read = rc.number(radiusBatch[i]);
+                if (strict && !read)
+                {
+                    std::cerr << "[VTKReader] Erro ao ler raio no índice " << first + i << std::endl;
+                    return false;
+                }
+                ok &= read;
+            }
+            if (!ok)
             {
-                std::cerr << "[VTKReader] Apenas segmentos (n=2) são suportados. Encontrado n=" << n << std::endl;
+                std::cerr << "[VTKReader] Erro ao ler seção de raios: " << filepath << std::endl;
                 return false;
             }
-            tempSegments.push_back({a, b, 0.0f});
-            linesRead++;
-            if (linesRead == numLines)
+            if (!strict && !indicesInRange(pairBatch.data(), count, nodeCount))
             {
-                foundLines = true;
-                state = SEEK;
+                std::cerr << "[VTKReader] Índice de nó fora do intervalo: " << filepath << std::endl;
+                return false;
             }
-            continue;
+            if (!visitor.onSegments(first, pairBatch.data(), count) || !visitor.onRadii(first, radiusBatch.data(), count))
+                return false;
         }
-        // Aceitar tanto SCALARS quanto scalars, e tanto radius quanto raio
-        if (state == SEEK && keyword_upper == "SCALARS")
+        if (strict && rc.nextIsNumber())
+        {
+            std::cerr << "[VTKReader] Mais raios que segmentos!" << std::endl;
+            return false;
+        }
+        return rc.drain();
+    }
+
+    // Leitura em lotes de um VTK BINARY
+    bool streamBinary(StreamCursor cur, const std::string &filepath, VtkVisitor &visitor, bool strict)
+    {
+        BinaryLayout layout;
+        if (!locateBinary(std::move(cur), filepath, layout))
+            return false;
+        if (!visitor.onBegin(layout.numPoints, layout.numLines))
+            return false;
+        // Entradas comprimidas só revelam o tamanho real ao serem lidas
+        auto truncated = [&filepath](const char *section)
         {
-            std::string name, type;
-            ss >> name >> type;
-            std::string name_lower = name;
-            std::transform(name_lower.begin(), name_lower.end(), name_lower.begin(), ::tolower);
-            if (name_lower == "radius" || name_lower == "raio")
+            std::cerr << "[VTKReader] Seção " << section << " truncada: " << filepath << std::endl;
+            return false;
+        };
+
+        std::vector<glm::vec3> nodeBatch(std::min(layout.numPoints, STREAM_BATCH));
+        for (size_t first = 0; first < layout.numPoints; first += STREAM_BATCH)
+        {
+            const size_t count = std::min(STREAM_BATCH, layout.numPoints - first);
+            const char *src = layout.points.take(count * 3 * layout.pointSize);
+            if (!src)
+                return truncated("POINTS");
+            decodeBinaryPoints(src, layout.pointSize, count, nodeBatch.data());
+            if (!visitor.onNodes(first, nodeBatch.data(), count))
+                return false;
+        }
+        layout.points = StreamCursor();
+
+        const int nodeCount = static_cast<int>(layout.numPoints);
+        const size_t batch = std::min(layout.numLines, STREAM_BATCH);
+        std::vector<int> pairBatch(batch * 2);
+        std::vector<float> radiusBatch(batch);
+        for (size_t first = 0; first < layout.numLines; first += STREAM_BATCH)
+        {
+            const size_t count = std::min(STREAM_BATCH, layout.numLines - first);
+            const char *cells = layout.lines.take(count * 12);
+            if (!cells)
+                return truncated("LINES");
+            bool cellsOk = decodeBinaryCells(cells, first, count, nodeCount, strict,
+                                             [&pairBatch, first](size_t i, int a, int b)
+                                             {
+                                                 pairBatch[2 * (i - first)] = a;
+                                                 pairBatch[2 * (i - first) + 1] = b;
+                                             });
+            if (!cellsOk)
+                return false;
+            if (!strict && !indicesInRange(pairBatch.data(), count, nodeCount))
             {
-                state = SCALARS;
+                std::cerr << "[VTKReader] Índice de nó fora do intervalo: " << filepath << std::endl;
+                return false;
             }
-            continue;
+            const char *radii = layout.radii.take(count * layout.radiusSize);
+            if (!radii)
+                return truncated("de raios");
+            decodeBinaryRadii(radii, layout.radiusSize, count, radiusBatch.data());
+            if (!visitor.onSegments(first, pairBatch.data(), count) || !visitor.onRadii(first, radiusBatch.data(), count))
+                return false;
         }
-        if (state == SCALARS && keyword_upper == "LOOKUP_TABLE")
+        return layout.radii.drain();
+    }
+
+    // Monta a árvore de saída a partir dos lotes (VtkReader::load de entradas comprimidas)
+    class TreeBuilder : public VtkVisitor
+    {
+    public:
+        TreeBuilder(ArterialTree &tree, const VtkReadOptions &options) : m_tree(tree), m_options(options) {}
+
+        bool onBegin(size_t numPoints, size_t numSegments) override
         {
-            // Próximas linhas contém os raios (valores escalares)
-            radiiRead = 0;
-            state = RADII;
-            continue;
+            m_tree.nodes.clear();
+            m_tree.segments.clear();
+            m_tree.nodes.resize(numPoints);
+            m_tree.segments.resize(numSegments);
+            return !cancelled(m_options);
+        }
+
+        bool onNodes(size_t first, const glm::vec3 *positions, size_t count) override
+        {
+            for (size_t i = 0; i < count; ++i)
+                m_tree.nodes[first + i].position = positions[i];
+            return !cancelled(m_options);
+        }
+
+        bool onSegments(size_t first, const int *indexPairs, size_t count) override
+        {
+            for (size_t i = 0; i < count; ++i)
+            {
+                m_tree.segments[first + i].indexA = indexPairs[2 * i];
+                m_tree.segments[first + i].indexB = indexPairs[2 * i + 1];
+            }
+            return !cancelled(m_options);
+        }
+
+        bool onRadii(size_t first, const float *radii, size_t count) override
+        {
+            for (size_t i = 0; i < count; ++i)
+                m_tree.segments[first + i].radius = radii[i];
+            return !cancelled(m_options);
+        }
+
+    private:
+        ArterialTree &m_tree;
+        const VtkReadOptions &m_options;
+    };
+}
+
+bool VtkReader::load(const std::string &filepath, ArterialTree &outTree, const VtkReadOptions &options)
+{
+    MappedFile file;
+    if (!file.open(filepath))
+    {
+        std::cerr << "[VTKReader] Falha ao abrir arquivo: " << filepath << std::endl;
+        return false;
+    }
+    // Entradas gzip/zlib são descomprimidas aos poucos e lidas em lotes
+    // direto na árvore de saída, sem uma cópia descomprimida inteira
+    auto parseInput = [&]() -> bool
+    {
+        if (Decompressor::detect(file.data(), file.size()) == Decompressor::Format::None)
+            return parse(file.data(), file.size(), filepath, outTree, options);
+        TreeBuilder builder(outTree, options);
+        if (!streamData(file.data(), file.size(), filepath, builder, options.strict) || cancelled(options))
+            return false;
+        // A leitura em lotes já conferiu os índices
+        return finishTree(filepath, outTree, false);
+    };
+    if (!options.useCache)
+        return parseInput();
+
+    // Cache válido (mesmo tamanho, mtime e hash da origem) dispensa o parsing.
+    // Para arquivos comprimidos o carimbo é do arquivo comprimido: um acerto
+    // dispensa também a descompressão.
+    std::string cachePath = TreeCache::sidecarPath(filepath);
+    SourceStamp stamp = TreeCache::stamp(filepath, file.data(), file.size());
+    if (TreeCache::load(cachePath, stamp, outTree))
+        return true;
+    if (!parseInput())
+        return false;
+    TreeCache::save(cachePath, stamp, outTree);
+    return true;
+}
+
+bool VtkReader::parse(const char *data, size_t size, const std::string &filepath,
+                      ArterialTree &outTree, const VtkReadOptions &options)
+{
+    // Cabeçalho legado: versão, título e então "ASCII" ou "BINARY"
+    Cursor header{data, data + size};
+    header.skipLine();
+    header.skipLine();
+    if (equalsNoCase(header.word(), "BINARY"))
+        return parseBinary(data, size, filepath, outTree, options);
+    return parseAscii(data, size, filepath, outTree, options);
+}
+
+bool VtkReader::finishTree(const std::string &filepath, ArterialTree &outTree, bool checkIndices)
+{
+    // Sem checagem por linha, ao menos garante em um único passe que
+    // nenhum índice aponta para fora do vetor de nós
+    if (checkIndices && !outTree.hasValidIndices())
+    {
+        std::cerr << "[VTKReader] Índice de nó fora do intervalo: " << filepath << std::endl;
+        return false;
+    }
+    outTree.normalize();
+    outTree.updateMidpoints();
+    return true;
+}
+
+bool VtkReader::parseAscii(const char *data, size_t size, const std::string &filepath,
+                           ArterialTree &outTree, const VtkReadOptions &options)
+{
+    const bool strict = options.strict;
+    const unsigned threads = ParallelUtils::threadCount(options.threads);
+    Cursor cur{data, data + size};
+    std::vector<ArterialNode> &nodes = outTree.nodes;
+    std::vector<ArterialSegment> &segments = outTree.segments;
+    nodes.clear();
+    segments.clear();
+    size_t numPoints = 0, numLines = 0, numLineIndices = 0;
+    bool foundPoints = false, foundLines = false, foundRadii = false;
+    bool radiusScalars = false;
+
+    while (true)
+    {
+        cur.skipSpaces();
+        if (cur.atEnd())
+            break;
+        if (cancelled(options))
+            return false;
+        // A primeira palavra da linha decide a seção (comparação sem caixa)
+        std::string_view keyword = cur.word();
+        if (equalsNoCase(keyword, "POINTS"))
+        {
+            if (!cur.inlineNumber(numPoints) || numPoints == 0)
+            {
+                std::cerr << "[VTKReader] Seção POINTS não contém pontos." << std::endl;
+                return false;
+            }
+            cur.skipLine();
+            // Cada ponto ocupa ao menos 6 bytes ("0 0 0\n"): evita alocar
+            // memória a partir de uma contagem corrompida
+            if (numPoints > cur.remaining() / 6)
+            {
+                std::cerr << "[VTKReader] Seção POINTS truncada: " << filepath << std::endl;
+                return false;
+            }
+            nodes.resize(numPoints);
+            // ArterialNode é exatamente um glm::vec3: o valor k é a coordenada k % 3 do nó k / 3
+            float *coords = reinterpret_cast<float *>(nodes.data());
+            SectionResult res = parseSection<float>(cur, numPoints * 3, strict, threads,
+                                                    [coords](size_t k, float v)
+                                                    {
+                                                        coords[k] = v;
+                                                        return VALUE_OK;
+                                                    });
+            if (res.error != VALUE_OK)
+            {
+                if (strict)
+                    std::cerr << "[VTKReader] Erro ao ler ponto no índice " << res.index / 3 << std::endl;
+                else
+                    std::cerr << "[VTKReader] Erro ao ler seção POINTS: " << filepath << std::endl;
+                return false;
+            }
+            foundPoints = true;
         }
-        if (state == RADII)
+        else if (equalsNoCase(keyword, "LINES"))
         {
-            float r;
-            std::stringstream scalarStream(line);
-            if (!(scalarStream >> r))
+            if (!cur.inlineNumber(numLines) || !cur.inlineNumber(numLineIndices) || numLines == 0)
             {
-                std::cerr << "[VTKReader] Erro ao ler raio no índice " << radiiRead << std::endl;
+                std::cerr << "[VTKReader] Seção LINES não contém linhas." << std::endl;
                 return false;
             }
-            if (radiiRead >= tempSegments.size())
+            cur.skipLine();
+            if (numLines > cur.remaining() / 6)
+            {
+                std::cerr << "[VTKReader] Seção LINES truncada: " << filepath << std::endl;
+                return false;
+            }
+            // Os segmentos são escritos diretamente na árvore de saída
+            segments.resize(numLines);
+            const int nodeCount = static_cast<int>(nodes.size());
+            ArterialSegment *segs = segments.data();
+            // Cada registro é [n, a, b]: o valor k é o campo k % 3 do segmento k / 3
+            SectionResult res = parseSection<int>(cur, numLines * 3, strict, threads,
+                                                  [segs, nodeCount, strict](size_t k, int v)
+                                                  {
+                                                      ArterialSegment &seg = segs[k / 3];
+                                                      switch (k % 3)
+                                                      {
+                                                      case 0:
+                                                          seg.radius = 0.0f;
+                                                          return (strict && v != 2) ? VALUE_CELL_SIZE : VALUE_OK;
+                                                      case 1:
+                                                          seg.indexA = v;
+                                                          break;
+                                                      default:
+                                                          seg.indexB = v;
+                                                          break;
+                                                      }
+                                                      return (strict && (v < 0 || v >= nodeCount)) ? VALUE_RANGE : VALUE_OK;
+                                                  });
+            if (res.error != VALUE_OK)
+            {
+                const size_t line = res.index / 3;
+                if (!strict)
+                    std::cerr << "[VTKReader] Erro ao ler seção LINES: " << filepath << std::endl;
+                else if (res.error == VALUE_CELL_SIZE)
+                    std::cerr << "[VTKReader] Apenas segmentos (n=2) são suportados (linha " << line << ")" << std::endl;
+                else if (res.error == VALUE_RANGE)
+                    std::cerr << "[VTKReader] Índice de nó fora do intervalo na linha " << line << std::endl;
+                else
+                    std::cerr << "[VTKReader] Erro ao ler conectividade de linha na linha " << line << std::endl;
+                return false;
+            }
+            foundLines = true;
+        }
+        // Aceitar tanto SCALARS quanto scalars, e tanto radius quanto raio
+        else if (equalsNoCase(keyword, "SCALARS"))
+        {
+            std::string_view name = cur.word();
+            radiusScalars = equalsNoCase(name, "radius") || equalsNoCase(name, "raio");
+        }
+        else if (radiusScalars && equalsNoCase(keyword, "LOOKUP_TABLE"))
+        {
+            // Próximas linhas contém os raios (valores escalares)
+            radiusScalars = false;
+            cur.skipLine();
+            if (segments.empty())
             {
                 std::cerr << "[VTKReader] Mais raios que segmentos!" << std::endl;
                 return false;
             }
-            tempSegments[radiiRead].radius = r;
-            radiiRead++;
-            if (radiiRead == tempSegments.size())
+            ArterialSegment *segs = segments.data();
+            SectionResult res = parseSection<float>(cur, segments.size(), strict, threads,
+                                                    [segs](size_t k, float v)
+                                                    {
+                                                        segs[k].radius = v;
+                                                        return VALUE_OK;
+                                                    });
+            if (res.error != VALUE_OK)
             {
-                foundRadii = true;
-                state = SEEK;
+                if (strict)
+                    std::cerr << "[VTKReader] Erro ao ler raio no índice " << res.index << std::endl;
+                else
+                    std::cerr << "[VTKReader] Erro ao ler seção de raios: " << filepath << std::endl;
+                return false;
             }
-            continue;
+            if (strict && res.extraValues)
+            {
+                std::cerr << "[VTKReader] Mais raios que segmentos!" << std::endl;
+                return false;
+            }
+            foundRadii = true;
         }
+        cur.skipLine();
     }
-    // Atribuição final e validação
+
+    if (cancelled(options))
+        return false;
+    // Validação final
     if (!foundPoints || !foundLines || !foundRadii)
     {
         std::cerr << "[VTKReader] Falha no parsing ou arquivo incompleto: " << filepath << std::endl;
         return false;
     }
-    if (tempSegments.size() != radiiRead)
+    // Com validação por linha os índices já foram conferidos
+    return finishTree(filepath, outTree, !strict);
+}
+
+bool VtkReader::parseBinary(const char *data, size_t size, const std::string &filepath,
+                            ArterialTree &outTree, const VtkReadOptions &options)
+{
+    const bool strict = options.strict;
+    std::vector<ArterialNode> &nodes = outTree.nodes;
+    std::vector<ArterialSegment> &segments = outTree.segments;
+    nodes.clear();
+    segments.clear();
+    BinaryLayout layout;
+    if (!locateBinary(StreamCursor(data, size), filepath, layout))
+        return false;
+
+    // No arquivo mapeado os blocos já foram conferidos e são lidos no lugar
+    nodes.resize(layout.numPoints);
+    // ArterialNode é exatamente um glm::vec3: decodificação direta no vetor de nós
+    decodeBinaryPoints(layout.points.take(layout.numPoints * 3 * layout.pointSize), layout.pointSize,
+                       layout.numPoints, reinterpret_cast<glm::vec3 *>(nodes.data()));
+    if (cancelled(options))
+        return false;
+
+    segments.resize(layout.numLines);
+    bool cellsOk = decodeBinaryCells(layout.lines.take(layout.numLines * 12), 0, layout.numLines,
+                                     static_cast<int>(layout.numPoints), strict,
+                                     [&segments](size_t i, int a, int b)
+                                     {
+                                         segments[i].indexA = a;
+                                         segments[i].indexB = b;
+                                     });
+    if (!cellsOk)
+        return false;
+    const char *radii = layout.radii.take(layout.numLines * layout.radiusSize);
+    for (size_t i = 0; i < layout.numLines; ++i)
+        decodeBinaryRadii(radii + i * layout.radiusSize, layout.radiusSize, 1, &segments[i].radius);
+    if (cancelled(options))
+        return false;
+    return finishTree(filepath, outTree, !strict);
+}
+
+bool VtkReader::stream(const std::string &filepath, VtkVisitor &visitor, const VtkReadOptions &options)
+{
+    MappedFile file;
+    if (!file.open(filepath))
     {
-        std::cerr << "[VTKReader] Número de raios (" << radiiRead << ") difere do número de segmentos (" << tempSegments.size() << ")" << std::endl;
+        std::cerr << "[VTKReader] Falha ao abrir arquivo: " << filepath << std::endl;
         return false;
     }
-    outTree.segments = tempSegments;
-    outTree.normalize();
-    for (auto &seg : outTree.segments)
+    return streamData(file.data(), file.size(), filepath, visitor, options.strict);
+}
+
+bool VtkReader::streamData(const char *data, size_t size, const std::string &filepath,
+                           VtkVisitor &visitor, bool strict)
+{
+    // Entradas gzip/zlib passam pelo inflate incremental: cada cursor mantém
+    // só a própria janela de texto descomprimido
+    StreamCursor cur(data, size);
+    if (Decompressor::detect(data, size) != Decompressor::Format::None)
     {
-        glm::vec3 pA = outTree.nodes[seg.indexA].position;
-        glm::vec3 pB = outTree.nodes[seg.indexB].position;
-        seg.midpoint = (pA + pB) / 2.0f;
+        InflateStream source;
+        if (!source.open(data, size, filepath))
+            return false;
+        cur = StreamCursor(std::move(source));
     }
-    return true;
+
+    // Cabeçalho legado: versão, título e então "ASCII" ou "BINARY"
+    StreamCursor header = cur;
+    header.skipLine();
+    header.skipLine();
+    if (equalsNoCase(header.word(), "BINARY"))
+        return streamBinary(std::move(cur), filepath, visitor, strict);
+    return streamAscii(std::move(cur), filepath, visitor, strict);
 }
@@ -0,0 +1,535 @@
+/*
+ * Universidade Federal de Ouro Preto - UFOP
+ * Departamento de Computação - DECOM
+ * Disciplina: BCC327 - Computação Gráfica (2025.2)
+ * Professor: Rafael Bonfim
+ * Trabalho Prático: Visualizador de Árvores Arteriais (CCO)
+ * Arquivo: VtpReader.cpp
+ * Autor: Mateus Honorato
+ * Data: Outubro/2026
+ * Descrição:
+ * Implementa o leitor de VTK XML PolyData (.vtp). Apenas o cabeçalho XML é
+ * interpretado como texto; cada DataArray "appended" é lido diretamente do
+ * bloco bruto a partir do seu offset, sem conversão valor a valor de texto.
+ */
+
+#include <cctype>
+#include <charconv>
+#include <cstring>
+#include <iostream>
+#include <string_view>
+#include <vector>
+#include "VtpReader.hpp"
+#include "MappedFile.hpp"
+#include "ByteOrder.hpp"
+
+namespace
+{
+    enum class DataType
+    {
+        Unknown,
+        Int8,
+        UInt8,
+        Int16,
+        UInt16,
+        Int32,
+        UInt32,
+        Int64,
+        UInt64,
+        Float32,
+        Float64
+    };
+
+    struct XmlAttribute
+    {
+        std::string_view name;
+        std::string_view value;
+    };
+
+    struct XmlTag
+    {
+        std::string_view name;
+        bool closing = false;     // </Tag>
+        bool selfClosing = false; // <Tag ... />
+        const char *end = nullptr; // posição logo após '>'
+        std::vector<XmlAttribute> attributes;
+
+        std::string_view attr(std::string_view key) const
+        {
+            for (const auto &a : attributes)
+            {
+                if (a.name == key)
+                    return a.value;
+            }
+            return std::string_view();
+        }
+    };
+
+    // Referência a um DataArray do cabeçalho XML
+    struct ArrayRef
+    {
+        bool found = false;
+        DataType type = DataType::Unknown;
+        size_t components = 1;
+        size_t offset = 0;
+        std::string_view format;
+    };
+
+    inline bool isSpace(char c)
+    {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+    }
+
+    bool equalsNoCase(std::string_view a, std::string_view b)
+    {
+        if (a.size() != b.size())
+            return false;
+        for (size_t i = 0; i < a.size(); ++i)
+        {
+            if (std::tolower(static_cast<unsigned char>(a[i])) != std::tolower(static_cast<unsigned char>(b[i])))
+                return false;
+        }
+        return true;
+    }
+
+    template <typename T>
+    bool parseNumber(std::string_view text, T &out)
+    {
+        auto res = std::from_chars(text.data(), text.data() + text.size(), out);
+        return res.ec == std::errc();
+    }
+
+    const char *findText(const char *p, const char *end, std::string_view needle)
+    {
+        while (p + needle.size() <= end)
+        {
+            const void *hit = std::memchr(p, needle[0], static_cast<size_t>(end - p));
+            if (!hit)
+                return nullptr;
+            const char *c = static_cast<const char *>(hit);
+            if (c + needle.size() <= end && std::memcmp(c, needle.data(), needle.size()) == 0)
+                return c;
+            p = c + 1;
+        }
+        return nullptr;
+    }
+
+    // Lê a próxima tag a partir de `p`, ignorando declarações e comentários.
+    // Tolerante o bastante para os arquivos gerados pelo VTK; não é um parser
+    // XML completo (sem entidades nem CDATA).
+    bool nextTag(const char *&p, const char *end, XmlTag &tag)
+    {
+        while (true)
+        {
+            const void *lt = std::memchr(p, '<', static_cast<size_t>(end - p));
+            if (!lt)
+                return false;
+            p = static_cast<const char *>(lt) + 1;
+            if (p < end && (*p == '?' || *p == '!'))
+            {
+                const char *close = (end - p >= 3 && std::memcmp(p, "!--", 3) == 0) ? findText(p, end, "-->") : findText(p, end, ">");
+                if (!close)
+                    return false;
+                p = close + 1;
+                continue;
+            }
+            break;
+        }
+        tag = XmlTag();
+        if (p < end && *p == '/')
+        {
+            tag.closing = true;
+            ++p;
+        }
+        const char *nameStart = p;
+        while (p < end && !isSpace(*p) && *p != '>' && *p != '/')
+            ++p;
+        tag.name = std::string_view(nameStart, static_cast<size_t>(p - nameStart));
+        while (p < end)
+        {
+            while (p < end && isSpace(*p))
+                ++p;
+            if (p >= end)
+                return false;
+            if (*p == '>')
+            {
+                tag.end = ++p;
+                return true;
+            }
+            if (*p == '/' && p + 1 < end && p[1] == '>')
+            {
+                tag.selfClosing = true;
+                p += 2;
+                tag.end = p;
+                return true;
+            }
+            const char *attrStart = p;
+            while (p < end && *p != '=' && !isSpace(*p) && *p != '>')
+                ++p;
+            XmlAttribute attr;
+            attr.name = std::string_view(attrStart, static_cast<size_t>(p - attrStart));
+            while (p < end && isSpace(*p))
+                ++p;
+            if (p < end && *p == '=')
+            {
+                ++p;
+                while (p < end && isSpace(*p))
+                    ++p;
+                if (p < end && (*p == '"' || *p == '\''))
+                {
+                    char quote = *p++;
+                    const void *close = std::memchr(p, quote, static_cast<size_t>(end - p));
+                    if (!close)
+                        return false;
+                    attr.value = std::string_view(p, static_cast<size_t>(static_cast<const char *>(close) - p));
+                    p = static_cast<const char *>(close) + 1;
+                }
+            }
+            tag.attributes.push_back(attr);
+        }
+        return false;
+    }
+
+    DataType parseType(std::string_view name)
+    {
+        if (name == "Int8")
+            return DataType::Int8;
+        if (name == "UInt8")
+            return DataType::UInt8;
+        if (name == "Int16")
+            return DataType::Int16;
+        if (name == "UInt16")
+            return DataType::UInt16;
+        if (name == "Int32")
+            return DataType::Int32;
+        if (name == "UInt32")
+            return DataType::UInt32;
+        if (name == "Int64")
+            return DataType::Int64;
+        if (name == "UInt64")
+            return DataType::UInt64;
+        if (name == "Float32")
+            return DataType::Float32;
+        if (name == "Float64")
+            return DataType::Float64;
+        return DataType::Unknown;
+    }
+
+    size_t typeSize(DataType t)
+    {
+        switch (t)
+        {
+        case DataType::Int8:
+        case DataType::UInt8:
+            return 1;
+        case DataType::Int16:
+        case DataType::UInt16:
+            return 2;
+        case DataType::Int32:
+        case DataType::UInt32:
+        case DataType::Float32:
+            return 4;
+        case DataType::Int64:
+        case DataType::UInt64:
+        case DataType::Float64:
+            return 8;
+        default:
+            return 0;
+        }
+    }
+
+    double loadReal(const char *p, DataType t, bool big)
+    {
+        switch (t)
+        {
+        case DataType::Float32:
+            return ByteOrder::load<float>(p, big);
+        case DataType::Float64:
+            return ByteOrder::load<double>(p, big);
+        case DataType::Int8:
+            return ByteOrder::load<int8_t>(p, big);
+        case DataType::UInt8:
+            return ByteOrder::load<uint8_t>(p, big);
+        case DataType::Int16:
+            return ByteOrder::load<int16_t>(p, big);
+        case DataType::UInt16:
+            return ByteOrder::load<uint16_t>(p, big);
+        case DataType::Int32:
+            return ByteOrder::load<int32_t>(p, big);
+        case DataType::UInt32:
+            return ByteOrder::load<uint32_t>(p, big);
+        case DataType::Int64:
+            return static_cast<double>(ByteOrder::load<int64_t>(p, big));
+        case DataType::UInt64:
+            return static_cast<double>(ByteOrder::load<uint64_t>(p, big));
+        default:
+            return 0.0;
+        }
+    }
+
+    int64_t loadInteger(const char *p, DataType t, bool big)
+    {
+        switch (t)
+        {
+        case DataType::Int32:
+            return ByteOrder::load<int32_t>(p, big);
+        case DataType::UInt32:
+            return ByteOrder::load<uint32_t>(p, big);
+        case DataType::Int64:
+            return ByteOrder::load<int64_t>(p, big);
+        case DataType::UInt64:
+            return static_cast<int64_t>(ByteOrder::load<uint64_t>(p, big));
+        default:
+            return static_cast<int64_t>(loadReal(p, t, big));
+        }
+    }
+
+    // Cabeçalho do VTKFile e início do bloco anexado
+    struct AppendedBlock
+    {
+        const char *base = nullptr;
+        const char *end = nullptr;
+        bool bigEndian = false;
+        bool header64 = false;
+    };
+
+    // Localiza os bytes de um array anexado: [tamanho em bytes][dados]
+    bool locateArray(const AppendedBlock &block, const ArrayRef &ref, size_t expectedCount,
+                     const char *label, const std::string &filepath, const char *&outData)
+    {
+        if (!ref.found)
+        {
+            std::cerr << "[VTPReader] Array " << label << " não encontrado: " << filepath << std::endl;
+            return false;
+        }
+        if (ref.format != "appended")
+        {
+            std::cerr << "[VTPReader] Array " << label << " com format=\"" << ref.format
+                      << "\" não suportado (apenas appended raw): " << filepath << std::endl;
+            return false;
+        }
+        const size_t size = typeSize(ref.type);
+        const size_t headerBytes = block.header64 ? 8 : 4;
+        if (size == 0)
+        {
+            std::cerr << "[VTPReader] Tipo do array " << label << " não suportado: " << filepath << std::endl;
+            return false;
+        }
+        if (ref.offset > static_cast<size_t>(block.end - block.base) ||
+            static_cast<size_t>(block.end - block.base) - ref.offset < headerBytes)
+        {
+            std::cerr << "[VTPReader] Offset do array " << label << " fora do arquivo: " << filepath << std::endl;
+            return false;
+        }
+        const char *p = block.base + ref.offset;
+        uint64_t numBytes = block.header64 ? ByteOrder::load<uint64_t>(p, block.bigEndian)
+                                           : ByteOrder::load<uint32_t>(p, block.bigEndian);
+        p += headerBytes;
+        const uint64_t expectedBytes = uint64_t(expectedCount) * ref.components * size;
+        if (numBytes != expectedBytes)
+        {
+            std::cerr << "[VTPReader] Array " << label << " com " << numBytes << " bytes, esperado "
+                      << expectedBytes << ": " << filepath << std::endl;
+            return false;
+        }
+        if (numBytes > static_cast<uint64_t>(block.end - p))
+        {
+            std::cerr << "[VTPReader] Array " << label << " truncado: " << filepath << std::endl;
+            return false;
+        }
+        outData = p;
+        return true;
+    }
+}
+
+bool VtpReader::load(const std::string &filepath, ArterialTree &outTree, const VtkReadOptions &options)
+{
+    MappedFile file;
+    if (!file.open(filepath))
+    {
+        std::cerr << "[VTPReader] Falha ao abrir arquivo: " << filepath << std::endl;
+        return false;
+    }
+    const bool strict = options.strict;
+    const char *p = file.data();
+    const char *end = file.data() + file.size();
+
+    AppendedBlock block;
+    block.end = end;
+    size_t numPoints = 0, numLines = 0;
+    int pieces = 0;
+    ArrayRef points, connectivity, offsets, radius;
+    std::string_view section;
+    XmlTag tag;
+
+    // 1. Cabeçalho XML até o início de <AppendedData>
+    while (!block.base && nextTag(p, end, tag))
+    {
+        if (tag.closing)
+        {
+            if (tag.name == section)
+                section = std::string_view();
+            continue;
+        }
+        if (tag.name == "VTKFile")
+        {
+            if (tag.attr("type") != "PolyData")
+            {
+                std::cerr << "[VTPReader] Apenas VTKFile type=\"PolyData\" é suportado: " << filepath << std::endl;
+                return false;
+            }
+            if (!tag.attr("compressor").empty())
+            {
+                std::cerr << "[VTPReader] Arquivos comprimidos (compressor) não são suportados: " << filepath << std::endl;
+                return false;
+            }
+            block.bigEndian = tag.attr("byte_order") == "BigEndian";
+            block.header64 = tag.attr("header_type") == "UInt64";
+        }
+        else if (tag.name == "Piece")
+        {
+            if (++pieces > 1)
+            {
+                std::cerr << "[VTPReader] Apenas uma Piece é suportada: " << filepath << std::endl;
+                return false;
+            }
+            parseNumber(tag.attr("NumberOfPoints"), numPoints);
+            parseNumber(tag.attr("NumberOfLines"), numLines);
+        }
+        else if (tag.name == "Points" || tag.name == "Lines" || tag.name == "CellData" || tag.name == "PointData" ||
+                 tag.name == "Verts" || tag.name == "Polys" || tag.name == "Strips")
+        {
+            if (!tag.selfClosing)
+                section = tag.name;
+        }
+        else if (tag.name == "DataArray")
+        {
+            ArrayRef ref;
+            ref.found = true;
+            ref.type = parseType(tag.attr("type"));
+            ref.format = tag.attr("format");
+            if (!parseNumber(tag.attr("NumberOfComponents"), ref.components))
+                ref.components = 1;
+            parseNumber(tag.attr("offset"), ref.offset);
+            std::string_view name = tag.attr("Name");
+            if (section == "Points")
+                points = ref;
+            else if (section == "Lines" && name == "connectivity")
+                connectivity = ref;
+            else if (section == "Lines" && name == "offsets")
+                offsets = ref;
+            // Aceitar tanto radius quanto raio
+            else if (section == "CellData" && ref.components == 1 &&
+                     (equalsNoCase(name, "radius") || equalsNoCase(name, "raio")))
+                radius = ref;
+        }
+        else if (tag.name == "AppendedData")
+        {
+            if (tag.attr("encoding") != "raw")
+            {
+                std::cerr << "[VTPReader] Apenas AppendedData encoding=\"raw\" é suportado: " << filepath << std::endl;
+                return false;
+            }
+            // Os dados começam logo após o marcador '_'
+            const void *marker = std::memchr(tag.end, '_', static_cast<size_t>(end - tag.end));
+            if (!marker)
+            {
+                std::cerr << "[VTPReader] Marcador '_' de AppendedData ausente: " << filepath << std::endl;
+                return false;
+            }
+            block.base = static_cast<const char *>(marker) + 1;
+        }
+    }
+    if (!block.base || numPoints == 0 || numLines == 0)
+    {
+        std::cerr << "[VTPReader] Falha no parsing ou arquivo incompleto: " << filepath << std::endl;
+        return false;
+    }
+    if (points.components != 3)
+    {
+        std::cerr << "[VTPReader] Points deve ter 3 componentes: " << filepath << std::endl;
+        return false;
+    }
+
+    // 2. Um acesso direto por array. A contagem de offsets pode ser
+    // NumberOfLines (VTK clássico) ou NumberOfLines + 1 (com zero inicial).
+    const char *pointData = nullptr, *connData = nullptr, *offsetData = nullptr, *radiusData = nullptr;
+    const size_t offsetsHeader = block.header64 ? 8 : 4;
+    size_t offsetCount = numLines;
+    if (offsets.found && offsets.format == "appended" && typeSize(offsets.type) > 0 &&
+        offsets.offset + offsetsHeader <= static_cast<size_t>(end - block.base))
+    {
+        const char *h = block.base + offsets.offset;
+        uint64_t numBytes = block.header64 ? ByteOrder::load<uint64_t>(h, block.bigEndian)
+                                           : ByteOrder::load<uint32_t>(h, block.bigEndian);
+        if (numBytes == uint64_t(numLines + 1) * typeSize(offsets.type))
+            offsetCount = numLines + 1;
+    }
+    if (!locateArray(block, points, numPoints, "Points", filepath, pointData) ||
+        !locateArray(block, offsets, offsetCount, "offsets", filepath, offsetData) ||
+        !locateArray(block, radius, numLines, "radius/raio", filepath, radiusData))
+        return false;
+    // Segmentos têm 2 índices por célula: o tamanho da conectividade é conhecido
+    if (!locateArray(block, connectivity, numLines * 2, "connectivity", filepath, connData))
+    {
+        std::cerr << "[VTPReader] Apenas segmentos (n=2) são suportados." << std::endl;
+        return false;
+    }
+
+    std::vector<ArterialNode> &nodes = outTree.nodes;
+    std::vector<ArterialSegment> &segments = outTree.segments;
+    nodes.resize(numPoints);
+    if (points.type == DataType::Float32)
+    {
+        ByteOrder::copy32(reinterpret_cast<char *>(nodes.data()), pointData, numPoints * 3, block.bigEndian);
+    }
+    else
+    {
+        const size_t stride = typeSize(points.type);
+        for (size_t i = 0; i < numPoints; ++i)
+        {
+            const char *src = pointData + i * 3 * stride;
+            nodes[i].position = glm::vec3(static_cast<float>(loadReal(src, points.type, block.bigEndian)),
+                                          static_cast<float>(loadReal(src + stride, points.type, block.bigEndian)),
+                                          static_cast<float>(loadReal(src + 2 * stride, points.type, block.bigEndian)));
+        }
+    }
+
+    segments.resize(numLines);
+    const size_t connStride = typeSize(connectivity.type);
+    const size_t offStride = typeSize(offsets.type);
+    const size_t radiusStride = typeSize(radius.type);
+    const int64_t nodeCount = static_cast<int64_t>(numPoints);
+    const size_t firstOffset = offsetCount - numLines; // 1 se há zero inicial
+    for (size_t i = 0; i < numLines; ++i)
+    {
+        int64_t a = loadInteger(connData + (2 * i) * connStride, connectivity.type, block.bigEndian);
+        int64_t b = loadInteger(connData + (2 * i + 1) * connStride, connectivity.type, block.bigEndian);
+        if (strict)
+        {
+            int64_t cellEnd = loadInteger(offsetData + (i + firstOffset) * offStride, offsets.type, block.bigEndian);
+            if (cellEnd != static_cast<int64_t>(2 * (i + 1)))
+            {
+                std::cerr << "[VTPReader] Apenas segmentos (n=2) são suportados. Célula " << i << " inválida." << std::endl;
+                return false;
+            }
+            if (a < 0 || b < 0 || a >= nodeCount || b >= nodeCount)
+            {
+                std::cerr << "[VTPReader] Índice de nó fora do intervalo na linha " << i << std::endl;
+                return false;
+            }
+        }
+        segments[i].indexA = static_cast<int>(a);
+        segments[i].indexB = static_cast<int>(b);
+        segments[i].radius = static_cast<float>(loadReal(radiusData + i * radiusStride, radius.type, block.bigEndian));
+    }
+
+    if (!strict && !outTree.hasValidIndices())
+    {
+        std::cerr << "[VTPReader] Índice de nó fora do intervalo: " << filepath << std::endl;
+        return false;
+    }
+    outTree.normalize();
+    outTree.updateMidpoints();
+    return true;
+}
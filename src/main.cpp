@@ -27,7 +27,6 @@
 
 #include "AnimationController.hpp"
 #include "MenuController.hpp"
-#include "ClippingUtils.hpp"
 #include "VtkReader.hpp"
 #include "Shader.hpp"
 #include "TreeRenderer.hpp"
@@ -35,7 +34,11 @@
 #include "ScreenshotUtils.hpp"
 #include "Camera.hpp"
 #include "PickingUtils.hpp"
+#include "SegmentBVH.hpp"
+#include "SimdUtils.hpp"
+#include "GpuPicker.hpp"
 #include "ArterialTree.hpp"
+#include "SequenceArchive.hpp"
 
 const int WINDOW_WIDTH = 1280;
 const int WINDOW_HEIGHT = 720;
@@ -55,7 +58,23 @@ struct AppContext
 {
     Camera camera;
     AnimationController animCtrl;
-    ArterialTree tree;
+    // Nunca nula: sem frame carregado aponta para uma árvore vazia
+    SharedTree tree = std::make_shared<const ArterialTree>();
+    // BVH dos segmentos para o picking e versão da árvore em que foi montada
+    SegmentBVH treeBVH;
+    size_t bvhTreeVersion = static_cast<size_t>(-1);
+    // Segmentos em SoA para a varredura linear e a versão em que foram copiados
+    SegmentSoA treeSoA;
+    size_t soaTreeVersion = static_cast<size_t>(-1);
+    // Picking pelo buffer de IDs: consulta do último clique (para o picking por raio
+    // se a árvore mudar antes da leitura) e versão da árvore desenhada na passada de IDs
+    GpuPicker picker;
+    PickQuery pendingPick;
+    size_t pickTreeVersion = 0;
+    // Segmento de cada nó (o que chega nele, ou o primeiro que sai da raiz)
+    // para os IDs das esferas de junção, montado no primeiro uso por versão
+    std::vector<int> nodeSegment;
+    size_t nodeSegmentVersion = static_cast<size_t>(-1);
     SceneContext sceneCtx;
     glm::mat4 view;
     glm::mat4 projection;
@@ -66,6 +85,54 @@ void framebuffer_size_callback(GLFWwindow *window, int width, int height)
     glViewport(0, 0, width, height);
 }
 
+// Picking por raio na CPU. No primeiro uso após uma troca de topologia a
+// varredura linear em lote (SIMD) evita reconstruir a BVH por SAH; a partir
+// do segundo clique na mesma árvore a BVH é montada. Com a mesma topologia
+// as caixas da BVH são só reajustadas.
+int pickOnCPU(AppContext &context, const PickQuery &query)
+{
+    const size_t version = context.animCtrl.getTreeVersion();
+    float closestDist;
+    if (context.treeBVH.getSegmentCount() != context.tree->segments.size() && context.soaTreeVersion != version)
+    {
+        context.treeSoA.assign(*context.tree);
+        context.soaTreeVersion = version;
+        return PickingUtils::pickSegment(context.treeSoA, query, closestDist);
+    }
+    if (context.bvhTreeVersion != version ||
+        context.treeBVH.getSegmentCount() != context.tree->segments.size())
+    {
+        context.treeBVH.update(*context.tree);
+        context.bvhTreeVersion = version;
+    }
+    return context.treeBVH.pick(*context.tree, query, closestDist);
+}
+
+// Segmento selecionado ao clicar na esfera de junção do nó `node`
+int segmentAtNode(AppContext &context, int node)
+{
+    const size_t version = context.animCtrl.getTreeVersion();
+    if (context.nodeSegmentVersion != version || context.nodeSegment.size() != context.tree->nodes.size())
+    {
+        context.nodeSegment.assign(context.tree->nodes.size(), -1);
+        for (size_t i = 0; i < context.tree->segments.size(); ++i)
+        {
+            const ArterialSegment &seg = context.tree->segments[i];
+            context.nodeSegment[seg.indexB] = static_cast<int>(i);
+        }
+        for (size_t i = 0; i < context.tree->segments.size(); ++i)
+        {
+            const ArterialSegment &seg = context.tree->segments[i];
+            if (context.nodeSegment[seg.indexA] < 0)
+                context.nodeSegment[seg.indexA] = static_cast<int>(i);
+        }
+        context.nodeSegmentVersion = version;
+    }
+    if (node < 0 || node >= static_cast<int>(context.nodeSegment.size()))
+        return -1;
+    return context.nodeSegment[node];
+}
+
 void mouse_button_callback(GLFWwindow *window, int button, int action, int mods)
 {
     if (ImGui::GetCurrentContext() != nullptr && ImGui::GetIO().WantCaptureMouse)
@@ -108,40 +175,21 @@ void mouse_button_callback(GLFWwindow *window, int button, int action, int mods)
             model = glm::rotate(model, glm::radians(ROTATION_ANGLE), glm::vec3(1.0f, 0.0f, 0.0f));
         }
 
-        int closestIdx = -1;
-        float closestDist = std::numeric_limits<float>::max();
-
-        for (size_t i = 0; i < context->tree.segments.size(); ++i)
-        {
-            const auto &seg = context->tree.segments[i];
-            glm::vec3 a = context->tree.nodes[seg.indexA].position;
-            glm::vec3 b = context->tree.nodes[seg.indexB].position;
-            // Clipping check
-            if (context->animCtrl.clipping.enabled)
-            {
-                glm::vec3 tempA = a, tempB = b;
-                if (!ClippingUtils::clipSegment(tempA, tempB, context->animCtrl.clipping.min, context->animCtrl.clipping.max))
-                {
-                    continue;
-                }
-            }
-            glm::vec4 localA = glm::vec4(a, 1.0f);
-            glm::vec4 localB = glm::vec4(b, 1.0f);
-            glm::vec3 worldA = glm::vec3(model * localA);
-            glm::vec3 worldB = glm::vec3(model * localB);
-            float hitRadius = std::max(seg.radius * context->animCtrl.radiusScale * HIT_RADIUS_MULTIPLIER, MIN_HIT_RADIUS);
-            float outDist;
-            if (PickingUtils::rayIntersectsSegment(rayOrigin, rayDir, worldA, worldB, hitRadius, outDist))
-            {
-                if (outDist < closestDist)
-                {
-                    closestDist = outDist;
-                    closestIdx = static_cast<int>(i);
-                }
-            }
-        }
-
-        context->animCtrl.selectSegment(closestIdx, context->tree);
+        // 5. Raio levado uma vez ao espaço do modelo (rotação: distâncias preservadas)
+        glm::mat4 invModel = glm::inverse(model);
+        PickQuery query;
+        query.rayOrigin = glm::vec3(invModel * glm::vec4(rayOrigin, 1.0f));
+        query.rayDir = glm::normalize(glm::vec3(invModel * glm::vec4(rayDir, 0.0f)));
+        query.radiusFactor = context->animCtrl.radiusScale * HIT_RADIUS_MULTIPLIER;
+        query.minRadius = MIN_HIT_RADIUS;
+        query.clipEnabled = context->animCtrl.clipping.enabled;
+        query.clipMin = context->animCtrl.clipping.min;
+        query.clipMax = context->animCtrl.clipping.max;
+
+        // 6. Pixel lido do buffer de IDs no próximo quadro; a consulta fica
+        // guardada para o picking por raio
+        context->pendingPick = query;
+        context->picker.request(static_cast<int>(mouseX_FB), static_cast<int>(mouseY_FB));
     }
 
     // Se Ctrl está pressionado E botão esquerdo, trata como pan (mão)
@@ -187,6 +235,14 @@ int main(int argc, char *argv[])
     std::string exePath = argv[0];
     std::string exeDir = exePath.substr(0, exePath.find_last_of("/\\"));
 
+    // Modo de linha de comando: "--pack <pasta> [saida.ats]" empacota os
+    // frames de um dataset em um arquivo de sequência e encerra
+    if (argc >= 3 && std::string(argv[1]) == "--pack")
+    {
+        std::string output = (argc >= 4) ? argv[3] : SequenceArchive::defaultPath(argv[2]);
+        return SequenceArchive::pack(argv[2], output) ? 0 : 1;
+    }
+
     // Inicialização do GLFW
     if (!glfwInit())
         return -1;
@@ -236,11 +292,16 @@ int main(int argc, char *argv[])
     // Constrói os caminhos para os shaders
     std::string vertexShaderPath = exeDir + "/../shaders/vertex.glsl";
     std::string fragmentShaderPath = exeDir + "/../shaders/fragment.glsl";
+    std::string instancedVertexShaderPath = exeDir + "/../shaders/instanced_vertex.glsl";
+    std::string impostorVertexShaderPath = exeDir + "/../shaders/impostor_vertex.glsl";
+    std::string impostorFragmentShaderPath = exeDir + "/../shaders/impostor_fragment.glsl";
     std::string lineVertexShaderPath = exeDir + "/../shaders/line_vertex.glsl";
     std::string lineFragmentShaderPath = exeDir + "/../shaders/line_fragment.glsl";
 
     // Objetos do Domínio
     Shader shader(vertexShaderPath.c_str(), fragmentShaderPath.c_str());
+    Shader instancedShader(instancedVertexShaderPath.c_str(), fragmentShaderPath.c_str());
+    Shader impostorShader(impostorVertexShaderPath.c_str(), impostorFragmentShaderPath.c_str());
     Shader lineShader(lineVertexShaderPath.c_str(), lineFragmentShaderPath.c_str());
     TreeRenderer renderer;
     MenuController menuCtrl;
@@ -268,7 +329,28 @@ int main(int argc, char *argv[])
         float deltaTime = static_cast<float>(currentTime - lastTime);
         lastTime = currentTime;
         processInput(window);
+
+        // Resultado do buffer de IDs do clique anterior: esferas de junção
+        // (IDs <= -2 - nó) selecionam o segmento que chega ao nó. Só uma
+        // árvore trocada desde a passada de IDs cai no picking por raio.
+        int pickedID;
+        if (context.picker.poll(pickedID))
+        {
+            if (context.pickTreeVersion != context.animCtrl.getTreeVersion() ||
+                pickedID >= static_cast<int>(context.tree->segments.size()))
+                pickedID = pickOnCPU(context, context.pendingPick);
+            else if (pickedID < GpuPicker::NO_ID)
+                pickedID = segmentAtNode(context, -2 - pickedID);
+            context.animCtrl.selectSegment(pickedID, *context.tree);
+        }
+
+        renderer.setRenderPath(static_cast<RenderPath>(context.animCtrl.renderPath));
+        renderer.setVertexLayout(static_cast<VertexLayout>(context.animCtrl.vertexLayout));
+        renderer.setSweptTubes(context.animCtrl.sweptTubes);
+        renderer.setOptimizeIndexOrder(context.animCtrl.optimizeIndexOrder);
         context.animCtrl.update(deltaTime, context.tree, renderer);
+        // O renderizador volta ao formato completo se os IDs não cabem em 24 bits
+        context.animCtrl.vertexLayout = static_cast<int>(renderer.getVertexLayout());
 
         // Atualiza razão de aspecto e matrizes de view/projection
         int width, height;
@@ -292,42 +374,52 @@ int main(int argc, char *argv[])
         bool isPanning = glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_RIGHT) == GLFW_PRESS;
         glfwSetCursor(window, isPanning ? handCursor : arrowCursor);
 
+        glm::mat4 model = glm::mat4(1.0f);
+        if (context.animCtrl.getCurrentMode() == AnimationController::Mode3D)
+        {
+            model = glm::rotate(model, glm::radians(ROTATION_ANGLE), glm::vec3(1.0f, 0.0f, 0.0f));
+        }
+
+        // Escala de raio aplicada nos shaders (sem regerar a malha); entra também no LOD
+        renderer.setRadiusScale(context.animCtrl.radiusScale);
+        renderer.setColormap(static_cast<Colormap>(context.animCtrl.colormap));
+        // Caixa de corte aplicada nos shaders: mover os controles não regera a malha
+        renderer.setClipBox(context.animCtrl.clipping.enabled, context.animCtrl.clipping.min,
+                            context.animCtrl.clipping.max, context.animCtrl.clipping.caps);
+
+        // Nível de detalhe conforme a câmera: níveis trocados pedem atualização da malha
+        renderer.setLodOptions(context.animCtrl.lodEnabled, static_cast<size_t>(context.animCtrl.triangleBudget) * 1000);
+        if (renderer.updateLod(context.view, context.projection, model, height))
+            context.animCtrl.m_visualDirty = true;
+
         // Atualização visual quando necessário
-        if (context.animCtrl.isVisualDirty())
+        // Durante a leitura progressiva a malha é montada pelo AnimationController
+        if (context.animCtrl.isVisualDirty() && !context.animCtrl.isLoading())
         {
             if (context.animCtrl.getCurrentMode() == AnimationController::ModeWireframe)
             {
-                renderer.initWireframe(context.tree.nodes, context.tree.segments,
-                                       context.animCtrl.clipping.enabled,
-                                       context.animCtrl.clipping.min,
-                                       context.animCtrl.clipping.max);
+                renderer.initWireframe(*context.tree);
             }
             else
             {
-                renderer.init(context.tree,
-                              context.animCtrl.radiusScale,
-                              context.animCtrl.showSpheres,
-                              context.animCtrl.clipping.enabled,
-                              context.animCtrl.clipping.min,
-                              context.animCtrl.clipping.max);
+                renderer.init(*context.tree, context.animCtrl.showSpheres);
             }
             context.animCtrl.resetVisualDirty();
         }
 
         // Configurar uniforms do shader e desenhar a cena
-        glm::mat4 model = glm::mat4(1.0f);
-        if (context.animCtrl.getCurrentMode() == AnimationController::Mode3D)
-        {
-            model = glm::rotate(model, glm::radians(ROTATION_ANGLE), glm::vec3(1.0f, 0.0f, 0.0f));
-        }
-        shader.use();
-        shader.setMat4("model", model);
-        shader.setMat4("view", context.view);
-        shader.setMat4("projection", context.projection);
-        shader.setVec3("lightPos", glm::vec3(context.animCtrl.lightPos[0], context.animCtrl.lightPos[1], context.animCtrl.lightPos[2]));
-        shader.setVec3("viewPos", context.camera.getPosition());
-        shader.setFloat("alpha", context.animCtrl.transparency);
-        shader.setInt("lightingMode", context.animCtrl.lightingMode);
+        // Malhas na CPU, instâncias expandidas no vertex shader ou impostores
+        Shader &meshShader = (renderer.getRenderPath() == RenderPath::Impostor)    ? impostorShader
+                             : (renderer.getRenderPath() == RenderPath::Instanced) ? instancedShader
+                                                                                    : shader;
+        meshShader.use();
+        meshShader.setMat4("model", model);
+        meshShader.setMat4("view", context.view);
+        meshShader.setMat4("projection", context.projection);
+        meshShader.setVec3("lightPos", glm::vec3(context.animCtrl.lightPos[0], context.animCtrl.lightPos[1], context.animCtrl.lightPos[2]));
+        meshShader.setVec3("viewPos", context.camera.getPosition());
+        meshShader.setFloat("alpha", context.animCtrl.transparency);
+        meshShader.setInt("lightingMode", context.animCtrl.lightingMode);
 
         if (context.animCtrl.getCurrentMode() == AnimationController::ModeWireframe)
         {
@@ -341,7 +433,19 @@ int main(int argc, char *argv[])
         }
         else
         {
-            renderer.draw(shader, context.view, context.projection, model, context.animCtrl.getSelectedSegment());
+            renderer.draw(meshShader, context.view, context.projection, model, context.animCtrl.getSelectedSegment());
+        }
+
+        // Passada de IDs sob demanda: os mesmos draws (e VAOs) no framebuffer
+        // inteiro, lido de volta no próximo quadro
+        if (context.picker.needsPass() && context.picker.beginPass(width, height))
+        {
+            if (context.animCtrl.getCurrentMode() == AnimationController::ModeWireframe)
+                renderer.drawWireframe(lineShader, context.view, context.projection, model, context.animCtrl.lineWidth, context.animCtrl.getSelectedSegment());
+            else
+                renderer.draw(meshShader, context.view, context.projection, model, context.animCtrl.getSelectedSegment());
+            context.picker.endPass();
+            context.pickTreeVersion = context.animCtrl.getTreeVersion();
         }
 
         // Desenhar grade (grid) e gizmo